@@ -29,8 +29,10 @@
 #endif
 %attribute(carto::BinaryData, std::size_t, Size, size)
 %ignore carto::BinaryData::BinaryData(std::vector<unsigned char>);
+%ignore carto::BinaryData::BinaryData(const unsigned char*, std::size_t, const std::shared_ptr<const void>&);
 %ignore carto::BinaryData::empty;
 %ignore carto::BinaryData::getDataPtr;
+%ignore carto::BinaryData::slice;
 %ignore carto::BinaryData::operator==;
 %ignore carto::BinaryData::operator!=;
 %ignore carto::BinaryData::hash;
@@ -19,6 +19,10 @@
 
 !polymorphic_shared_ptr(carto::MemoryCacheTileDataSource, datasources.MemoryCacheTileDataSource)
 
+%attribute(carto::MemoryCacheTileDataSource, carto::MemoryCachePolicy::MemoryCachePolicy, CachePolicy, getCachePolicy)
+%attribute(carto::MemoryCacheTileDataSource, std::size_t, HitCount, getHitCount)
+%attribute(carto::MemoryCacheTileDataSource, std::size_t, MissCount, getMissCount)
+%attribute(carto::MemoryCacheTileDataSource, std::size_t, EvictionCount, getEvictionCount)
 %std_exceptions(carto::MemoryCacheTileDataSource::MemoryCacheTileDataSource)
 
 %feature("director") carto::MemoryCacheTileDataSource;
@@ -23,6 +23,7 @@
 !polymorphic_shared_ptr(carto::PackageManagerTileDataSource, datasources.PackageManagerTileDataSource)
 
 !attributestring_polymorphic(carto::PackageManagerTileDataSource, packagemanager.PackageManager, PackageManager, getPackageManager)
+%attribute(carto::PackageManagerTileDataSource, std::size_t, TileCacheCapacity, getTileCacheCapacity, setTileCacheCapacity)
 %std_exceptions(carto::PackageManagerTileDataSource::PackageManagerTileDataSource)
 
 %feature("director") carto::PackageManagerTileDataSource;
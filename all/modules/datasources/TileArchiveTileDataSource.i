@@ -0,0 +1,37 @@
+#ifndef _TILEARCHIVETILEDATASOURCE_I
+#define _TILEARCHIVETILEDATASOURCE_I
+
+%module(directors="1") TileArchiveTileDataSource
+
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+!proxy_imports(carto::TileArchiveTileDataSource, core.MapTile, core.MapBounds, core.StringMap, datasources.TileDataSource, datasources.MBTilesTileDataSource, datasources.components.TileData)
+
+%{
+#include "datasources/TileArchiveTileDataSource.h"
+#include "components/Exceptions.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <std_string.i>
+%include <cartoswig.i>
+
+%import "core/MapTile.i"
+%import "core/StringMap.i"
+%import "datasources/TileDataSource.i"
+%import "datasources/MBTilesTileDataSource.i"
+%import "datasources/components/TileData.i"
+
+!polymorphic_shared_ptr(carto::TileArchiveTileDataSource, datasources.TileArchiveTileDataSource)
+
+%std_io_exceptions(carto::TileArchiveTileDataSource::TileArchiveTileDataSource)
+%std_io_exceptions(carto::TileArchiveTileDataSource::ConvertMBTiles)
+
+%feature("director") carto::TileArchiveTileDataSource;
+
+%include "datasources/TileArchiveTileDataSource.h"
+
+#endif
+
+#endif
@@ -22,6 +22,7 @@
 
 %attribute(carto::RasterTileLayer, std::size_t, TextureCacheCapacity, getTextureCacheCapacity, setTextureCacheCapacity)
 %attribute(carto::RasterTileLayer, carto::RasterTileFilterMode::RasterTileFilterMode, TileFilterMode, getTileFilterMode, setTileFilterMode)
+%attribute(carto::RasterTileLayer, bool, OverzoomTextureSharing, isOverzoomTextureSharing, setOverzoomTextureSharing)
 !attributestring_polymorphic(carto::RasterTileLayer, layers.RasterTileEventListener, RasterTileEventListener, getRasterTileEventListener, setRasterTileEventListener)
 %std_exceptions(carto::RasterTileLayer::RasterTileLayer)
 %ignore carto::RasterTileLayer::FetchTask;
@@ -3,6 +3,8 @@
 
 %module(directors="1") TileLoadListener
 
+!proxy_imports(carto::TileLoadListener, core.MapTile)
+
 %{
 #include "layers/TileLoadListener.h"	
 #include <memory>
@@ -10,6 +12,9 @@
 
 %include <std_string.i>
 %include <std_shared_ptr.i>
+%include <cartoswig.i>
+
+%import "core/MapTile.i"
 
 !polymorphic_shared_ptr(carto::TileLoadListener, layers.TileLoadListener)
 
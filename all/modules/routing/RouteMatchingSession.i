@@ -0,0 +1,45 @@
+#ifndef _ROUTEMATCHINGSESSION_I
+#define _ROUTEMATCHINGSESSION_I
+
+#pragma SWIG nowarn=325
+
+%module RouteMatchingSession
+
+#ifdef _CARTO_ROUTING_SUPPORT
+
+!proxy_imports(carto::RouteMatchingSession, core.MapPos, core.MapPosVector, core.Variant, projections.Projection, routing.RoutingService, routing.RouteMatchingResult, routing.RouteMatchingEdge, routing.RouteMatchingEdgeVector)
+
+%{
+#include "routing/RouteMatchingSession.h"
+#include "components/Exceptions.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <std_string.i>
+%include <std_vector.i>
+%include <cartoswig.i>
+
+%import "core/MapPos.i"
+%import "core/Variant.i"
+%import "projections/Projection.i"
+%import "routing/RoutingService.i"
+%import "routing/RouteMatchingResult.i"
+%import "routing/RouteMatchingEdge.i"
+
+!shared_ptr(carto::RouteMatchingSession, routing.RouteMatchingSession)
+
+%attributestring(carto::RouteMatchingSession, std::shared_ptr<carto::RoutingService>, RoutingService, getRoutingService)
+%attributestring(carto::RouteMatchingSession, std::shared_ptr<carto::Projection>, Projection, getProjection)
+%attribute(carto::RouteMatchingSession, float, Accuracy, getAccuracy)
+%attributestring(carto::RouteMatchingSession, std::shared_ptr<carto::RouteMatchingResult>, PendingResult, getPendingResult)
+%std_exceptions(carto::RouteMatchingSession::RouteMatchingSession)
+%std_io_exceptions(carto::RouteMatchingSession::addPoints)
+%std_io_exceptions(carto::RouteMatchingSession::finish)
+!standard_equals(carto::RouteMatchingSession);
+
+%include "routing/RouteMatchingSession.h"
+
+#endif
+
+#endif
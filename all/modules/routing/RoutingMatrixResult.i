@@ -0,0 +1,38 @@
+#ifndef _ROUTINGMATRIXRESULT_I
+#define _ROUTINGMATRIXRESULT_I
+
+#pragma SWIG nowarn=325
+
+%module RoutingMatrixResult
+
+#ifdef _CARTO_ROUTING_SUPPORT
+
+!proxy_imports(carto::RoutingMatrixResult, projections.Projection)
+
+%{
+#include "routing/RoutingMatrixResult.h"
+#include "components/Exceptions.h"
+#include <memory>
+%}
+
+%include <std_shared_ptr.i>
+%include <cartoswig.i>
+
+%import "projections/Projection.i"
+
+!shared_ptr(carto::RoutingMatrixResult, routing.RoutingMatrixResult)
+
+%attributestring(carto::RoutingMatrixResult, std::shared_ptr<carto::Projection>, Projection, getProjection)
+%attribute(carto::RoutingMatrixResult, int, SourceCount, getSourceCount)
+%attribute(carto::RoutingMatrixResult, int, TargetCount, getTargetCount)
+%ignore carto::RoutingMatrixResult::RoutingMatrixResult;
+%std_exceptions(carto::RoutingMatrixResult::getDistance)
+%std_exceptions(carto::RoutingMatrixResult::getTime)
+!standard_equals(carto::RoutingMatrixResult);
+!custom_tostring(carto::RoutingMatrixResult);
+
+%include "routing/RoutingMatrixResult.h"
+
+#endif
+
+#endif
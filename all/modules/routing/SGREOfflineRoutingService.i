@@ -5,7 +5,7 @@
 
 #if defined(_CARTO_ROUTING_SUPPORT) && defined(_CARTO_OFFLINE_SUPPORT)
 
-!proxy_imports(carto::SGREOfflineRoutingService, core.Variant, geometry.FeatureCollection, projections.Projection, routing.RoutingService, routing.RoutingRequest, routing.RoutingResult, routing.RouteMatchingRequest, routing.RouteMatchingResult)
+!proxy_imports(carto::SGREOfflineRoutingService, core.Variant, geometry.FeatureCollection, projections.Projection, routing.RoutingService, routing.RoutingRequest, routing.RoutingResult, routing.RouteMatchingRequest, routing.RouteMatchingResult, routing.RoutingMatrixRequest, routing.RoutingMatrixResult)
 
 %{
 #include "routing/SGREOfflineRoutingService.h"
@@ -32,6 +32,8 @@
 %attribute(carto::VectorTileSearchService, int, MinZoom, getMinZoom, setMinZoom)
 %attribute(carto::VectorTileSearchService, int, MaxZoom, getMaxZoom, setMaxZoom)
 %attribute(carto::VectorTileSearchService, int, MaxResults, getMaxResults, setMaxResults)
+%attribute(carto::VectorTileSearchService, int, ThreadCount, getThreadCount, setThreadCount)
+%attribute(carto::VectorTileSearchService, int, TileCacheSize, getTileCacheSize, setTileCacheSize)
 %std_exceptions(carto::VectorTileSearchService::VectorTileSearchService)
 %std_exceptions(carto::VectorTileSearchService::findFeatures)
 
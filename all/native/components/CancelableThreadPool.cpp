@@ -2,6 +2,7 @@
 #include "utils/Log.h"
 #include "utils/ThreadUtils.h"
 
+#include <algorithm>
 #include <limits>
 
 namespace carto {
@@ -9,47 +10,55 @@ namespace carto {
     CancelableThreadPool::CancelableThreadPool() :
         _poolSize(0),
         _taskCount(0),
+        _nextQueueIndex(0),
         _stop(false),
-        _taskRecords(),
+        _taskQueues(),
         _workers(),
         _threads(),
-        _condition(),
-        _mutex()
+        _mutex(),
+        _idleWorkers(),
+        _idleMutex()
     {
+        std::size_t queueCount = std::min(std::max(static_cast<std::size_t>(std::thread::hardware_concurrency()), MIN_QUEUE_COUNT), MAX_QUEUE_COUNT);
+        for (std::size_t i = 0; i < queueCount; i++) {
+            _taskQueues.emplace_back(new TaskQueue());
+        }
     }
-    
+
     CancelableThreadPool::~CancelableThreadPool() {
     }
-        
+
     void CancelableThreadPool::deinit() {
-        {
-            std::lock_guard<std::mutex> lock(_mutex);
-            _stop = true;
-        }
-        
+        _stop = true;
+
         cancelAll();
-        
+
         {
-            std::lock_guard<std::mutex> lock(_mutex);
-            _condition.notify_all();
+            std::lock_guard<std::mutex> lock(_idleMutex);
+            _idleWorkers.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const std::shared_ptr<TaskWorker>& worker : _workers) {
+            worker->wakeUp(IDLE_PRIORITY);
         }
-        
+
         for (std::thread& thread : _threads) {
             thread.detach();
         }
-        
+
         _workers.clear();
         _threads.clear();
     }
-    
+
     int CancelableThreadPool::getPoolSize() const {
         std::lock_guard<std::mutex> lock(_mutex);
         return _poolSize;
     }
-    
+
     void CancelableThreadPool::setPoolSize(int poolSize) {
         std::lock_guard<std::mutex> lock(_mutex);
-        
+
         if (_stop) {
             return;
         }
@@ -57,73 +66,97 @@ namespace carto {
         // Note: won't have an immediate effect
         _poolSize = poolSize;
     }
-    
+
     void CancelableThreadPool::execute(std::shared_ptr<CancelableTask> task) {
         execute(task, DEFAULT_PRIORITY);
     }
-    
+
     void CancelableThreadPool::execute(std::shared_ptr<CancelableTask> task, int priority) {
-        if (!task->isCanceled()) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            
-            if (_stop) {
-                return;
+        if (task->isCanceled() || _stop) {
+            return;
+        }
+
+        // IDLE_PRIORITY is reserved for marking empty queues and idle workers
+        priority = std::max(priority, IDLE_PRIORITY + 1);
+
+        // Push task to the next queue in round-robin order. Workers will steal it from there if needed.
+        std::size_t queueIndex = _nextQueueIndex++ % _taskQueues.size();
+        _taskQueues[queueIndex]->push(TaskRecord(task, priority, _taskCount++));
+
+        // Wake up a single idle worker, if any. Note that this must happen after the task is pushed, otherwise the wakeup may be lost.
+        std::shared_ptr<TaskWorker> idleWorker;
+        {
+            std::lock_guard<std::mutex> lock(_idleMutex);
+            if (!_idleWorkers.empty()) {
+                idleWorker = _idleWorkers.back();
+                _idleWorkers.pop_back();
             }
-    
-            // Push task to queue, increase global task count
-            _taskRecords.push(TaskRecord(task, priority, _taskCount));
-            _taskCount++;
-
-            // Check if we need to create a new worker.
-            bool createWorker = static_cast<int>(_threads.size()) < _poolSize;
-            if (!createWorker) {
-                bool foundIdleWorker = false;
-                for (std::shared_ptr<TaskWorker>& worker : _workers) {
-                    if (worker->_priority == std::numeric_limits<int>::min()) {
-                        worker->_priority = priority;
-                        foundIdleWorker = true;
-                        break;
-                    }
-                }
-                if (!foundIdleWorker) {
-                    createWorker = true;
-                    for (std::shared_ptr<TaskWorker>& worker : _workers) {
-                        if (worker->_priority == priority) {
-                            createWorker = false;
-                            break;
-                        }
-                    }
-                }
+        }
+        if (idleWorker) {
+            idleWorker->wakeUp(priority);
+            return;
+        }
+
+        // All workers are busy. Check if we need to create a new worker.
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_stop) {
+            return;
+        }
+
+        bool createWorker = true;
+        for (const std::shared_ptr<TaskWorker>& worker : _workers) {
+            if (worker->_priority == IDLE_PRIORITY) {
+                // Worker is about to go idle and will pick up the task
+                createWorker = false;
+                break;
             }
-            if (createWorker) {
-                Log::Debugf("CancelableThreadPool: Adding worker to the pool (size %d)", (int)_workers.size());
-                _workers.push_back(std::make_shared<TaskWorker>(shared_from_this(), priority));
-                _threads.push_back(std::thread(&TaskWorker::operator(), _workers.back()));
+        }
+        if (createWorker && static_cast<int>(_threads.size()) >= _poolSize) {
+            // Pool is full, create an extra worker only if no worker is processing tasks with the same priority
+            for (const std::shared_ptr<TaskWorker>& worker : _workers) {
+                if (worker->_priority == priority) {
+                    createWorker = false;
+                    break;
+                }
             }
-    
-            // If there are any waiting threads, notify all of them as not all workers may be able to process the task
-            _condition.notify_all();
+        }
+        if (createWorker) {
+            this->createWorker(priority);
         }
     }
-    
+
+    void CancelableThreadPool::reschedule(const std::vector<std::shared_ptr<CancelableTask> >& tasks) {
+        if (tasks.empty()) {
+            return;
+        }
+
+        // Assign new sequence numbers to the tasks, preserving the given order. Tasks that are not queued are ignored.
+        long long sequence = _taskCount.fetch_add(static_cast<long long>(tasks.size()));
+        std::unordered_map<const CancelableTask*, long long> sequences;
+        sequences.reserve(tasks.size());
+        for (const std::shared_ptr<CancelableTask>& task : tasks) {
+            sequences.emplace(task.get(), sequence++);
+        }
+
+        for (const std::unique_ptr<TaskQueue>& taskQueue : _taskQueues) {
+            taskQueue->reschedule(sequences);
+        }
+    }
+
     void CancelableThreadPool::cancelAll() {
-        std::lock_guard<std::mutex> lock(_mutex);
-        
-        std::size_t taskRecordsSize = _taskRecords.size();
-        for (std::size_t i = 0; i < taskRecordsSize; i++) {
-            const std::shared_ptr<CancelableTask>& task = _taskRecords.top()._task;
-            task->cancel();
-            _taskRecords.pop();
+        for (const std::unique_ptr<TaskQueue>& taskQueue : _taskQueues) {
+            taskQueue->cancelAll();
         }
     }
-    
+
     CancelableThreadPool::TaskRecord::TaskRecord(std::shared_ptr<CancelableTask> task, int priority, long long sequence) :
         _task(task),
         _priority(priority),
         _sequence(sequence)
     {
     }
-    
+
     bool CancelableThreadPool::TaskRecord::operator <(const TaskRecord& taskRecord) const {
         // Tasks are sorted according to their priority and then their sequence
         if (_priority != taskRecord._priority) {
@@ -131,81 +164,217 @@ namespace carto {
         }
         return _sequence > taskRecord._sequence;
     }
-    
-    CancelableThreadPool::TaskWorker::TaskWorker(const std::shared_ptr<CancelableThreadPool>& threadPool, int priority) :
+
+    CancelableThreadPool::TaskQueue::TaskQueue() :
+        _taskRecords(),
+        _compactionSize(MIN_COMPACTION_SIZE),
+        _topPriority(IDLE_PRIORITY),
+        _topSequence(0),
+        _mutex()
+    {
+    }
+
+    void CancelableThreadPool::TaskQueue::push(TaskRecord&& taskRecord) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // If the queue has grown too large, drop canceled tasks. Amortized cost is constant per task.
+        if (_taskRecords.size() >= _compactionSize) {
+            compact();
+            _compactionSize = std::max(MIN_COMPACTION_SIZE, _taskRecords.size() * 2);
+        }
+
+        _taskRecords.push_back(std::move(taskRecord));
+        std::push_heap(_taskRecords.begin(), _taskRecords.end());
+        updateTop();
+    }
+
+    bool CancelableThreadPool::TaskQueue::pop(std::shared_ptr<CancelableTask>& task, int& priority, int minPriority) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Return the next highest priority task that is not canceled. Assuming it matches the requested priority.
+        while (!_taskRecords.empty() && _taskRecords.front()._priority >= minPriority) {
+            std::pop_heap(_taskRecords.begin(), _taskRecords.end());
+            TaskRecord taskRecord = std::move(_taskRecords.back());
+            _taskRecords.pop_back();
+            if (!taskRecord._task->isCanceled()) {
+                task = std::move(taskRecord._task);
+                priority = taskRecord._priority;
+                updateTop();
+                return true;
+            }
+        }
+        updateTop();
+        return false;
+    }
+
+    void CancelableThreadPool::TaskQueue::reschedule(const std::unordered_map<const CancelableTask*, long long>& sequences) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        bool updated = false;
+        for (TaskRecord& taskRecord : _taskRecords) {
+            auto it = sequences.find(taskRecord._task.get());
+            if (it != sequences.end()) {
+                taskRecord._sequence = it->second;
+                updated = true;
+            }
+        }
+        if (updated) {
+            std::make_heap(_taskRecords.begin(), _taskRecords.end());
+            updateTop();
+        }
+    }
+
+    void CancelableThreadPool::TaskQueue::cancelAll() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const TaskRecord& taskRecord : _taskRecords) {
+            taskRecord._task->cancel();
+        }
+        _taskRecords.clear();
+        _compactionSize = MIN_COMPACTION_SIZE;
+        updateTop();
+    }
+
+    void CancelableThreadPool::TaskQueue::compact() {
+        auto it = std::remove_if(_taskRecords.begin(), _taskRecords.end(), [](const TaskRecord& taskRecord) {
+            return taskRecord._task->isCanceled();
+        });
+        if (it != _taskRecords.end()) {
+            _taskRecords.erase(it, _taskRecords.end());
+            std::make_heap(_taskRecords.begin(), _taskRecords.end());
+        }
+    }
+
+    void CancelableThreadPool::TaskQueue::updateTop() {
+        if (_taskRecords.empty()) {
+            _topPriority = IDLE_PRIORITY;
+        } else {
+            _topSequence = _taskRecords.front()._sequence;
+            _topPriority = _taskRecords.front()._priority;
+        }
+    }
+
+    CancelableThreadPool::TaskWorker::TaskWorker(const std::shared_ptr<CancelableThreadPool>& threadPool, std::size_t queueIndex, int priority) :
         _threadPool(threadPool),
-        _priority(priority)
+        _queueIndex(queueIndex),
+        _priority(priority),
+        _signaled(false),
+        _condition(),
+        _mutex()
     {
     }
-        
+
     void CancelableThreadPool::TaskWorker::operator ()() {
         ThreadUtils::SetThreadPriority(ThreadPriority::MINIMUM);
         while (true) {
             auto threadPool = _threadPool.lock();
-            if (!threadPool) {
+            if (!threadPool || threadPool->_stop) {
                 return;
             }
 
-            // If there are no tasks, wait until notified or exit thread if interrupted
-            {
-                std::unique_lock<std::mutex> lock(threadPool->_mutex);
-                if (threadPool->_stop) {
-                    return;
-                }
-                
-                if (threadPool->_taskRecords.size() == 0) {
-                    threadPool->_condition.wait(lock);
-                }
+            // Request another task, execute it if it's not null. Otherwise wait until notified or exit thread if interrupted
+            std::shared_ptr<CancelableTask> task;
+            if (threadPool->getNextTask(task, *this)) {
+                task->operator ()();
+            } else if (!threadPool->waitForTask(*this)) {
+                return;
             }
-    
-            // Request another task, execute it if it's not null
-            while (true) {
-                std::shared_ptr<CancelableTask> task;
-                int priority = DEFAULT_PRIORITY;
-                {
-                    std::lock_guard<std::mutex> lock(threadPool->_mutex);
-                    if (threadPool->_stop) {
-                        return;
-                    }
-                    priority = _priority;
+        }
+    }
+
+    void CancelableThreadPool::TaskWorker::wakeUp(int priority) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _priority = priority;
+            _signaled = true;
+        }
+        _condition.notify_one();
+    }
+
+    void CancelableThreadPool::TaskWorker::sleep() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _condition.wait(lock, [this] { return _signaled; });
+        _signaled = false;
+    }
+
+    bool CancelableThreadPool::getNextTask(std::shared_ptr<CancelableTask>& task, TaskWorker& worker) {
+        while (true) {
+            int minPriority = worker._priority;
+
+            // Find the queue with the highest priority task. Use cached queue tops, so that no locks are needed.
+            // In case of equal tasks, prefer worker's own queue.
+            std::size_t bestIndex = _taskQueues.size();
+            int bestPriority = IDLE_PRIORITY;
+            long long bestSequence = std::numeric_limits<long long>::max();
+            for (std::size_t i = 0; i < _taskQueues.size(); i++) {
+                std::size_t index = (worker._queueIndex + i) % _taskQueues.size();
+                int priority = _taskQueues[index]->_topPriority;
+                if (priority == IDLE_PRIORITY || priority < minPriority) {
+                    continue;
                 }
-                
-                if (threadPool->getNextTask(task, priority)) {
-                    task->operator ()();
-                } else {
-                    if (threadPool->shouldTerminateWorker(*this)) {
-                        return;
-                    }
-
-                    // Mark worker as inactive
-                    std::lock_guard<std::mutex> lock(threadPool->_mutex);
-                    _priority = std::numeric_limits<int>::min();
-                    break;
+                long long sequence = _taskQueues[index]->_topSequence;
+                if (priority > bestPriority || (priority == bestPriority && sequence < bestSequence)) {
+                    bestIndex = index;
+                    bestPriority = priority;
+                    bestSequence = sequence;
                 }
+            }
+            if (bestIndex == _taskQueues.size()) {
+                return false;
+            }
 
-                // Check for interruption
-                std::this_thread::yield();
+            // Try to pop the task. If another worker was faster, retry.
+            int priority = IDLE_PRIORITY;
+            if (_taskQueues[bestIndex]->pop(task, priority, minPriority)) {
+                if (minPriority == IDLE_PRIORITY) {
+                    worker._priority = priority;
+                }
+                return true;
             }
         }
     }
-    
-    bool CancelableThreadPool::getNextTask(std::shared_ptr<CancelableTask>& task, int priority) {
-        std::lock_guard<std::mutex> lock(_mutex);
-    
-        // Return the next highest priority task from the task queue. Assuming it matches the requested priority.
-        if (_taskRecords.size() > 0) {
-            if (_taskRecords.top()._priority >= priority) {
-                task = _taskRecords.top()._task;
-                _taskRecords.pop();
+
+    bool CancelableThreadPool::waitForTask(TaskWorker& worker) {
+        if (shouldTerminateWorker(worker)) {
+            return false;
+        }
+
+        // Mark worker as inactive and spin for a while, as tasks tend to arrive in bursts
+        worker._priority = IDLE_PRIORITY;
+        for (int i = 0; i < IDLE_SPIN_COUNT; i++) {
+            if (_stop) {
+                return false;
+            }
+            if (hasTask(IDLE_PRIORITY)) {
                 return true;
             }
+            std::this_thread::yield();
         }
-        return false;
+
+        // Register as idle worker. Check the queues once more after registering, as a task may have been pushed meanwhile.
+        std::shared_ptr<TaskWorker> workerPtr = worker.shared_from_this();
+        {
+            std::lock_guard<std::mutex> lock(_idleMutex);
+            if (_stop) {
+                return false;
+            }
+            _idleWorkers.push_back(workerPtr);
+        }
+        if (hasTask(IDLE_PRIORITY)) {
+            std::lock_guard<std::mutex> lock(_idleMutex);
+            auto it = std::find(_idleWorkers.begin(), _idleWorkers.end(), workerPtr);
+            if (it != _idleWorkers.end()) {
+                _idleWorkers.erase(it);
+                return true;
+            }
+            // Already claimed by another thread, wait for the signal
+        }
+
+        worker.sleep();
+        return !_stop;
     }
-    
+
     bool CancelableThreadPool::shouldTerminateWorker(TaskWorker& worker) {
         std::lock_guard<std::mutex> lock(_mutex);
-        
+
         if (_stop) {
             return true;
         }
@@ -229,6 +398,33 @@ namespace carto {
         return false;
     }
 
+    bool CancelableThreadPool::hasTask(int priority) const {
+        for (const std::unique_ptr<TaskQueue>& taskQueue : _taskQueues) {
+            int topPriority = taskQueue->_topPriority;
+            if (topPriority != IDLE_PRIORITY && topPriority >= priority) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void CancelableThreadPool::createWorker(int priority) {
+        Log::Debugf("CancelableThreadPool: Adding worker to the pool (size %d)", (int)_workers.size());
+        std::size_t queueIndex = _workers.size() % _taskQueues.size();
+        _workers.push_back(std::make_shared<TaskWorker>(shared_from_this(), queueIndex, priority));
+        _threads.push_back(std::thread(&TaskWorker::operator(), _workers.back()));
+    }
+
     const int CancelableThreadPool::DEFAULT_PRIORITY = 0;
-    
+
+    const int CancelableThreadPool::IDLE_PRIORITY = std::numeric_limits<int>::min();
+
+    const int CancelableThreadPool::IDLE_SPIN_COUNT = 64;
+
+    const std::size_t CancelableThreadPool::MIN_COMPACTION_SIZE = 64;
+
+    const std::size_t CancelableThreadPool::MIN_QUEUE_COUNT = 2;
+
+    const std::size_t CancelableThreadPool::MAX_QUEUE_COUNT = 8;
+
 }
@@ -10,65 +10,117 @@
 #include "components/CancelableTask.h"
 #include "components/ThreadWorker.h"
 
+#include <atomic>
 #include <condition_variable>
 #include <memory>
-#include <queue>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace carto {
 
+    /**
+     * Priority based thread pool for cancelable tasks.
+     * Tasks are distributed between per-worker queues, idle workers steal the highest priority task
+     * from other queues. Submitting a task wakes up at most a single idle worker.
+     * Canceled tasks are never executed, they are dropped from the queues lazily.
+     * Queued tasks can be rescheduled, in which case they are ordered as if they were submitted again.
+     */
     class CancelableThreadPool : public std::enable_shared_from_this<CancelableThreadPool> {
     public:
         CancelableThreadPool();
         virtual ~CancelableThreadPool();
         void deinit();
-    
+
         int getPoolSize() const;
         void setPoolSize(int threadCount);
-    
+
         void execute(std::shared_ptr<CancelableTask>);
         void execute(std::shared_ptr<CancelableTask>, int priority);
-    
+
+        void reschedule(const std::vector<std::shared_ptr<CancelableTask> >& tasks);
+
         void cancelAll();
-        
+
     private:
         struct TaskRecord {
             TaskRecord(std::shared_ptr<CancelableTask> task, int priority, long long sequence);
-    
+
             bool operator <(const TaskRecord& taskRecord) const;
-    
+
             std::shared_ptr<CancelableTask> _task;
             int _priority;
             long long _sequence;
         };
-    
-        struct TaskWorker : public ThreadWorker {
-            TaskWorker(const std::shared_ptr<CancelableThreadPool>& threadPool, int priority);
-    
+
+        struct TaskQueue {
+            TaskQueue();
+
+            void push(TaskRecord&& taskRecord);
+            bool pop(std::shared_ptr<CancelableTask>& task, int& priority, int minPriority);
+            void reschedule(const std::unordered_map<const CancelableTask*, long long>& sequences);
+            void cancelAll();
+
+            std::vector<TaskRecord> _taskRecords; // binary heap, guarded by _mutex
+            std::size_t _compactionSize; // guarded by _mutex
+            std::atomic<int> _topPriority; // cached priority of the top record, IDLE_PRIORITY if empty
+            std::atomic<long long> _topSequence; // cached sequence of the top record
+            std::mutex _mutex;
+
+        private:
+            void compact();
+            void updateTop();
+        };
+
+        struct TaskWorker : public ThreadWorker, public std::enable_shared_from_this<TaskWorker> {
+            TaskWorker(const std::shared_ptr<CancelableThreadPool>& threadPool, std::size_t queueIndex, int priority);
+
             void operator()();
-    
+
+            void wakeUp(int priority);
+            void sleep();
+
             std::weak_ptr<CancelableThreadPool> _threadPool;
-            int _priority; // mutable, guarded by _threadPool->_mutex
+            std::size_t _queueIndex;
+            std::atomic<int> _priority; // minimum priority of the tasks the worker accepts, IDLE_PRIORITY if idle
+            bool _signaled; // guarded by _mutex
+            std::condition_variable _condition;
+            std::mutex _mutex;
         };
-    
-        bool getNextTask(std::shared_ptr<CancelableTask>& task, int priority);
-    
+
+        bool getNextTask(std::shared_ptr<CancelableTask>& task, TaskWorker& worker);
+
+        bool waitForTask(TaskWorker& worker);
+
         bool shouldTerminateWorker(TaskWorker& worker);
-    
+
+        bool hasTask(int priority) const;
+
+        void createWorker(int priority);
+
         static const int DEFAULT_PRIORITY;
-    
-        int _poolSize;
-        long long _taskCount;
-        bool _stop;
-    
-        std::priority_queue<TaskRecord> _taskRecords;
-        std::vector<std::shared_ptr<TaskWorker> > _workers;
-        std::vector<std::thread> _threads;
-    
-        std::condition_variable _condition;
+        static const int IDLE_PRIORITY;
+        static const int IDLE_SPIN_COUNT;
+        static const std::size_t MIN_COMPACTION_SIZE;
+        static const std::size_t MIN_QUEUE_COUNT;
+        static const std::size_t MAX_QUEUE_COUNT;
+
+        int _poolSize; // guarded by _mutex
+        std::atomic<long long> _taskCount;
+        std::atomic<std::size_t> _nextQueueIndex;
+        std::atomic<bool> _stop;
+
+        std::vector<std::unique_ptr<TaskQueue> > _taskQueues; // fixed after construction
+
+        std::vector<std::shared_ptr<TaskWorker> > _workers; // guarded by _mutex
+        std::vector<std::thread> _threads; // guarded by _mutex
         mutable std::mutex _mutex;
+
+        std::vector<std::shared_ptr<TaskWorker> > _idleWorkers; // guarded by _idleMutex
+        std::mutex _idleMutex;
     };
-    
+
 }
 
 #endif
@@ -1,46 +1,78 @@
 #include "BinaryData.h"
+#include "components/Exceptions.h"
 
 #include <algorithm>
+#include <atomic>
 #include <sstream>
 
 namespace carto {
 
     BinaryData::BinaryData() :
-        _dataPtr(std::make_shared<std::vector<unsigned char> >())
+        _dataPtr(std::make_shared<std::vector<unsigned char> >()),
+        _owner(_dataPtr),
+        _data(_dataPtr->data()),
+        _size(0)
     {
     }
 
     BinaryData::BinaryData(std::vector<unsigned char> data) :
-        _dataPtr(std::make_shared<std::vector<unsigned char> >(std::move(data)))
+        _dataPtr(std::make_shared<std::vector<unsigned char> >(std::move(data))),
+        _owner(_dataPtr),
+        _data(_dataPtr->data()),
+        _size(_dataPtr->size())
     {
     }
     
     BinaryData::BinaryData(const unsigned char* data, std::size_t size) :
-        _dataPtr(std::make_shared<std::vector<unsigned char> >(data, data + size))
+        _dataPtr(std::make_shared<std::vector<unsigned char> >(data, data + size)),
+        _owner(_dataPtr),
+        _data(_dataPtr->data()),
+        _size(_dataPtr->size())
+    {
+    }
+
+    BinaryData::BinaryData(const unsigned char* data, std::size_t size, const std::shared_ptr<const void>& owner) :
+        _dataPtr(),
+        _owner(owner),
+        _data(data),
+        _size(size)
     {
     }
     
     bool BinaryData::empty() const {
-        return _dataPtr->empty();
+        return _size == 0;
     }
 
     std::size_t BinaryData::size() const {
-        return _dataPtr->size();
+        return _size;
     }
 
     const unsigned char* BinaryData::data() const {
-        return _dataPtr->data();
+        return _data;
     }
 
     std::shared_ptr<std::vector<unsigned char> > BinaryData::getDataPtr() const {
-        return _dataPtr;
+        std::shared_ptr<std::vector<unsigned char> > dataPtr = std::atomic_load(&_dataPtr);
+        if (!dataPtr) {
+            // Concurrent calls may create multiple copies, but all of them have the same contents
+            dataPtr = std::make_shared<std::vector<unsigned char> >(_data, _data + _size);
+            std::atomic_store(&_dataPtr, dataPtr);
+        }
+        return dataPtr;
+    }
+
+    std::shared_ptr<BinaryData> BinaryData::slice(std::size_t offset, std::size_t size) const {
+        if (offset > _size || size > _size - offset) {
+            throw OutOfRangeException("Slice out of range");
+        }
+        return std::make_shared<BinaryData>(_data + offset, size, _owner);
     }
 
     bool BinaryData::operator ==(const BinaryData& data) const {
-        if (_dataPtr->size() != data._dataPtr->size()) {
+        if (_size != data._size) {
             return false;
         }
-        return std::equal(_dataPtr->begin(), _dataPtr->end(), data._dataPtr->begin());
+        return std::equal(_data, _data + _size, data._data);
     }
 
     bool BinaryData::operator !=(const BinaryData& data) const {
@@ -48,12 +80,12 @@ namespace carto {
     }
 
     int BinaryData::hash() const {
-        return static_cast<int>(std::hash<std::string>()(std::string(reinterpret_cast<const char*>(_dataPtr->data()), _dataPtr->size())));
+        return static_cast<int>(std::hash<std::string>()(std::string(reinterpret_cast<const char*>(_data), _size)));
     }
 
     std::string BinaryData::toString() const {
         std::stringstream ss;
-        ss << "BinaryData [size=" << _dataPtr->size() << "]";
+        ss << "BinaryData [size=" << _size << "]";
         return ss.str();
     }
 
@@ -16,6 +16,7 @@ namespace carto {
     
     /**
      * A wrapper class for binary data (Blob).
+     * The data is either owned by the object or is a read-only view into memory owned by another object.
      */
     class BinaryData {
     public:
@@ -34,6 +35,14 @@ namespace carto {
          * @param size The size of the data in bytes.
          */
         BinaryData(const unsigned char* dataPtr, std::size_t size);
+        /**
+         * Constructs a BinaryData view of existing memory without copying it.
+         * The memory is kept valid by holding a reference to the owner object.
+         * @param dataPtr The raw pointer to the data.
+         * @param size The size of the data in bytes.
+         * @param owner The object owning the memory.
+         */
+        BinaryData(const unsigned char* dataPtr, std::size_t size, const std::shared_ptr<const void>& owner);
 
         /**
          * Check if the data is empty (size is 0).
@@ -52,9 +61,20 @@ namespace carto {
         const unsigned char* data() const;
         /**
          * Returns the pointer to data byte vector.
+         * If the object is a view, the data is copied to a vector on first call.
+         * The returned vector must not be modified.
          * @return The pointer to data byte vector.
          */
         std::shared_ptr<std::vector<unsigned char> > getDataPtr() const;
+
+        /**
+         * Returns a view of part of the data. The data is not copied, the returned object shares the memory with this object.
+         * @param offset The offset of the slice in bytes.
+         * @param size The size of the slice in bytes.
+         * @return The slice of the data.
+         * @throws std::out_of_range If the slice is not fully contained in the data.
+         */
+        std::shared_ptr<BinaryData> slice(std::size_t offset, std::size_t size) const;
         
         /**
          * Checks for equality between this and another blob.
@@ -82,7 +102,10 @@ namespace carto {
         std::string toString() const;
 
     private:
-        std::shared_ptr<std::vector<unsigned char> > _dataPtr;
+        mutable std::shared_ptr<std::vector<unsigned char> > _dataPtr; // created lazily for views, accessed atomically
+        std::shared_ptr<const void> _owner; // keeps the memory alive, same as _dataPtr for owned data
+        const unsigned char* _data;
+        std::size_t _size;
     };
 
 }
@@ -10,6 +10,7 @@
 #include "geometry/GeometrySimplifier.h"
 #include "geometry/utils/KDTreeSpatialIndex.h"
 #include "geometry/utils/NullSpatialIndex.h"
+#include "geometry/utils/RTreeSpatialIndex.h"
 #include "projections/Projection.h"
 #include "projections/PlanarProjectionSurface.h"
 #include "styles/PointStyle.h"
@@ -44,6 +45,8 @@ namespace carto {
         _geometrySimplifier(),
         _spatialIndex(std::make_shared<NullSpatialIndex<std::shared_ptr<VectorElement> > >()),
         _spatialIndexType(LocalSpatialIndexType::LOCAL_SPATIAL_INDEX_TYPE_NULL),
+        _projectionSurface(),
+        _simplificationCache(),
         _elementId(0),
         _mutex()
     {
@@ -54,6 +57,8 @@ namespace carto {
         _geometrySimplifier(),
         _spatialIndex(std::make_shared<NullSpatialIndex<std::shared_ptr<VectorElement> > >()),
         _spatialIndexType(spatialIndexType),
+        _projectionSurface(),
+        _simplificationCache(),
         _elementId(0),
         _mutex()
     {
@@ -68,6 +73,7 @@ namespace carto {
             std::lock_guard<std::mutex> lock(_mutex);
             removedElements = _spatialIndex->getAll();
             _spatialIndex->clear();
+            _simplificationCache.clear();
         }
         if (!removedElements.empty()) {
             notifyElementsRemoved(removedElements);
@@ -98,8 +104,8 @@ namespace carto {
             std::unordered_set<std::shared_ptr<VectorElement> > oldElementSet(oldElements.begin(), oldElements.end());
             
             // Rebuild spatial index, create list of added and removed elements
-            _spatialIndex->clear();
-            _spatialIndex->reserve(elements.size());
+            std::vector<std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> > > records;
+            records.reserve(elements.size());
             for (const std::shared_ptr<VectorElement>& element : elements) {
                 cglib::bbox3<double> bounds = calculateElementBounds(element);
                 auto it = oldElementSet.find(element);
@@ -110,7 +116,12 @@ namespace carto {
                     elementsAdded.push_back(element);
                     _elementId++;
                 }
-                _spatialIndex->insert(bounds, element);
+                records.emplace_back(bounds, element);
+            }
+            _spatialIndex->clear();
+            _spatialIndex->insertAll(records);
+            for (const std::shared_ptr<VectorElement>& element : oldElementSet) {
+                _simplificationCache.remove(element->getId());
             }
             std::copy(oldElementSet.begin(), oldElementSet.end(), std::back_inserter(elementsRemoved));
         }
@@ -152,13 +163,15 @@ namespace carto {
 
         {
             std::lock_guard<std::mutex> lock(_mutex);
-            _spatialIndex->reserve(_spatialIndex->size() + elements.size());
+            std::vector<std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> > > records;
+            records.reserve(elements.size());
             for (const std::shared_ptr<VectorElement>& element : elements) {
                 element->setId(_elementId);
                 cglib::bbox3<double> bounds = calculateElementBounds(element);
-                _spatialIndex->insert(bounds, element);
+                records.emplace_back(bounds, element);
                 _elementId++;
             }
+            _spatialIndex->insertAll(records);
         }
         if (!elements.empty()) {
             notifyElementsAdded(elements);
@@ -180,6 +193,9 @@ namespace carto {
             std::lock_guard<std::mutex> lock(_mutex);
             cglib::bbox3<double> bounds = calculateElementBounds(element);
             removed = _spatialIndex->remove(bounds, element);
+            if (removed) {
+                _simplificationCache.remove(element->getId());
+            }
         }
         if (removed) {
             notifyElementRemoved(element);
@@ -205,6 +221,7 @@ namespace carto {
             for (const std::shared_ptr<VectorElement>& element : elements) {
                 cglib::bbox3<double> bounds = calculateElementBounds(element);
                 if (_spatialIndex->remove(bounds, element)) {
+                    _simplificationCache.remove(element->getId());
                     removedElements.push_back(element);
                 }
             }
@@ -224,6 +241,7 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_mutex);
             _geometrySimplifier = simplifier;
+            _simplificationCache.clear();
         }
         notifyElementsChanged();
     }
@@ -283,15 +301,18 @@ namespace carto {
 
         // Check if we need to rebuild the underlying spatial index
         std::shared_ptr<ProjectionSurface> projectionSurface = cullState->getViewState().getProjectionSurface();
-        if (_spatialIndexType == LocalSpatialIndexType::LOCAL_SPATIAL_INDEX_TYPE_KDTREE) {
+        if (_spatialIndexType != LocalSpatialIndexType::LOCAL_SPATIAL_INDEX_TYPE_NULL) {
             if (projectionSurface != _projectionSurface) {
                 std::vector<std::shared_ptr<VectorElement> > elements = _spatialIndex->getAll();
                 _projectionSurface = projectionSurface;
-                _spatialIndex = std::make_shared<KDTreeSpatialIndex<std::shared_ptr<VectorElement> > >();
+                std::vector<std::pair<cglib::bbox3<double>, std::shared_ptr<VectorElement> > > records;
+                records.reserve(elements.size());
                 for (const std::shared_ptr<VectorElement>& element : elements) {
                     cglib::bbox3<double> bounds = calculateElementBounds(element);
-                    _spatialIndex->insert(bounds, element);
+                    records.emplace_back(bounds, element);
                 }
+                _spatialIndex = createSpatialIndex();
+                _spatialIndex->insertAll(records);
             }
         } else {
             _projectionSurface = projectionSurface;
@@ -301,13 +322,18 @@ namespace carto {
         std::vector<std::shared_ptr<VectorElement> > elements = _spatialIndex->query(cullState->getViewState().getFrustum());
         
         // If geometry simplifier is specified, create new vector elements with simplified geometry
+        // Simplified elements are cached per quantized scale level, thus panning does not require resimplification
         if (_geometrySimplifier) {
-            float simplifierScale = cullState->getViewState().estimateWorldPixelMeasure();
+            float simplifierScale = _simplificationCache.update(cullState->getViewState().estimateWorldPixelMeasure(), _projectionSurface);
 
             std::vector<std::shared_ptr<VectorElement> > simplifiedElements;
             simplifiedElements.reserve(elements.size());
             for (const std::shared_ptr<VectorElement>& element : elements) {
-                std::shared_ptr<VectorElement> simplifiedElement = simplifyElement(element, simplifierScale);
+                std::shared_ptr<VectorElement> simplifiedElement;
+                if (!_simplificationCache.get(element->getId(), simplifiedElement)) {
+                    simplifiedElement = simplifyElement(element, simplifierScale);
+                    _simplificationCache.put(element->getId(), simplifiedElement);
+                }
                 if (simplifiedElement) {
                     simplifiedElements.emplace_back(std::move(simplifiedElement));
                 }
@@ -321,6 +347,7 @@ namespace carto {
     void LocalVectorDataSource::notifyElementChanged(const std::shared_ptr<VectorElement>& element) {
         {
             std::lock_guard<std::mutex> lock(_mutex);
+            _simplificationCache.remove(element->getId());
             if (!(std::dynamic_pointer_cast<NullSpatialIndex<std::shared_ptr<VectorElement>>>(_spatialIndex))) {
                 _spatialIndex->remove(element);
                 cglib::bbox3<double> bounds = calculateElementBounds(element);
@@ -431,6 +458,17 @@ namespace carto {
         return simplifiedElement;
     }
 
+    std::shared_ptr<SpatialIndex<std::shared_ptr<VectorElement> > > LocalVectorDataSource::createSpatialIndex() const {
+        switch (_spatialIndexType) {
+        case LocalSpatialIndexType::LOCAL_SPATIAL_INDEX_TYPE_KDTREE:
+            return std::make_shared<KDTreeSpatialIndex<std::shared_ptr<VectorElement> > >();
+        case LocalSpatialIndexType::LOCAL_SPATIAL_INDEX_TYPE_RTREE:
+            return std::make_shared<RTreeSpatialIndex<std::shared_ptr<VectorElement> > >();
+        default:
+            return std::make_shared<NullSpatialIndex<std::shared_ptr<VectorElement> > >();
+        }
+    }
+
     cglib::bbox3<double> LocalVectorDataSource::calculateElementBounds(const std::shared_ptr<VectorElement>& element) const {
         if (!_projectionSurface) {
             return cglib::bbox3<double>(cglib::vec3<double>(0, 0, 0), cglib::vec3<double>(0, 0, 0));
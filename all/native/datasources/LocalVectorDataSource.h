@@ -9,6 +9,7 @@
 
 #include "datasources/VectorDataSource.h"
 #include "geometry/utils/SpatialIndex.h"
+#include "geometry/utils/SimplificationCache.h"
 
 #include <memory>
 
@@ -27,7 +28,13 @@ namespace carto {
             /**
              * K-d tree index, element culling is exact and fast.
              */
-            LOCAL_SPATIAL_INDEX_TYPE_KDTREE
+            LOCAL_SPATIAL_INDEX_TYPE_KDTREE,
+
+            /**
+             * Packed R-tree index, element culling is exact. Faster to build and query than k-d tree
+             * when large number of elements is added at once, for example using setAll or addAll.
+             */
+            LOCAL_SPATIAL_INDEX_TYPE_RTREE
         };
     }
 
@@ -139,11 +146,13 @@ namespace carto {
         std::shared_ptr<VectorElement> createElement(const std::shared_ptr<Geometry>& geometry, const std::shared_ptr<Style>& style) const;
         std::shared_ptr<VectorElement> simplifyElement(const std::shared_ptr<VectorElement>& element, float scale) const;
         cglib::bbox3<double> calculateElementBounds(const std::shared_ptr<VectorElement>& element) const;
+        std::shared_ptr<SpatialIndex<std::shared_ptr<VectorElement> > > createSpatialIndex() const;
 
         std::shared_ptr<GeometrySimplifier> _geometrySimplifier;
         std::shared_ptr<SpatialIndex<std::shared_ptr<VectorElement> > > _spatialIndex;
         LocalSpatialIndexType::LocalSpatialIndexType _spatialIndexType;
         std::shared_ptr<ProjectionSurface> _projectionSurface;
+        SimplificationCache<std::shared_ptr<VectorElement> > _simplificationCache;
         
         unsigned int _elementId;
 
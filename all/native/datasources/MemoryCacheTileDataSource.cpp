@@ -1,65 +1,195 @@
 #include "MemoryCacheTileDataSource.h"
 #include "core/BinaryData.h"
 #include "core/MapTile.h"
+#include "datasources/components/TileData.h"
 #include "utils/Log.h"
 
 #include <memory>
 
 namespace carto {
-    
+
     MemoryCacheTileDataSource::MemoryCacheTileDataSource(const std::shared_ptr<TileDataSource>& dataSource) :
+        MemoryCacheTileDataSource(dataSource, MemoryCachePolicy::MEMORY_CACHE_POLICY_LRU)
+    {
+    }
+
+    MemoryCacheTileDataSource::MemoryCacheTileDataSource(const std::shared_ptr<TileDataSource>& dataSource, MemoryCachePolicy::MemoryCachePolicy cachePolicy) :
         CacheTileDataSource(dataSource),
-        _cache(DEFAULT_CAPACITY),
+        _cachePolicy(cachePolicy),
+        _shards(),
+        _capacity(0),
         _mutex()
     {
+        unsigned int shardCount = (cachePolicy == MemoryCachePolicy::MEMORY_CACHE_POLICY_SHARDED_LRU ? SHARD_COUNT : 1);
+        for (unsigned int i = 0; i < shardCount; i++) {
+            _shards.emplace_back(new CacheShard());
+        }
+        setCapacity(DEFAULT_CAPACITY);
     }
-    
+
     MemoryCacheTileDataSource::~MemoryCacheTileDataSource() {
     }
-    
+
+    MemoryCachePolicy::MemoryCachePolicy MemoryCacheTileDataSource::getCachePolicy() const {
+        return _cachePolicy;
+    }
+
     std::shared_ptr<TileData> MemoryCacheTileDataSource::loadTile(const MapTile& mapTile) {
-        std::unique_lock<std::recursive_mutex> lock(_mutex);
-        
         Log::Infof("MemoryCacheTileDataSource::loadTile: Loading %s", mapTile.toString().c_str());
-        
+
+        CacheShard& shard = getShard(mapTile.getTileId());
+
         std::shared_ptr<TileData> tileData;
-        if (_cache.read(mapTile.getTileId(), tileData)) {
-            if (tileData->getMaxAge() != 0) {
-                return tileData;
-            }
-            _cache.remove(mapTile.getTileId());
+        if (shard.read(mapTile.getTileId(), tileData)) {
+            return tileData;
         }
-        
-        lock.unlock();
+
         tileData = _dataSource->loadTile(mapTile);
-        lock.lock();
 
         if (tileData) {
             if (tileData->getMaxAge() != 0 && tileData->getData() && !tileData->isReplaceWithParent()) {
-                _cache.put(mapTile.getTileId(), tileData, tileData->getData()->size() + 16);
+                shard.put(mapTile.getTileId(), tileData, tileData->getData()->size() + 16);
             }
         } else {
             Log::Infof("MemoryCacheTileDataSource::loadTile: Failed to load %s.", mapTile.toString().c_str());
         }
-        
+
         return tileData;
     }
-    
+
     void MemoryCacheTileDataSource::clear() {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        _cache.clear();
+        for (const std::unique_ptr<CacheShard>& shard : _shards) {
+            shard->clear();
+        }
     }
-    
+
     std::size_t MemoryCacheTileDataSource::getCapacity() const {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        return _cache.capacity();
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _capacity;
     }
-    
+
     void MemoryCacheTileDataSource::setCapacity(std::size_t capacityInBytes) {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-        _cache.resize(capacityInBytes);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _capacity = capacityInBytes;
+        for (const std::unique_ptr<CacheShard>& shard : _shards) {
+            shard->resize(capacityInBytes / _shards.size());
+        }
+    }
+
+    std::size_t MemoryCacheTileDataSource::getHitCount() const {
+        std::size_t count = 0;
+        for (const std::unique_ptr<CacheShard>& shard : _shards) {
+            std::lock_guard<std::mutex> lock(shard->_mutex);
+            count += shard->_hitCount;
+        }
+        return count;
+    }
+
+    std::size_t MemoryCacheTileDataSource::getMissCount() const {
+        std::size_t count = 0;
+        for (const std::unique_ptr<CacheShard>& shard : _shards) {
+            std::lock_guard<std::mutex> lock(shard->_mutex);
+            count += shard->_missCount;
+        }
+        return count;
+    }
+
+    std::size_t MemoryCacheTileDataSource::getEvictionCount() const {
+        std::size_t count = 0;
+        for (const std::unique_ptr<CacheShard>& shard : _shards) {
+            std::lock_guard<std::mutex> lock(shard->_mutex);
+            count += shard->_evictionCount;
+        }
+        return count;
+    }
+
+    MemoryCacheTileDataSource::CacheShard::CacheShard() :
+        _entries(),
+        _entryMap(),
+        _size(0),
+        _capacity(0),
+        _hitCount(0),
+        _missCount(0),
+        _evictionCount(0),
+        _mutex()
+    {
+    }
+
+    bool MemoryCacheTileDataSource::CacheShard::read(long long tileId, std::shared_ptr<TileData>& tileData) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _entryMap.find(tileId);
+        if (it != _entryMap.end()) {
+            if (it->second->tileData->getMaxAge() != 0) {
+                _entries.splice(_entries.begin(), _entries, it->second);
+                tileData = it->second->tileData;
+                _hitCount++;
+                return true;
+            }
+
+            // Expired, remove the tile
+            _size -= it->second->size;
+            _entries.erase(it->second);
+            _entryMap.erase(it);
+        }
+        _missCount++;
+        return false;
+    }
+
+    void MemoryCacheTileDataSource::CacheShard::put(long long tileId, const std::shared_ptr<TileData>& tileData, std::size_t size) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _entryMap.find(tileId);
+        if (it != _entryMap.end()) {
+            _size -= it->second->size;
+            _entries.erase(it->second);
+            _entryMap.erase(it);
+        }
+
+        Entry entry;
+        entry.tileId = tileId;
+        entry.tileData = tileData;
+        entry.size = size;
+        _entries.push_front(std::move(entry));
+        _entryMap[tileId] = _entries.begin();
+        _size += size;
+
+        evict();
+    }
+
+    void MemoryCacheTileDataSource::CacheShard::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _entries.clear();
+        _entryMap.clear();
+        _size = 0;
+    }
+
+    void MemoryCacheTileDataSource::CacheShard::resize(std::size_t capacity) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _capacity = capacity;
+        evict();
+    }
+
+    void MemoryCacheTileDataSource::CacheShard::evict() {
+        // Remove least recently used tiles until the total size fits into the capacity
+        while (_size > _capacity && !_entries.empty()) {
+            const Entry& entry = _entries.back();
+            _size -= entry.size;
+            _entryMap.erase(entry.tileId);
+            _entries.pop_back();
+            _evictionCount++;
+        }
+    }
+
+    MemoryCacheTileDataSource::CacheShard& MemoryCacheTileDataSource::getShard(long long tileId) const {
+        // Note: neighbouring tiles have consecutive ids, thus they are spread evenly between the shards
+        return *_shards[static_cast<std::size_t>(tileId) % _shards.size()];
     }
 
     const unsigned int MemoryCacheTileDataSource::DEFAULT_CAPACITY = 6 * 1024 * 1024;
-    
+
+    const unsigned int MemoryCacheTileDataSource::SHARD_COUNT = 8;
+
 }
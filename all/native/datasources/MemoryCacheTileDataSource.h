@@ -9,13 +9,35 @@
 
 #include "datasources/CacheTileDataSource.h"
 
-#include <stdext/timed_lru_cache.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace carto {
 
+    namespace MemoryCachePolicy {
+        /**
+         * The policy to use for in-memory tile caches.
+         */
+        enum MemoryCachePolicy {
+            /**
+             * Single least-recently-used cache. All tiles compete for the same capacity.
+             */
+            MEMORY_CACHE_POLICY_LRU,
+            /**
+             * Least-recently-used cache divided into independently locked shards.
+             * Recommended when multiple threads load tiles concurrently, as cache access is not serialized.
+             * The eviction order is approximate, as each shard manages its own part of the capacity.
+             */
+            MEMORY_CACHE_POLICY_SHARDED_LRU
+        };
+    }
+
     /**
      * A tile data source that loads tiles from another tile data source
-     * and caches them in memory. This cache is not persistent, tiles 
+     * and caches them in memory. This cache is not persistent, tiles
      * will be cleared once the application closes. Default cache capacity is 6MB.
      */
     class MemoryCacheTileDataSource : public CacheTileDataSource {
@@ -25,23 +47,83 @@ namespace carto {
          * @param dataSource The datasource to be cached.
          */
         explicit MemoryCacheTileDataSource(const std::shared_ptr<TileDataSource>& dataSource);
+        /**
+         * Constructs a MemoryCacheTileDataSource object from tile data source using the specified cache policy.
+         * @param dataSource The datasource to be cached.
+         * @param cachePolicy The cache policy to use.
+         */
+        MemoryCacheTileDataSource(const std::shared_ptr<TileDataSource>& dataSource, MemoryCachePolicy::MemoryCachePolicy cachePolicy);
         virtual ~MemoryCacheTileDataSource();
-    
+
+        /**
+         * Returns the cache policy of the data source.
+         * @return The cache policy of the data source.
+         */
+        MemoryCachePolicy::MemoryCachePolicy getCachePolicy() const;
+
         virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
-                
+
         virtual void clear();
 
         virtual std::size_t getCapacity() const;
-        
+
         virtual void setCapacity(std::size_t capacityInBytes);
-    
+
+        /**
+         * Returns the number of tile requests served from the cache.
+         * @return The number of cache hits since the data source was created.
+         */
+        std::size_t getHitCount() const;
+        /**
+         * Returns the number of tile requests that were forwarded to the original data source.
+         * @return The number of cache misses since the data source was created.
+         */
+        std::size_t getMissCount() const;
+        /**
+         * Returns the number of tiles removed from the cache due to insufficient capacity.
+         * @return The number of cache evictions since the data source was created.
+         */
+        std::size_t getEvictionCount() const;
+
     protected:
+        struct CacheShard {
+            CacheShard();
+
+            bool read(long long tileId, std::shared_ptr<TileData>& tileData);
+            void put(long long tileId, const std::shared_ptr<TileData>& tileData, std::size_t size);
+            void clear();
+            void resize(std::size_t capacity);
+
+            struct Entry {
+                long long tileId;
+                std::shared_ptr<TileData> tileData;
+                std::size_t size;
+            };
+
+            std::list<Entry> _entries; // most recently used first
+            std::unordered_map<long long, std::list<Entry>::iterator> _entryMap;
+            std::size_t _size;
+            std::size_t _capacity;
+            std::size_t _hitCount;
+            std::size_t _missCount;
+            std::size_t _evictionCount;
+            mutable std::mutex _mutex;
+
+        private:
+            void evict();
+        };
+
+        CacheShard& getShard(long long tileId) const;
+
         static const unsigned int DEFAULT_CAPACITY;
+        static const unsigned int SHARD_COUNT;
 
-        cache::timed_lru_cache<long long, std::shared_ptr<TileData> > _cache;
-        mutable std::recursive_mutex _mutex;
+        const MemoryCachePolicy::MemoryCachePolicy _cachePolicy;
+        std::vector<std::unique_ptr<CacheShard> > _shards;
+        std::size_t _capacity;
+        mutable std::mutex _mutex;
     };
-    
+
 }
 
 #endif
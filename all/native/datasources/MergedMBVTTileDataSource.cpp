@@ -69,8 +69,8 @@ namespace carto {
             }
             
             // We have data for both sources, we can merge them. Note that we may need to decompress the data first.
-            std::shared_ptr<std::vector<unsigned char>> data1 = result1->getData()->getDataPtr();
-            std::shared_ptr<std::vector<unsigned char>> data2 = result2->getData()->getDataPtr();
+            std::shared_ptr<BinaryData> data1 = result1->getData();
+            std::shared_ptr<BinaryData> data2 = result2->getData();
 
             std::vector<unsigned char> mergedData;
             mergedData.reserve(data1->size() + data2->size());
@@ -79,13 +79,13 @@ namespace carto {
             if (zlib::inflate_gzip(data1->data(), data1->size(), uncompressedData1)) {
                 mergedData.insert(mergedData.end(), uncompressedData1.begin(), uncompressedData1.end());
             } else {
-                mergedData.insert(mergedData.end(), data1->begin(), data1->end());
+                mergedData.insert(mergedData.end(), data1->data(), data1->data() + data1->size());
             }
             std::vector<unsigned char> uncompressedData2;
             if (zlib::inflate_gzip(data2->data(), data2->size(), uncompressedData2)) {
                 mergedData.insert(mergedData.end(), uncompressedData2.begin(), uncompressedData2.end());
             } else {
-                mergedData.insert(mergedData.end(), data2->begin(), data2->end());
+                mergedData.insert(mergedData.end(), data2->data(), data2->data() + data2->size());
             }
 
             auto mergedBinaryData = std::make_shared<BinaryData>(std::move(mergedData));
@@ -35,6 +35,8 @@
 #include "styles/GeometryCollectionStyleBuilder.h"
 #include "projections/EPSG3857.h"
 
+#include <algorithm>
+
 #include <ogrsf_frmts.h>
 #include <cpl_port.h>
 #include <cpl_config.h>
@@ -100,6 +102,10 @@ namespace carto {
         _codePage("ISO-8859-1"),
         _styleSelector(styleSelector),
         _geometrySimplifier(),
+        _simplificationCache(),
+        _featureRecords(),
+        _featureRecordMap(),
+        _featureCacheSize(DEFAULT_FEATURE_CACHE_SIZE),
         _localElementId(-1),
         _localElements(),
         _dataBase(std::make_shared<OGRVectorDataBase>(fileName, false)),
@@ -124,6 +130,10 @@ namespace carto {
         _codePage("ISO-8859-1"),
         _styleSelector(styleSelector),
         _geometrySimplifier(),
+        _simplificationCache(),
+        _featureRecords(),
+        _featureRecordMap(),
+        _featureCacheSize(DEFAULT_FEATURE_CACHE_SIZE),
         _localElementId(-1),
         _localElements(),
         _dataBase(dataBase),
@@ -158,6 +168,8 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_dataBase->_mutex);
             _codePage = codePage;
+            _featureRecords.clear();
+            _featureRecordMap.clear();
         }
         notifyElementsChanged();
     }
@@ -171,10 +183,22 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_dataBase->_mutex);
             _geometrySimplifier = simplifier;
+            _simplificationCache.clear();
         }
         notifyElementsChanged();
     }
 
+    int OGRVectorDataSource::getFeatureCacheSize() const {
+        std::lock_guard<std::mutex> lock(_dataBase->_mutex);
+        return static_cast<int>(_featureCacheSize);
+    }
+
+    void OGRVectorDataSource::setFeatureCacheSize(int size) {
+        std::lock_guard<std::mutex> lock(_dataBase->_mutex);
+        _featureCacheSize = static_cast<std::size_t>(std::max(0, size));
+        evictFeatureRecords();
+    }
+
     int OGRVectorDataSource::getFeatureCount() const {
         std::lock_guard<std::mutex> lock(_dataBase->_mutex);
         
@@ -336,6 +360,10 @@ namespace carto {
                 it = _localElements.erase(--it);
             }
             
+            _simplificationCache.clear();
+            _featureRecords.clear();
+            _featureRecordMap.clear();
+
             OGRErr err = _poLayer->SyncToDisk();
             if (err != OGRERR_NONE) {
                 Log::Errorf("OGRVectorDataSource::commit: SyncToDisk failed, error code: %d", (int)err);
@@ -357,6 +385,7 @@ namespace carto {
             for (auto it = _localElements.begin(); it != _localElements.end(); it++) {
                 std::shared_ptr<VectorElement> element = it->second;
                 rolledbackElements.push_back(element);
+                removeFeatureRecord(it->first);
             }
             _localElements.clear();
         }
@@ -490,7 +519,8 @@ namespace carto {
             return std::shared_ptr<VectorData>();
         }
 
-        float simplifierScale = cullState->getViewState().estimateWorldPixelMeasure();
+        // Simplified geometries are cached per quantized scale level, thus panning does not require resimplification
+        float simplifierScale = _simplificationCache.update(cullState->getViewState().estimateWorldPixelMeasure(), cullState->getViewState().getProjectionSurface());
 
         MapBounds bounds;
         for (const MapPos& mapPos : cullState->getProjectionEnvelope(_projection).getConvexHull()) {
@@ -498,10 +528,14 @@ namespace carto {
         }
         _poLayer->SetSpatialFilterRect(bounds.getMin().getX(), bounds.getMin().getY(), bounds.getMax().getX(), bounds.getMax().getY());
 
+        // Features are converted only once and kept in an LRU cache. Elements are recreated only when
+        // the simplified geometry or zoom level changes, as the style selector may depend on the zoom level.
+        const ViewState& viewState = cullState->getViewState();
         std::vector<std::shared_ptr<VectorElement>> elements;
         _poLayer->ResetReading();
         while (auto poFeature = std::shared_ptr<OGRFeature>(_poLayer->GetNextFeature(), OGRFeature::DestroyFeature)) {
-            auto elementIt = _localElements.find(poFeature->GetFID());
+            long long fid = poFeature->GetFID();
+            auto elementIt = _localElements.find(fid);
             if (elementIt != _localElements.end()) {
                 if (elementIt->second) {
                     elements.push_back(elementIt->second);
@@ -509,60 +543,52 @@ namespace carto {
                 continue;
             }
 
-            OGRGeometry* poGeometry = poFeature->GetGeometryRef();
-            if (!poGeometry) {
-                continue;
-            }
-
-            std::map<std::string, Variant> metaData;
-            OGRFeatureDefn *poFDefn = _poLayer->GetLayerDefn();
-            if (poFDefn) {
-                for (int i = 0; i < poFDefn->GetFieldCount(); i++) {
-                    OGRFieldDefn* poFieldDefn = poFeature->GetFieldDefnRef(i);
-                    Variant value;
-                    switch (poFieldDefn->GetType()) {
-                    case OFTInteger:
-                        value = Variant(static_cast<long long>(poFeature->GetFieldAsInteger(i)));
-                        break;
-                    case OFTReal:
-                        value = Variant(poFeature->GetFieldAsDouble(i));
-                        break;
-                    default:
-                        {
-                            const char* strValue = poFeature->GetFieldAsString(i);
-                            if (!strValue) {
-                                continue;
-                            }
-                            char* utf8Value = CPLRecode(strValue, _codePage.c_str(), "UTF-8");
-                            if (utf8Value) {
-                                value = Variant(utf8Value);
-                                CPLFree(utf8Value);
-                            } else {
-                                value = Variant(strValue);
-                            }
-                        }
-                        break;
+            auto recordIt = _featureRecordMap.find(fid);
+            if (recordIt != _featureRecordMap.end()) {
+                _featureRecords.splice(_featureRecords.begin(), _featureRecords, recordIt->second);
+            } else {
+                FeatureRecord record;
+                record.fid = fid;
+                record.geometry = createGeometry(poFeature->GetGeometryRef());
+                record.metaData = readMetaData(poFeature.get());
+                record.elementGeometry = std::shared_ptr<Geometry>();
+                record.elementZoom = 0;
+                record.element = std::shared_ptr<VectorElement>();
+                _featureRecords.push_front(std::move(record));
+                recordIt = _featureRecordMap.emplace(fid, _featureRecords.begin()).first;
+            }
+            FeatureRecord& record = *recordIt->second;
+
+            std::shared_ptr<Geometry> geometry = record.geometry;
+            if (_geometrySimplifier) {
+                if (!_simplificationCache.get(fid, geometry)) {
+                    if (geometry) {
+                        geometry = _geometrySimplifier->simplify(geometry, _projection, viewState.getProjectionSurface(), simplifierScale);
                     }
-                    metaData[poFDefn->GetFieldDefn(i)->GetNameRef()] = value;
+                    _simplificationCache.put(fid, geometry);
                 }
             }
-                
-            std::shared_ptr<Geometry> geometry = createGeometry(poGeometry);
-            if (_geometrySimplifier) {
-                if (geometry) {
-                    geometry = _geometrySimplifier->simplify(geometry, _projection, cullState->getViewState().getProjectionSurface(), simplifierScale);
-                }
+            if (!geometry) {
+                continue;
             }
-            if (geometry) {
-                std::shared_ptr<VectorElement> vectorElement = createVectorElement(cullState->getViewState(), geometry, metaData);
-                if (vectorElement) {
-                    vectorElement->setId(poFeature->GetFID());
-                    vectorElement->setMetaData(metaData);
-                    attachElement(vectorElement);
-                    elements.push_back(std::move(vectorElement));
+
+            if (geometry != record.elementGeometry || viewState.getZoom() != record.elementZoom) {
+                record.element = createVectorElement(viewState, geometry, record.metaData);
+                record.elementGeometry = geometry;
+                record.elementZoom = viewState.getZoom();
+                if (record.element) {
+                    record.element->setId(fid);
+                    record.element->setMetaData(record.metaData);
+                    attachElement(record.element);
                 }
             }
+            if (record.element) {
+                elements.push_back(record.element);
+            }
         }
+
+        // Evict only after reading, as records of the current view must remain valid during the loop
+        evictFeatureRecords();
         
         for (auto elementIt = _localElements.begin(); elementIt != _localElements.end(); elementIt++) {
             if (elementIt->first < 0 && elementIt->second) {
@@ -577,10 +603,63 @@ namespace carto {
         {
             std::lock_guard<std::mutex> lock(_dataBase->_mutex);
             _localElements[element->getId()] = element;
+            _simplificationCache.remove(element->getId());
+            removeFeatureRecord(element->getId());
         }
         VectorDataSource::notifyElementChanged(element);
     }
     
+    std::map<std::string, Variant> OGRVectorDataSource::readMetaData(OGRFeature* poFeature) const {
+        std::map<std::string, Variant> metaData;
+        OGRFeatureDefn *poFDefn = _poLayer->GetLayerDefn();
+        if (poFDefn) {
+            for (int i = 0; i < poFDefn->GetFieldCount(); i++) {
+                OGRFieldDefn* poFieldDefn = poFeature->GetFieldDefnRef(i);
+                Variant value;
+                switch (poFieldDefn->GetType()) {
+                case OFTInteger:
+                    value = Variant(static_cast<long long>(poFeature->GetFieldAsInteger(i)));
+                    break;
+                case OFTReal:
+                    value = Variant(poFeature->GetFieldAsDouble(i));
+                    break;
+                default:
+                    {
+                        const char* strValue = poFeature->GetFieldAsString(i);
+                        if (!strValue) {
+                            continue;
+                        }
+                        char* utf8Value = CPLRecode(strValue, _codePage.c_str(), "UTF-8");
+                        if (utf8Value) {
+                            value = Variant(utf8Value);
+                            CPLFree(utf8Value);
+                        } else {
+                            value = Variant(strValue);
+                        }
+                    }
+                    break;
+                }
+                metaData[poFDefn->GetFieldDefn(i)->GetNameRef()] = value;
+            }
+        }
+        return metaData;
+    }
+
+    void OGRVectorDataSource::removeFeatureRecord(long long fid) {
+        auto it = _featureRecordMap.find(fid);
+        if (it != _featureRecordMap.end()) {
+            _featureRecords.erase(it->second);
+            _featureRecordMap.erase(it);
+        }
+    }
+
+    void OGRVectorDataSource::evictFeatureRecords() {
+        while (_featureRecords.size() > _featureCacheSize) {
+            _featureRecordMap.erase(_featureRecords.back().fid);
+            _featureRecords.pop_back();
+        }
+    }
+
     std::shared_ptr<Geometry> OGRVectorDataSource::createGeometry(const OGRGeometry* poGeometry) const {
         if (!poGeometry) {
             return std::shared_ptr<Geometry>();
@@ -828,6 +907,8 @@ namespace carto {
         return poFeature;
     }
 
+    const int OGRVectorDataSource::DEFAULT_FEATURE_CACHE_SIZE = 8192;
+
 }
 
 #endif
@@ -12,8 +12,11 @@
 #include "core/Variant.h"
 #include "datasources/VectorDataSource.h"
 #include "datasources/OGRVectorDataBase.h"
+#include "geometry/utils/SimplificationCache.h"
 
+#include <list>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 class OGRGeometry;
@@ -113,6 +116,18 @@ namespace carto {
          * @param simplifier The new geometry simplifier to use (can be null).
          */
         void setGeometrySimplifier(const std::shared_ptr<GeometrySimplifier>& simplifier);
+
+        /**
+         * Returns the maximum number of features whose converted geometry, metadata and vector element are cached between loads.
+         * @return The maximum number of cached features. The default is 8192.
+         */
+        int getFeatureCacheSize() const;
+        /**
+         * Sets the maximum number of features whose converted geometry, metadata and vector element are cached between loads.
+         * For best performance, the cache should be large enough to hold all the features visible in a single view.
+         * @param size The maximum number of cached features. If zero, features are converted again for each load.
+         */
+        void setFeatureCacheSize(int size);
         
         /**
          * Returns the total feature count for this data source.
@@ -206,6 +221,22 @@ namespace carto {
         
     private:
         struct LayerSpatialReference;
+
+        struct FeatureRecord {
+            long long fid;
+            std::shared_ptr<Geometry> geometry;
+            std::map<std::string, Variant> metaData;
+            std::shared_ptr<Geometry> elementGeometry;
+            float elementZoom;
+            std::shared_ptr<VectorElement> element;
+        };
+
+        std::map<std::string, Variant> readMetaData(OGRFeature* poFeature) const;
+
+        void removeFeatureRecord(long long fid);
+        void evictFeatureRecords();
+
+        static const int DEFAULT_FEATURE_CACHE_SIZE;
         
         std::shared_ptr<Geometry> createGeometry(const OGRGeometry* poGeometry) const;
         
@@ -218,6 +249,11 @@ namespace carto {
         std::string _codePage;
         std::shared_ptr<StyleSelector> _styleSelector;
         std::shared_ptr<GeometrySimplifier> _geometrySimplifier;
+        SimplificationCache<std::shared_ptr<Geometry> > _simplificationCache;
+
+        std::list<FeatureRecord> _featureRecords; // most recently used first
+        std::unordered_map<long long, std::list<FeatureRecord>::iterator> _featureRecordMap;
+        std::size_t _featureCacheSize;
 
         long long _localElementId;
         std::map<long long, std::shared_ptr<VectorElement> > _localElements;
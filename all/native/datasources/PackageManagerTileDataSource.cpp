@@ -1,20 +1,32 @@
 #ifdef _CARTO_PACKAGEMANAGER_SUPPORT
 
 #include "PackageManagerTileDataSource.h"
+#include "core/BinaryData.h"
 #include "core/MapTile.h"
 #include "components/Exceptions.h"
 #include "packagemanager/handlers/MapPackageHandler.h"
 #include "utils/Log.h"
 #include "utils/Const.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 
+#include <boost/lexical_cast.hpp>
+
 namespace carto {
 
     PackageManagerTileDataSource::PackageManagerTileDataSource(const std::shared_ptr<PackageManager>& packageManager) :
         TileDataSource(0, Const::MAX_SUPPORTED_ZOOM_LEVEL),
         _packageManager(packageManager),
+        _routingIndex(),
+        _routingIndexVersion(0),
         _cachedOpenPackageHandlers(),
+        _tileCache(),
+        _tileCacheMap(),
+        _tileCacheSize(0),
+        _tileCacheCapacity(DEFAULT_TILE_CACHE_CAPACITY),
+        _tileCacheMutex(),
         _mutex()
     {
         if (!packageManager) {
@@ -34,74 +46,204 @@ namespace carto {
         return _packageManager;
     }
 
+    std::size_t PackageManagerTileDataSource::getTileCacheCapacity() const {
+        return _tileCacheCapacity.load();
+    }
+
+    void PackageManagerTileDataSource::setTileCacheCapacity(std::size_t capacityInBytes) {
+        std::lock_guard<std::mutex> lock(_tileCacheMutex);
+        _tileCacheCapacity = capacityInBytes;
+        evictCachedTiles();
+    }
+
     std::shared_ptr<TileData> PackageManagerTileDataSource::loadTile(const MapTile& mapTile) {
         Log::Infof("PackageManagerTileDataSource::loadTile: Loading %s", mapTile.toString().c_str());
         try {
             MapTile mapTileFlipped = mapTile.getFlipped();
 
+            // Load the tile from the first matching package. Note that this is done without holding the lock, package handlers use their own connection pools.
+            std::shared_ptr<const RoutingIndex> routingIndex = getRoutingIndex();
             std::shared_ptr<BinaryData> data;
-            _packageManager->accessLocalPackages([this, mapTileFlipped, &data](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
-                std::lock_guard<std::mutex> lock(_mutex);
-
-                // Fast path: try already open packages
-                for (auto it = _cachedOpenPackageHandlers.begin(); it != _cachedOpenPackageHandlers.end(); it++) {
-                    const std::shared_ptr<PackageInfo>& packageInfo = it->first;
-                    std::shared_ptr<PackageTileMask> tileMask = packageInfo->getTileMask();
-                    if (tileMask) {
-                        if (tileMask->getTileStatus(mapTileFlipped) == PackageTileStatus::PACKAGE_TILE_STATUS_MISSING) {
-                            continue;
-                        }
+            bool useTileCache = _tileCacheCapacity.load() > 0;
+            for (int packageIndex : FindPackageIndices(*routingIndex, mapTileFlipped)) {
+                const std::shared_ptr<PackageInfo>& packageInfo = routingIndex->packageHandlers[packageIndex].first;
+                const std::shared_ptr<MapPackageHandler>& mapHandler = routingIndex->packageHandlers[packageIndex].second;
+                std::shared_ptr<PackageTileMask> tileMask = packageInfo->getTileMask();
+                if (tileMask) {
+                    if (tileMask->getTileStatus(mapTileFlipped) == PackageTileStatus::PACKAGE_TILE_STATUS_MISSING) {
+                        continue;
                     }
+                }
 
-                    data = it->second->loadTile(mapTileFlipped);
-                    if (data || tileMask) {
-                        std::rotate(_cachedOpenPackageHandlers.begin(), it, it + 1);
-                        return;
+                std::string cacheKey;
+                if (useTileCache) {
+                    cacheKey = CreateTileCacheKey(*packageInfo, mapTileFlipped);
+                    if (findCachedTile(cacheKey, data)) {
+                        break;
                     }
                 }
 
-                // Slow path: try other packages
-                for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
-                    if (auto mapHandler = std::dynamic_pointer_cast<MapPackageHandler>(it->second)) {
-                        const std::shared_ptr<PackageInfo>& packageInfo = it->first;
-                        std::shared_ptr<PackageTileMask> tileMask = packageInfo->getTileMask();
-                        if (tileMask) {
-                            if (tileMask->getTileStatus(mapTileFlipped) == PackageTileStatus::PACKAGE_TILE_STATUS_MISSING) {
-                                continue;
-                            }
-                        }
-
-                        mapHandler->openDatabase();
-                        data = mapHandler->loadTile(mapTileFlipped);
-                        if (data || tileMask) {
-                            _cachedOpenPackageHandlers.insert(_cachedOpenPackageHandlers.begin(), std::make_pair(packageInfo, mapHandler));
-                            if (_cachedOpenPackageHandlers.size() > MAX_OPEN_PACKAGES) {
-                                _cachedOpenPackageHandlers.back().second->closeDatabase();
-                                _cachedOpenPackageHandlers.pop_back();
-                            }
-                            return;
-                        }
-                    }
+                data = mapHandler->loadTile(mapTileFlipped);
+                if (data && useTileCache) {
+                    storeCachedTile(cacheKey, data);
                 }
-            });
-
-            std::shared_ptr<TileData> tileData = std::make_shared<TileData>(data);
-            if (!data) {
-                if (mapTileFlipped.getZoom() > getMinZoom()) {
-                    Log::Infof("PackageManagerTileDataSource::loadTile: Tile data doesn't exist in the database, redirecting to parent");
-                    tileData->setReplaceWithParent(true);
-                } else {
-                    Log::Infof("PackageManagerTileDataSource::loadTile: Tile data doesn't exist in the database");
-                    return std::shared_ptr<TileData>();
+                if (data || tileMask) {
+                    updateOpenPackageHandlers(packageInfo, mapHandler);
+                    break;
                 }
             }
-            return tileData;
+
+            return createTileData(mapTileFlipped, data);
         }
         catch (const std::exception& ex) {
             Log::Errorf("PackageManagerTileDataSource::loadTile: Exception: %s", ex.what());
         }
         return std::shared_ptr<TileData>();
     }
+
+    std::shared_ptr<const PackageManagerTileDataSource::RoutingIndex> PackageManagerTileDataSource::getRoutingIndex() const {
+        int routingIndexVersion = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_routingIndex) {
+                return _routingIndex;
+            }
+            routingIndexVersion = _routingIndexVersion;
+        }
+
+        std::shared_ptr<const RoutingIndex> routingIndex = buildRoutingIndex();
+
+        // Store the index only if packages have not changed while it was built
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (routingIndexVersion == _routingIndexVersion && !_routingIndex) {
+            _routingIndex = routingIndex;
+        }
+        return routingIndex;
+    }
+
+    std::shared_ptr<const PackageManagerTileDataSource::RoutingIndex> PackageManagerTileDataSource::buildRoutingIndex() const {
+        auto routingIndex = std::make_shared<RoutingIndex>();
+        _packageManager->accessLocalPackages([&routingIndex](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
+            for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
+                if (auto mapHandler = std::dynamic_pointer_cast<MapPackageHandler>(it->second)) {
+                    routingIndex->packageHandlers.emplace_back(it->first, mapHandler);
+                }
+            }
+        });
+
+        // Index tiles from the tile masks up to routing index zoom level. Decoding tile masks is relatively expensive, so do it outside package manager callback.
+        for (int i = 0; i < static_cast<int>(routingIndex->packageHandlers.size()); i++) {
+            if (std::shared_ptr<PackageTileMask> tileMask = routingIndex->packageHandlers[i].first->getTileMask()) {
+                AddRoutingIndexTiles(*routingIndex, i, *tileMask, MapTile(0, 0, 0, 0), std::min(ROUTING_INDEX_ZOOM, tileMask->getMaxZoomLevel()));
+            } else {
+                routingIndex->unmaskedPackageIndices.push_back(i);
+            }
+        }
+        return routingIndex;
+    }
+
+    void PackageManagerTileDataSource::updateOpenPackageHandlers(const std::shared_ptr<PackageInfo>& packageInfo, const std::shared_ptr<MapPackageHandler>& mapHandler) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        for (auto it = _cachedOpenPackageHandlers.begin(); it != _cachedOpenPackageHandlers.end(); it++) {
+            if (it->second == mapHandler) {
+                std::rotate(_cachedOpenPackageHandlers.begin(), it, it + 1);
+                return;
+            }
+        }
+
+        _cachedOpenPackageHandlers.insert(_cachedOpenPackageHandlers.begin(), std::make_pair(packageInfo, mapHandler));
+        if (_cachedOpenPackageHandlers.size() > MAX_OPEN_PACKAGES) {
+            _cachedOpenPackageHandlers.back().second->closeDatabase();
+            _cachedOpenPackageHandlers.pop_back();
+        }
+    }
+
+    bool PackageManagerTileDataSource::findCachedTile(const std::string& key, std::shared_ptr<BinaryData>& data) const {
+        std::lock_guard<std::mutex> lock(_tileCacheMutex);
+
+        auto it = _tileCacheMap.find(key);
+        if (it == _tileCacheMap.end()) {
+            return false;
+        }
+        _tileCache.splice(_tileCache.begin(), _tileCache, it->second);
+        data = it->second->data;
+        return true;
+    }
+
+    void PackageManagerTileDataSource::storeCachedTile(const std::string& key, const std::shared_ptr<BinaryData>& data) const {
+        std::lock_guard<std::mutex> lock(_tileCacheMutex);
+
+        if (data->size() + key.size() > _tileCacheCapacity || _tileCacheMap.count(key) > 0) {
+            return;
+        }
+
+        TileCacheEntry entry;
+        entry.key = key;
+        entry.data = data;
+        _tileCache.push_front(std::move(entry));
+        _tileCacheMap[key] = _tileCache.begin();
+        _tileCacheSize += data->size() + key.size();
+
+        evictCachedTiles();
+    }
+
+    void PackageManagerTileDataSource::evictCachedTiles() const {
+        // Remove least recently used tiles until the total size fits into the capacity
+        while (_tileCacheSize > _tileCacheCapacity && !_tileCache.empty()) {
+            const TileCacheEntry& entry = _tileCache.back();
+            _tileCacheSize -= entry.data->size() + entry.key.size();
+            _tileCacheMap.erase(entry.key);
+            _tileCache.pop_back();
+        }
+    }
+
+    std::shared_ptr<TileData> PackageManagerTileDataSource::createTileData(const MapTile& mapTileFlipped, const std::shared_ptr<BinaryData>& data) const {
+        std::shared_ptr<TileData> tileData = std::make_shared<TileData>(data);
+        if (!data) {
+            if (mapTileFlipped.getZoom() > getMinZoom()) {
+                Log::Infof("PackageManagerTileDataSource::loadTile: Tile data doesn't exist in the database, redirecting to parent");
+                tileData->setReplaceWithParent(true);
+            } else {
+                Log::Infof("PackageManagerTileDataSource::loadTile: Tile data doesn't exist in the database");
+                return std::shared_ptr<TileData>();
+            }
+        }
+        return tileData;
+    }
+
+    std::vector<int> PackageManagerTileDataSource::FindPackageIndices(const RoutingIndex& routingIndex, const MapTile& mapTileFlipped) {
+        // Unmasked packages must always be checked
+        std::vector<int> packageIndices;
+        int zoomDelta = std::max(0, mapTileFlipped.getZoom() - ROUTING_INDEX_ZOOM);
+        MapTile routingTile(mapTileFlipped.getX() >> zoomDelta, mapTileFlipped.getY() >> zoomDelta, mapTileFlipped.getZoom() - zoomDelta, 0);
+        auto it = routingIndex.tilePackageIndices.find(routingTile);
+        if (it != routingIndex.tilePackageIndices.end()) {
+            std::merge(it->second.begin(), it->second.end(), routingIndex.unmaskedPackageIndices.begin(), routingIndex.unmaskedPackageIndices.end(), std::back_inserter(packageIndices));
+        } else {
+            packageIndices = routingIndex.unmaskedPackageIndices;
+        }
+        return packageIndices;
+    }
+
+    void PackageManagerTileDataSource::AddRoutingIndexTiles(RoutingIndex& routingIndex, int packageIndex, const PackageTileMask& tileMask, const MapTile& mapTile, int maxZoom) {
+        if (tileMask.getTileStatus(mapTile) == PackageTileStatus::PACKAGE_TILE_STATUS_MISSING) {
+            return;
+        }
+
+        routingIndex.tilePackageIndices[mapTile].push_back(packageIndex);
+        if (mapTile.getZoom() < maxZoom) {
+            for (int dy = 0; dy < 2; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    AddRoutingIndexTiles(routingIndex, packageIndex, tileMask, MapTile(mapTile.getX() * 2 + dx, mapTile.getY() * 2 + dy, mapTile.getZoom() + 1, 0), maxZoom);
+                }
+            }
+        }
+    }
+
+    std::string PackageManagerTileDataSource::CreateTileCacheKey(const PackageInfo& packageInfo, const MapTile& mapTileFlipped) {
+        return packageInfo.getPackageId() + ":" + boost::lexical_cast<std::string>(packageInfo.getVersion()) + ":" + boost::lexical_cast<std::string>(mapTileFlipped.getTileId());
+    }
         
     PackageManagerTileDataSource::PackageManagerListener::PackageManagerListener(PackageManagerTileDataSource& dataSource) :
         _dataSource(dataSource)
@@ -115,7 +257,10 @@ namespace carto {
                 it->second->closeDatabase();
             }
             _dataSource._cachedOpenPackageHandlers.clear();
+            _dataSource._routingIndex.reset();
+            _dataSource._routingIndexVersion++;
         }
+        _dataSource.getRoutingIndex(); // rebuild the index eagerly, so that tile loading threads do not have to wait for it
         _dataSource.notifyTilesChanged(_dataSource._packageManager->getLocalPackages().empty()); // we need to remove all tiles only if there are no more packages left
     }
 
@@ -123,7 +268,9 @@ namespace carto {
         // NOTE: ignore
     }
 
+    const int PackageManagerTileDataSource::ROUTING_INDEX_ZOOM = 8;
     const unsigned int PackageManagerTileDataSource::MAX_OPEN_PACKAGES = 4;
+    const std::size_t PackageManagerTileDataSource::DEFAULT_TILE_CACHE_CAPACITY = 0;
 
 }
 
@@ -13,8 +13,12 @@
 #include "datasources/TileDataSource.h"
 #include "packagemanager/PackageManager.h"
 
+#include <atomic>
+#include <list>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace carto {
@@ -38,6 +42,19 @@ namespace carto {
          */
         std::shared_ptr<PackageManager> getPackageManager() const;
 
+        /**
+         * Returns the decoded tile cache capacity.
+         * @return The decoded tile cache capacity in bytes.
+         */
+        std::size_t getTileCacheCapacity() const;
+        /**
+         * Sets the decoded tile cache capacity. The cache contains decrypted and decompressed package tiles,
+         * so that tiles that are loaded repeatedly do not have to be read from the packages again.
+         * The default is 0, which disables the cache.
+         * @param capacityInBytes The new decoded tile cache capacity in bytes.
+         */
+        void setTileCacheCapacity(std::size_t capacityInBytes);
+
         virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
 
     protected:
@@ -52,12 +69,48 @@ namespace carto {
             PackageManagerTileDataSource& _dataSource;
         };
 
+        struct RoutingIndex {
+            std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<MapPackageHandler> > > packageHandlers;
+            std::unordered_map<MapTile, std::vector<int> > tilePackageIndices;
+            std::vector<int> unmaskedPackageIndices;
+        };
+
+        struct TileCacheEntry {
+            std::string key;
+            std::shared_ptr<BinaryData> data;
+        };
+
+        static const int ROUTING_INDEX_ZOOM;
         static const unsigned int MAX_OPEN_PACKAGES;
+        static const std::size_t DEFAULT_TILE_CACHE_CAPACITY;
+
+        std::shared_ptr<const RoutingIndex> getRoutingIndex() const;
+        std::shared_ptr<const RoutingIndex> buildRoutingIndex() const;
+        void updateOpenPackageHandlers(const std::shared_ptr<PackageInfo>& packageInfo, const std::shared_ptr<MapPackageHandler>& mapHandler) const;
+
+        bool findCachedTile(const std::string& key, std::shared_ptr<BinaryData>& data) const;
+        void storeCachedTile(const std::string& key, const std::shared_ptr<BinaryData>& data) const;
+        void evictCachedTiles() const;
+
+        std::shared_ptr<TileData> createTileData(const MapTile& mapTileFlipped, const std::shared_ptr<BinaryData>& data) const;
+
+        static std::vector<int> FindPackageIndices(const RoutingIndex& routingIndex, const MapTile& mapTileFlipped);
+        static void AddRoutingIndexTiles(RoutingIndex& routingIndex, int packageIndex, const PackageTileMask& tileMask, const MapTile& mapTile, int maxZoom);
+        static std::string CreateTileCacheKey(const PackageInfo& packageInfo, const MapTile& mapTileFlipped);
 
         const std::shared_ptr<PackageManager> _packageManager;
 
+        mutable std::shared_ptr<const RoutingIndex> _routingIndex;
+        mutable int _routingIndexVersion;
+
         mutable std::vector<std::pair<std::shared_ptr<PackageInfo>, std::shared_ptr<MapPackageHandler> > > _cachedOpenPackageHandlers;
 
+        mutable std::list<TileCacheEntry> _tileCache; // most recently used first
+        mutable std::unordered_map<std::string, std::list<TileCacheEntry>::iterator> _tileCacheMap;
+        mutable std::size_t _tileCacheSize;
+        std::atomic<std::size_t> _tileCacheCapacity;
+        mutable std::mutex _tileCacheMutex;
+
         mutable std::mutex _mutex;
 
     private:
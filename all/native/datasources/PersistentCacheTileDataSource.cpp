@@ -13,6 +13,13 @@ namespace carto {
     PersistentCacheTileDataSource::PersistentCacheTileDataSource(const std::shared_ptr<TileDataSource>& dataSource, const std::string& databasePath) :
         CacheTileDataSource(dataSource),
         _database(),
+        _storeCommand(),
+        _touchCommand(),
+        _removeCommand(),
+        _pendingStores(),
+        _pendingTouches(),
+        _pendingRemoves(),
+        _lastFlushTime(std::chrono::steady_clock::now()),
         _cacheOnlyMode(false),
         _downloadThreadPool(std::make_shared<CancelableThreadPool>()),
         _cache(DEFAULT_CAPACITY),
@@ -67,6 +74,8 @@ namespace carto {
             tileData = get(mapTile.getTileId());
             if (tileData) {
                 if (tileData->getMaxAge() != 0) {
+                    touch(mapTile.getTileId());
+                    flush(false);
                     return tileData;
                 }
             }
@@ -91,6 +100,8 @@ namespace carto {
         } else {
             Log::Infof("PersistentCacheTileDataSource::loadTile: Failed to load %s", mapTile.toString().c_str());
         }
+
+        flush(false);
         
         return tileData;
     }
@@ -108,7 +119,8 @@ namespace carto {
     void PersistentCacheTileDataSource::clear() {
         try {
             std::lock_guard<std::recursive_mutex> lock(_mutex);
-            _cache.clear(); // forces all elements to be removed, but can be slow
+            _cache.clear(); // forces all elements to be removed
+            flush(true);
         }
         catch (const std::exception& ex) {
             Log::Errorf("PersistentCacheTileDataSource::clear: Failed to clear cache: %s", ex.what());
@@ -139,6 +151,10 @@ namespace carto {
             sqlite3pp::command command1(*_database, "PRAGMA page_size=4096");
             command1.execute();
             command1.finish();
+
+            // Use write-ahead logging, readers do not block the writer and commits need fewer syncs
+            _database->execute("PRAGMA journal_mode=WAL");
+            _database->execute("PRAGMA synchronous=NORMAL");
             
             try {
                 sqlite3pp::query query1(*_database, "SELECT name FROM sqlite_master WHERE type='table' AND name='persistent_cache'");
@@ -156,12 +172,39 @@ namespace carto {
                 command.finish();
             }
 
-            sqlite3pp::command command3(*_database, "CREATE TABLE IF NOT EXISTS persistent_cache(tileId INTEGER NOT NULL PRIMARY KEY, compressed BLOB, time INTEGER, expirationTime INTEGER)");
+            sqlite3pp::command command3(*_database, "CREATE TABLE IF NOT EXISTS persistent_cache(tileId INTEGER NOT NULL PRIMARY KEY, compressed BLOB, time INTEGER, expirationTime INTEGER, size INTEGER)");
             command3.execute();
             command3.finish();
+
+            try {
+                sqlite3pp::query query1(*_database, "SELECT size FROM persistent_cache LIMIT 1");
+                for (auto it1 = query1.begin(); it1 != query1.end(); ++it1);
+                query1.finish();
+            }
+            catch (const std::exception&) {
+                Log::Info("PersistentCacheTileDataSource::openDatabase: Upgrading database");
+                sqlite3pp::command command4(*_database, "ALTER TABLE persistent_cache ADD COLUMN size INTEGER");
+                command4.execute();
+                command4.finish();
+                sqlite3pp::command command5(*_database, "UPDATE persistent_cache SET size=LENGTH(compressed)");
+                command5.execute();
+                command5.finish();
+            }
+
+            // Covering index for reading the tile info ordered by time, without touching the tile data
+            sqlite3pp::command command6(*_database, "CREATE INDEX IF NOT EXISTS persistent_cache_time ON persistent_cache(time, tileId, size)");
+            command6.execute();
+            command6.finish();
+
+            _storeCommand.reset(new sqlite3pp::command(*_database, "INSERT OR REPLACE INTO persistent_cache(tileId, compressed, time, expirationTime, size) VALUES (:tileId, :compressed, :time, :expirationTime, :size)"));
+            _touchCommand.reset(new sqlite3pp::command(*_database, "UPDATE persistent_cache SET time=:time WHERE tileId=:tileId"));
+            _removeCommand.reset(new sqlite3pp::command(*_database, "DELETE FROM persistent_cache WHERE tileId=:tileId"));
         }
         catch (const std::exception& ex) {
             Log::Errorf("PersistentCacheTileDataSource::openDatabase: Failed to initialize database: %s", ex.what());
+            _storeCommand.reset();
+            _touchCommand.reset();
+            _removeCommand.reset();
             _database.reset();
             return;
         }
@@ -172,6 +215,13 @@ namespace carto {
             return;
         }
 
+        flush(true);
+
+        // Prepared statements must be finalized before closing the database
+        _storeCommand.reset();
+        _touchCommand.reset();
+        _removeCommand.reset();
+
         try {
             if (_database->disconnect() != SQLITE_OK) {
                 Log::Error("PersistentCacheTileDataSource::closeDatabase: Failed to close database");
@@ -198,38 +248,113 @@ namespace carto {
         }
 
         try {
-            // Get tile ids and sizes ordered by the timestamp from the database
+            // Get tile ids and sizes from the time index, starting from the most recent tiles.
+            // Stop once the cache capacity is reached, older tiles would be evicted anyway.
             std::vector<TileInfo> tileInfos;
             tileInfos.reserve(_cache.capacity() / (EXTRA_TILE_FOOTPRINT + 1));
-            sqlite3pp::query query(*_database, "SELECT tileId, LENGTH(compressed), time FROM persistent_cache");
+            std::size_t totalSize = 0;
+            std::shared_ptr<std::uint64_t> evictionTime;
+            sqlite3pp::query query(*_database, "SELECT tileId, size, time FROM persistent_cache ORDER BY time DESC");
             for (auto it = query.begin(); it != query.end(); ++it) {
                 TileInfo tileInfo;
                 tileInfo.tileId = (*it).get<std::uint64_t>(0);
                 tileInfo.tileSize = static_cast<std::size_t>((*it).get<std::uint64_t>(1));
                 tileInfo.time = (*it).get<std::uint64_t>(2);
+                if (evictionTime && tileInfo.time < *evictionTime) {
+                    break;
+                }
+                totalSize += tileInfo.tileSize + EXTRA_TILE_FOOTPRINT;
+                if (totalSize > _cache.capacity() && !evictionTime) {
+                    // Keep the tiles with the same timestamp, cache will evict these
+                    evictionTime = std::make_shared<std::uint64_t>(tileInfo.time);
+                }
                 tileInfos.push_back(tileInfo);
             }
             query.finish();
 
-            // Sort the tiles
-            std::sort(tileInfos.begin(), tileInfos.end(), [](const TileInfo& tileInfo1, const TileInfo& tileInfo2) {
-                return tileInfo1.time < tileInfo2.time;
-            });
+            // Remove the tiles that do not fit into the cache
+            if (evictionTime) {
+                sqlite3pp::command command(*_database, "DELETE FROM persistent_cache WHERE time<:time");
+                command.bind(":time", *evictionTime);
+                command.execute();
+                command.finish();
+            }
 
-            // Now store the queried items in cache. This may result in eviction of some of the items.
-            for (const TileInfo& tileInfo : tileInfos) {
-                _cache.put(tileInfo.tileId, createTileId(tileInfo.tileId), tileInfo.tileSize + EXTRA_TILE_FOOTPRINT);
+            // Now store the queried items in cache, starting from the oldest. This may result in eviction of some of the items.
+            for (auto it = tileInfos.rbegin(); it != tileInfos.rend(); it++) {
+                _cache.put(it->tileId, createTileId(it->tileId), it->tileSize + EXTRA_TILE_FOOTPRINT);
             }
         }
         catch (const std::exception& ex) {
             Log::Errorf("PersistentCacheTileDataSource::loadTileInfo: Failed to query tile set from the database: %s", ex.what());
         }
+
+        flush(true);
+    }
+
+    void PersistentCacheTileDataSource::flush(bool force) {
+        if (!_database) {
+            return;
+        }
+
+        std::size_t pendingUpdates = _pendingStores.size() + _pendingTouches.size() + _pendingRemoves.size();
+        if (pendingUpdates == 0) {
+            return;
+        }
+        if (!force && pendingUpdates < MAX_PENDING_UPDATES && std::chrono::steady_clock::now() - _lastFlushTime < std::chrono::milliseconds(FLUSH_INTERVAL)) {
+            return;
+        }
+
+        // Write all pending updates in a single transaction
+        try {
+            sqlite3pp::transaction xct(*_database);
+
+            for (long long tileId : _pendingRemoves) {
+                _removeCommand->bind(":tileId", static_cast<std::uint64_t>(tileId));
+                _removeCommand->execute();
+                _removeCommand->reset();
+            }
+
+            for (auto it = _pendingStores.begin(); it != _pendingStores.end(); it++) {
+                const std::shared_ptr<BinaryData>& data = it->second.tileData->getData();
+                _storeCommand->bind(":tileId", static_cast<std::uint64_t>(it->first));
+                _storeCommand->bind(":compressed", data->data(), static_cast<unsigned int>(data->size()));
+                _storeCommand->bind(":time", static_cast<std::uint64_t>(it->second.time));
+                _storeCommand->bind(":expirationTime", static_cast<std::uint64_t>(it->second.expirationTime));
+                _storeCommand->bind(":size", static_cast<std::uint64_t>(data->size()));
+                _storeCommand->execute();
+                _storeCommand->reset();
+            }
+
+            for (auto it = _pendingTouches.begin(); it != _pendingTouches.end(); it++) {
+                _touchCommand->bind(":tileId", static_cast<std::uint64_t>(it->first));
+                _touchCommand->bind(":time", static_cast<std::uint64_t>(it->second));
+                _touchCommand->execute();
+                _touchCommand->reset();
+            }
+
+            xct.commit();
+        }
+        catch (const std::exception& ex) {
+            Log::Errorf("PersistentCacheTileDataSource::flush: Failed to update the database: %s", ex.what());
+        }
+
+        _pendingStores.clear();
+        _pendingTouches.clear();
+        _pendingRemoves.clear();
+        _lastFlushTime = std::chrono::steady_clock::now();
     }
     
     std::shared_ptr<TileData> PersistentCacheTileDataSource::get(long long tileId) {
         if (!_database) {
             return std::shared_ptr<TileData>();
         }
+
+        // Check pending updates first
+        auto it = _pendingStores.find(tileId);
+        if (it != _pendingStores.end()) {
+            return it->second.tileData;
+        }
     
         try {
             // Get the tile from the database
@@ -273,18 +398,28 @@ namespace carto {
             expirationTime = std::chrono::duration_cast<std::chrono::milliseconds>((std::chrono::system_clock::now() + std::chrono::milliseconds(tileData->getMaxAge())).time_since_epoch()).count();
         }
 
-        // Add tile to the database
-        try {
-            sqlite3pp::command command(*_database, "INSERT OR REPLACE INTO persistent_cache(tileId, compressed, time, expirationTime) VALUES (:tileId, :compressed, :time, :expirationTime)");
-            command.bind(":tileId", static_cast<std::uint64_t>(tileId));
-            command.bind(":compressed", tileData->getData()->data(), static_cast<unsigned int>(tileData->getData()->size()));
-            command.bind(":time", static_cast<std::uint64_t>(time));
-            command.bind(":expirationTime", static_cast<std::uint64_t>(expirationTime));
-            command.execute();
-            command.finish();
+        // Add tile to the pending updates, it will be written to the database with the next batch
+        PendingTile pendingTile;
+        pendingTile.tileData = tileData;
+        pendingTile.time = time;
+        pendingTile.expirationTime = expirationTime;
+        _pendingStores[tileId] = pendingTile;
+        _pendingTouches.erase(tileId);
+        _pendingRemoves.erase(tileId);
+    }
+
+    void PersistentCacheTileDataSource::touch(long long tileId) {
+        if (!_database) {
+            return;
         }
-        catch (const std::exception& ex) {
-            Log::Errorf("PersistentCacheTileDataSource::store: Failed to store tile data in the database: %s", ex.what());
+
+        // Update the access time of the tile, so that the LRU order is preserved between sessions
+        long long time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        auto it = _pendingStores.find(tileId);
+        if (it != _pendingStores.end()) {
+            it->second.time = time;
+        } else {
+            _pendingTouches[tileId] = time;
         }
     }
 
@@ -292,16 +427,10 @@ namespace carto {
         if (!_database) {
             return;
         }
-        
-        try {
-            sqlite3pp::command command(*_database, "DELETE FROM persistent_cache WHERE tileId=:tileId");
-            command.bind(":tileId", static_cast<std::uint64_t>(tileId));
-            command.execute();
-            command.finish();
-        }
-        catch (const std::exception& ex) {
-            Log::Errorf("PersistentCacheTileDataSource::remove: Failed to remove tile from the database: %s", ex.what());
-        }
+
+        _pendingStores.erase(tileId);
+        _pendingTouches.erase(tileId);
+        _pendingRemoves.insert(tileId);
     }
     
     std::shared_ptr<long long> PersistentCacheTileDataSource::createTileId(long long tileId) {
@@ -400,5 +529,7 @@ namespace carto {
 
     const unsigned int PersistentCacheTileDataSource::DEFAULT_CAPACITY = 50 * 1024 * 1024;
     const unsigned int PersistentCacheTileDataSource::EXTRA_TILE_FOOTPRINT = 1024;
+    const unsigned int PersistentCacheTileDataSource::MAX_PENDING_UPDATES = 64;
+    const int PersistentCacheTileDataSource::FLUSH_INTERVAL = 1000;
 
 }
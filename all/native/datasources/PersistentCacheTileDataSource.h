@@ -12,12 +12,16 @@
 #include "components/DirectorPtr.h"
 #include "datasources/CacheTileDataSource.h"
 
+#include <chrono>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <stdext/timed_lru_cache.h>
 
 namespace sqlite3pp {
     class database;
+    class command;
 }
 
 namespace carto {
@@ -29,7 +33,11 @@ namespace carto {
      * even after the application is closed.
      * The database contains table "persistent_cache" with the following fields:
      * "tileId" (tile id), "compressed" (compressed tile image),
-     * "time" (the time the tile was cached in milliseconds from epoch).
+     * "time" (the time the tile was cached or last accessed in milliseconds from epoch),
+     * "expirationTime" (the expiration time of the tile in milliseconds from epoch, or 0),
+     * "size" (the size of the compressed tile in bytes).
+     * Database updates are collected and written in batches, thus the most recent updates
+     * may be lost if the application is terminated without closing the data source.
      * Default cache capacity is 50MB.
      */
     class PersistentCacheTileDataSource : public CacheTileDataSource {
@@ -107,22 +115,40 @@ namespace carto {
             DirectorPtr<TileDownloadListener> _downloadListener;
         };
 
+        struct PendingTile {
+            std::shared_ptr<TileData> tileData;
+            long long time;
+            long long expirationTime;
+        };
+
         static const unsigned int DEFAULT_CAPACITY;
         static const unsigned int EXTRA_TILE_FOOTPRINT;
+        static const unsigned int MAX_PENDING_UPDATES;
+        static const int FLUSH_INTERVAL;
 
         void openDatabase(const std::string& databasePath);
         void closeDatabase();
         void loadTileInfo();
+        void flush(bool force);
 
         void downloadArea(const MapBounds& mapBounds, int minZoom, int maxZoom, const std::shared_ptr<TileDownloadListener>& listener);
         
         std::shared_ptr<TileData> get(long long tileId);
         void store(long long tileId, const std::shared_ptr<TileData>& tileData);
+        void touch(long long tileId);
         void remove(long long tileId);
 
         std::shared_ptr<long long> createTileId(long long tileId);
         
         std::unique_ptr<sqlite3pp::database> _database;
+        std::unique_ptr<sqlite3pp::command> _storeCommand;
+        std::unique_ptr<sqlite3pp::command> _touchCommand;
+        std::unique_ptr<sqlite3pp::command> _removeCommand;
+
+        std::unordered_map<long long, PendingTile> _pendingStores;
+        std::unordered_map<long long, long long> _pendingTouches;
+        std::unordered_set<long long> _pendingRemoves;
+        std::chrono::steady_clock::time_point _lastFlushTime;
         
         bool _cacheOnlyMode;
 
@@ -0,0 +1,369 @@
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+#include "TileArchiveTileDataSource.h"
+#include "core/BinaryData.h"
+#include "core/MapTile.h"
+#include "components/Exceptions.h"
+#include "projections/Projection.h"
+#include "utils/Log.h"
+#include "utils/MemoryMappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <utility>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <sqlite3pp.h>
+
+namespace carto {
+
+    TileArchiveTileDataSource::TileArchiveTileDataSource(const std::string& path) :
+        TileDataSource(),
+        _path(path),
+        _file(),
+        _directory(nullptr),
+        _tileCount(0),
+        _metaData(),
+        _cachedDataExtent(),
+        _mutex()
+    {
+        int minZoom = 0, maxZoom = 0;
+        openArchive(minZoom, maxZoom);
+        _minZoom = minZoom;
+        _maxZoom = maxZoom;
+    }
+
+    TileArchiveTileDataSource::TileArchiveTileDataSource(int minZoom, int maxZoom, const std::string& path) :
+        TileDataSource(minZoom, maxZoom),
+        _path(path),
+        _file(),
+        _directory(nullptr),
+        _tileCount(0),
+        _metaData(),
+        _cachedDataExtent(),
+        _mutex()
+    {
+        int archiveMinZoom = 0, archiveMaxZoom = 0;
+        openArchive(archiveMinZoom, archiveMaxZoom);
+    }
+
+    TileArchiveTileDataSource::~TileArchiveTileDataSource() {
+    }
+
+    std::map<std::string, std::string> TileArchiveTileDataSource::getMetaData() const {
+        return _metaData;
+    }
+
+    MapBounds TileArchiveTileDataSource::getDataExtent() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Try to reuse cached value
+        if (_cachedDataExtent) {
+            return *_cachedDataExtent;
+        }
+
+        // As a first step, try to use metadata
+        MapBounds mapBounds;
+        bool foundMapBounds = false;
+        auto it = _metaData.find("bounds");
+        if (it != _metaData.end()) {
+            try {
+                std::vector<std::string> coordinates;
+                boost::split(coordinates, it->second, boost::is_any_of(","));
+                if (coordinates.size() == 4) {
+                    double x0 = boost::lexical_cast<double>(boost::trim_copy(coordinates[0]));
+                    double y0 = boost::lexical_cast<double>(boost::trim_copy(coordinates[1]));
+                    double x1 = boost::lexical_cast<double>(boost::trim_copy(coordinates[2]));
+                    double y1 = boost::lexical_cast<double>(boost::trim_copy(coordinates[3]));
+                    mapBounds.expandToContain(_projection->fromWgs84(MapPos(x0, y0)));
+                    mapBounds.expandToContain(_projection->fromWgs84(MapPos(x1, y0)));
+                    mapBounds.expandToContain(_projection->fromWgs84(MapPos(x1, y1)));
+                    mapBounds.expandToContain(_projection->fromWgs84(MapPos(x0, y1)));
+                    foundMapBounds = true;
+                }
+            }
+            catch (const std::exception& ex) {
+                Log::Errorf("TileArchiveTileDataSource::getDataExtent: Exception while reading bounds metadata: %s", ex.what());
+            }
+        }
+
+        // If metadata was not available, use tiles at last zoom level. Tiles of a single zoom level are stored consecutively in the directory.
+        if (!foundMapBounds) {
+            int zoom = _maxZoom;
+            long long firstTileId = MapTile(0, 0, zoom, 0).getTileId();
+            long long lastTileId = MapTile(0, 0, zoom + 1, 0).getTileId();
+            int zoomTiles = (1 << zoom);
+            MapBounds projBounds = _projection->getBounds();
+            double tileWidth  = projBounds.getDelta().getX() / zoomTiles;
+            double tileHeight = projBounds.getDelta().getY() / zoomTiles;
+            for (std::uint64_t index = findTileIndex(firstTileId); index < _tileCount; index++) {
+                long long tileId = getTileId(index);
+                if (tileId >= lastTileId) {
+                    break;
+                }
+                int tileX = static_cast<int>((tileId - firstTileId) % zoomTiles);
+                int tileY = zoomTiles - 1 - static_cast<int>((tileId - firstTileId) / zoomTiles); // NOTE: vertically flipped
+                MapPos tileP0(projBounds.getMin().getX() + tileX * tileWidth, projBounds.getMin().getY() + tileY * tileHeight);
+                MapPos tileP1(projBounds.getMin().getX() + (tileX + 1) * tileWidth, projBounds.getMin().getY() + (tileY + 1) * tileHeight);
+                mapBounds.expandToContain(MapBounds(tileP0, tileP1));
+            }
+        }
+
+        _cachedDataExtent.reset(new MapBounds(mapBounds));
+        return mapBounds;
+    }
+
+    std::shared_ptr<TileData> TileArchiveTileDataSource::loadTile(const MapTile& mapTile) {
+        Log::Infof("TileArchiveTileDataSource::loadTile: Loading %s", mapTile.toString().c_str());
+
+        // The archive is immutable, no locking is needed
+        TileEntry entry;
+        if (!findTile(MapTile(mapTile.getX(), mapTile.getY(), mapTile.getZoom(), 0).getTileId(), entry)) {
+            std::shared_ptr<TileData> tileData = std::make_shared<TileData>(std::shared_ptr<BinaryData>());
+            if (mapTile.getZoom() > getMinZoom()) {
+                Log::Infof("TileArchiveTileDataSource::loadTile: Tile data doesn't exist in the archive, redirecting to parent");
+                tileData->setReplaceWithParent(true);
+            } else {
+                Log::Infof("TileArchiveTileDataSource::loadTile: Tile data doesn't exist in the archive");
+                return std::shared_ptr<TileData>();
+            }
+            return tileData;
+        }
+
+        // Tile data is not copied, the mapping is kept alive until the data is released
+        auto data = std::make_shared<BinaryData>(_file->data() + entry.offset, entry.size, _file);
+        return std::make_shared<TileData>(data);
+    }
+
+    void TileArchiveTileDataSource::ConvertMBTiles(const std::string& mbTilesPath, const std::string& archivePath, MBTilesScheme::MBTilesScheme scheme) {
+        sqlite3pp::database db;
+        if (db.connect_v2(mbTilesPath.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+            throw FileException("Failed to open database file", mbTilesPath);
+        }
+
+        std::ofstream archive(archivePath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!archive) {
+            throw FileException("Failed to create archive file", archivePath);
+        }
+
+        // Header is written once all offsets are known
+        std::vector<unsigned char> header(HEADER_SIZE, 0);
+        archive.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+        // Copy tile data, keeping tiles of the same zoom level close to each other
+        std::vector<std::pair<long long, TileEntry> > tileEntries;
+        std::uint64_t offset = HEADER_SIZE;
+        int minZoom = std::numeric_limits<int>::max(), maxZoom = 0;
+        sqlite3pp::query tileQuery(db, "SELECT zoom_level, tile_column, tile_row, tile_data FROM tiles ORDER BY zoom_level");
+        for (auto it = tileQuery.begin(); it != tileQuery.end(); it++) {
+            int zoom = (*it).get<int>(0);
+            int x = (*it).get<int>(1);
+            int y = (*it).get<int>(2);
+            if (scheme == MBTilesScheme::MBTILES_SCHEME_TMS) {
+                y = (1 << zoom) - 1 - y;
+            }
+            std::size_t dataSize = (*it).column_bytes(3);
+            const char* dataPtr = static_cast<const char*>((*it).get<const void*>(3));
+            archive.write(dataPtr, dataSize);
+
+            TileEntry entry;
+            entry.offset = offset;
+            entry.size = static_cast<std::uint32_t>(dataSize);
+            tileEntries.emplace_back(MapTile(x, y, zoom, 0).getTileId(), entry);
+            offset += dataSize;
+            minZoom = std::min(minZoom, zoom);
+            maxZoom = std::max(maxZoom, zoom);
+        }
+        tileQuery.finish();
+        if (tileEntries.empty()) {
+            minZoom = 0;
+        }
+
+        // Copy metadata
+        std::vector<unsigned char> metaData;
+        std::uint32_t metaDataCount = 0;
+        WriteUInt32(metaData, metaDataCount);
+        try {
+            sqlite3pp::query metaDataQuery(db, "SELECT name, value FROM metadata");
+            for (auto it = metaDataQuery.begin(); it != metaDataQuery.end(); it++) {
+                const char* values[2] = { (*it).get<const char*>(0), (*it).get<const char*>(1) };
+                for (const char* value : values) {
+                    std::size_t valueSize = (value ? std::strlen(value) : 0);
+                    WriteUInt32(metaData, static_cast<std::uint32_t>(valueSize));
+                    metaData.insert(metaData.end(), value, value + valueSize);
+                }
+                metaDataCount++;
+            }
+            metaDataQuery.finish();
+        }
+        catch (const std::exception& ex) {
+            Log::Warnf("TileArchiveTileDataSource::ConvertMBTiles: Failed to read metadata: %s", ex.what());
+        }
+        std::vector<unsigned char> metaDataCountData;
+        WriteUInt32(metaDataCountData, metaDataCount);
+        std::copy(metaDataCountData.begin(), metaDataCountData.end(), metaData.begin());
+        std::uint64_t metaDataOffset = offset;
+        archive.write(reinterpret_cast<const char*>(metaData.data()), metaData.size());
+        offset += metaData.size();
+
+        // Write the directory, sorted by tile ids
+        std::stable_sort(tileEntries.begin(), tileEntries.end(), [](const std::pair<long long, TileEntry>& entry1, const std::pair<long long, TileEntry>& entry2) {
+            return entry1.first < entry2.first;
+        });
+        std::vector<unsigned char> directory;
+        directory.reserve(tileEntries.size() * DIRECTORY_ENTRY_SIZE);
+        for (const std::pair<long long, TileEntry>& tileEntry : tileEntries) {
+            WriteUInt64(directory, static_cast<std::uint64_t>(tileEntry.first));
+            WriteUInt64(directory, tileEntry.second.offset);
+            WriteUInt32(directory, tileEntry.second.size);
+            WriteUInt32(directory, 0);
+        }
+        std::uint64_t directoryOffset = offset;
+        archive.write(reinterpret_cast<const char*>(directory.data()), directory.size());
+
+        header.clear();
+        header.insert(header.end(), ARCHIVE_MAGIC, ARCHIVE_MAGIC + sizeof(ARCHIVE_MAGIC));
+        WriteUInt32(header, ARCHIVE_VERSION);
+        WriteUInt32(header, 0);
+        WriteUInt64(header, tileEntries.size());
+        WriteUInt64(header, directoryOffset);
+        WriteUInt64(header, metaDataOffset);
+        WriteUInt64(header, metaData.size());
+        WriteUInt32(header, static_cast<std::uint32_t>(minZoom));
+        WriteUInt32(header, static_cast<std::uint32_t>(maxZoom));
+        header.resize(HEADER_SIZE, 0);
+        archive.seekp(0);
+        archive.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+        archive.close();
+        if (!archive) {
+            throw FileException("Failed to write archive file", archivePath);
+        }
+    }
+
+    void TileArchiveTileDataSource::openArchive(int& minZoom, int& maxZoom) {
+        _file = std::make_shared<MemoryMappedFile>(_path);
+
+        const unsigned char* data = _file->data();
+        std::size_t size = _file->size();
+        if (size < HEADER_SIZE || std::memcmp(data, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0) {
+            throw FileException("Not a tile archive file", _path);
+        }
+        if (ReadUInt32(data + 8) != ARCHIVE_VERSION) {
+            throw FileException("Unsupported tile archive version", _path);
+        }
+
+        std::uint64_t tileCount = ReadUInt64(data + 16);
+        std::uint64_t directoryOffset = ReadUInt64(data + 24);
+        std::uint64_t metaDataOffset = ReadUInt64(data + 32);
+        std::uint64_t metaDataSize = ReadUInt64(data + 40);
+        minZoom = static_cast<int>(ReadUInt32(data + 48));
+        maxZoom = static_cast<int>(ReadUInt32(data + 52));
+        if (directoryOffset > size || tileCount > (size - directoryOffset) / DIRECTORY_ENTRY_SIZE || metaDataOffset > size || metaDataSize > size - metaDataOffset) {
+            throw FileException("Corrupt tile archive file", _path);
+        }
+
+        // Directory is used directly from the mapped memory
+        _directory = data + directoryOffset;
+        _tileCount = tileCount;
+
+        // Metadata is small, keep a parsed copy
+        const unsigned char* metaDataPtr = data + metaDataOffset;
+        const unsigned char* metaDataEnd = metaDataPtr + metaDataSize;
+        std::uint32_t metaDataCount = (metaDataSize >= 4 ? ReadUInt32(metaDataPtr) : 0);
+        metaDataPtr += std::min<std::uint64_t>(metaDataSize, 4);
+        for (std::uint32_t i = 0; i < metaDataCount; i++) {
+            std::string values[2];
+            for (std::string& value : values) {
+                if (metaDataEnd - metaDataPtr < 4) {
+                    throw FileException("Corrupt tile archive metadata", _path);
+                }
+                std::uint32_t valueSize = ReadUInt32(metaDataPtr);
+                metaDataPtr += 4;
+                if (static_cast<std::uint64_t>(metaDataEnd - metaDataPtr) < valueSize) {
+                    throw FileException("Corrupt tile archive metadata", _path);
+                }
+                value.assign(reinterpret_cast<const char*>(metaDataPtr), valueSize);
+                metaDataPtr += valueSize;
+            }
+            _metaData[values[0]] = values[1];
+        }
+    }
+
+    std::uint64_t TileArchiveTileDataSource::findTileIndex(long long tileId) const {
+        // Binary search for the first entry with id not less than the given id
+        std::uint64_t low = 0, high = _tileCount;
+        while (low < high) {
+            std::uint64_t mid = low + (high - low) / 2;
+            if (getTileId(mid) < tileId) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    long long TileArchiveTileDataSource::getTileId(std::uint64_t index) const {
+        return static_cast<long long>(ReadUInt64(_directory + index * DIRECTORY_ENTRY_SIZE));
+    }
+
+    bool TileArchiveTileDataSource::findTile(long long tileId, TileEntry& entry) const {
+        std::uint64_t index = findTileIndex(tileId);
+        if (index >= _tileCount || getTileId(index) != tileId) {
+            return false;
+        }
+
+        const unsigned char* entryPtr = _directory + index * DIRECTORY_ENTRY_SIZE;
+        entry.offset = ReadUInt64(entryPtr + 8);
+        entry.size = ReadUInt32(entryPtr + 16);
+        if (entry.offset > _file->size() || entry.size > _file->size() - entry.offset) {
+            Log::Errorf("TileArchiveTileDataSource::findTile: Invalid directory entry for tile %lld", tileId);
+            return false;
+        }
+        return true;
+    }
+
+    std::uint32_t TileArchiveTileDataSource::ReadUInt32(const unsigned char* ptr) {
+        std::uint32_t value = 0;
+        for (int i = 3; i >= 0; i--) {
+            value = (value << 8) | ptr[i];
+        }
+        return value;
+    }
+
+    std::uint64_t TileArchiveTileDataSource::ReadUInt64(const unsigned char* ptr) {
+        std::uint64_t value = 0;
+        for (int i = 7; i >= 0; i--) {
+            value = (value << 8) | ptr[i];
+        }
+        return value;
+    }
+
+    void TileArchiveTileDataSource::WriteUInt32(std::vector<unsigned char>& data, std::uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            data.push_back(static_cast<unsigned char>(value >> (i * 8)));
+        }
+    }
+
+    void TileArchiveTileDataSource::WriteUInt64(std::vector<unsigned char>& data, std::uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            data.push_back(static_cast<unsigned char>(value >> (i * 8)));
+        }
+    }
+
+    const char TileArchiveTileDataSource::ARCHIVE_MAGIC[8] = { 'C', 'T', 'A', 'R', 'C', 'H', 'V', '1' };
+
+    const unsigned int TileArchiveTileDataSource::ARCHIVE_VERSION = 1;
+
+    const unsigned int TileArchiveTileDataSource::HEADER_SIZE = 64;
+
+    const unsigned int TileArchiveTileDataSource::DIRECTORY_ENTRY_SIZE = 24;
+
+}
+
+#endif
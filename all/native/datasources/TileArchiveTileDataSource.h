@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_TILEARCHIVETILEDATASOURCE_H_
+#define _CARTO_TILEARCHIVETILEDATASOURCE_H_
+
+#ifdef _CARTO_OFFLINE_SUPPORT
+
+#include "datasources/TileDataSource.h"
+#include "datasources/MBTilesTileDataSource.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace carto {
+    class MemoryMappedFile;
+
+    /**
+     * A read-only tile data source that loads tiles from a local tile archive file.
+     * The archive is a single file containing a header, the tile data, metadata and
+     * a directory of tiles sorted by tile id. The file is memory-mapped, tile lookups
+     * are binary searches in the directory and do not require any database queries.
+     * Tile archives can be created from MBTiles databases using ConvertMBTiles method.
+     */
+    class TileArchiveTileDataSource : public TileDataSource {
+    public:
+        /**
+         * Constructs a TileArchiveTileDataSource object.
+         * Min and max zoom levels are read from the archive.
+         * @param path The path to the local tile archive file.
+         * @throws std::exception If the the file could not be opened or is not a valid tile archive.
+         */
+        explicit TileArchiveTileDataSource(const std::string& path);
+
+        /**
+         * Constructs a TileArchiveTileDataSource object.
+         * @param minZoom The minimum zoom level supported by this data source.
+         * @param maxZoom The maximum zoom level supported by this data source.
+         * @param path The path to the local tile archive file.
+         * @throws std::exception If the the file could not be opened or is not a valid tile archive.
+         */
+        TileArchiveTileDataSource(int minZoom, int maxZoom, const std::string& path);
+
+        virtual ~TileArchiveTileDataSource();
+
+        /**
+         * Get data source metadata information.
+         * When the archive is converted from MBTiles database, the metadata is copied from the database.
+         * @return Map containing meta data information (parameter names mapped to parameter values).
+         */
+        std::map<std::string, std::string> getMetaData() const;
+
+        virtual MapBounds getDataExtent() const;
+
+        virtual std::shared_ptr<TileData> loadTile(const MapTile& mapTile);
+
+        /**
+         * Converts a MBTiles database to a tile archive.
+         * @param mbTilesPath The path to the local MBTiles database file.
+         * @param archivePath The path to the tile archive file to create. Existing file is overwritten.
+         * @param scheme The tile scheme of the MBTiles database.
+         * @throws std::exception If the database could not be read or the archive could not be written.
+         */
+        static void ConvertMBTiles(const std::string& mbTilesPath, const std::string& archivePath, MBTilesScheme::MBTilesScheme scheme);
+
+    private:
+        struct TileEntry {
+            std::uint64_t offset;
+            std::uint32_t size;
+        };
+
+        void openArchive(int& minZoom, int& maxZoom);
+
+        std::uint64_t findTileIndex(long long tileId) const;
+        long long getTileId(std::uint64_t index) const;
+        bool findTile(long long tileId, TileEntry& entry) const;
+
+        static std::uint32_t ReadUInt32(const unsigned char* ptr);
+        static std::uint64_t ReadUInt64(const unsigned char* ptr);
+        static void WriteUInt32(std::vector<unsigned char>& data, std::uint32_t value);
+        static void WriteUInt64(std::vector<unsigned char>& data, std::uint64_t value);
+
+        static const char ARCHIVE_MAGIC[8];
+        static const unsigned int ARCHIVE_VERSION;
+        static const unsigned int HEADER_SIZE;
+        static const unsigned int DIRECTORY_ENTRY_SIZE;
+
+        const std::string _path;
+        std::shared_ptr<MemoryMappedFile> _file;
+        const unsigned char* _directory;
+        std::uint64_t _tileCount;
+        std::map<std::string, std::string> _metaData;
+        mutable std::unique_ptr<MapBounds> _cachedDataExtent;
+        mutable std::mutex _mutex;
+    };
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_RTREESPATIALINDEX_H_
+#define _CARTO_RTREESPATIALINDEX_H_
+
+#include "geometry/utils/SpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace carto {
+
+    /**
+     * Packed R-tree, bulk loaded using Sort-Tile-Recursive algorithm.
+     * All nodes are stored in flat arrays, tree levels are implicit (each node has NODE_SIZE children).
+     * New records are kept in a small unindexed buffer and removed records are marked as deleted,
+     * the tree is repacked once either grows too large.
+     */
+    template <typename T>
+    class RTreeSpatialIndex : public SpatialIndex<T> {
+    public:
+        RTreeSpatialIndex();
+        virtual ~RTreeSpatialIndex() { }
+
+        virtual std::size_t size() const;
+        virtual void reserve(std::size_t size);
+
+        virtual void clear();
+        virtual void insert(const cglib::bbox3<double>& bounds, const T& object);
+        virtual void insertAll(const std::vector<std::pair<cglib::bbox3<double>, T> >& records);
+        virtual bool remove(const cglib::bbox3<double>& bounds, const T& object);
+        virtual bool remove(const T& object);
+
+        virtual std::vector<T> query(const cglib::frustum3<double>& frustum) const;
+        virtual std::vector<T> query(const cglib::bbox3<double>& bounds) const;
+        virtual std::vector<T> getAll() const;
+
+    private:
+        struct Record {
+            Record(const cglib::bbox3<double>& bounds, const T& object);
+
+            cglib::bbox3<double> bounds;
+            T object;
+            bool removed;
+        };
+
+        void rebuild();
+        void sortRecords(std::vector<std::pair<cglib::vec3<double>, std::size_t> >& centers, std::size_t begin, std::size_t end, const std::vector<int>& axes, std::size_t axisIndex) const;
+
+        template <typename Bounds>
+        void queryTree(const Bounds& bounds, std::vector<T>& results) const;
+
+        static const std::size_t NODE_SIZE;
+        static const std::size_t MIN_PENDING_COUNT;
+        static const std::size_t PENDING_RATIO;
+
+        std::vector<Record> _records; // packed records, in leaf order
+        std::vector<Record> _pendingRecords; // records not yet in the tree
+        std::vector<cglib::bbox3<double> > _nodeBounds; // all levels, starting from leaves
+        std::vector<std::size_t> _levelOffsets; // offsets of levels in _nodeBounds, plus end offset
+        std::size_t _removedCount;
+        std::size_t _count;
+    };
+
+    template<typename T>
+    RTreeSpatialIndex<T>::RTreeSpatialIndex() :
+        _records(),
+        _pendingRecords(),
+        _nodeBounds(),
+        _levelOffsets(),
+        _removedCount(0),
+        _count(0)
+    {
+    }
+
+    template<typename T>
+    std::size_t RTreeSpatialIndex<T>::size() const {
+        return _count;
+    }
+
+    template<typename T>
+    void RTreeSpatialIndex<T>::reserve(std::size_t size) {
+        _records.reserve(size);
+    }
+
+    template<typename T>
+    void RTreeSpatialIndex<T>::clear() {
+        _records.clear();
+        _pendingRecords.clear();
+        _nodeBounds.clear();
+        _levelOffsets.clear();
+        _removedCount = 0;
+        _count = 0;
+    }
+
+    template<typename T>
+    void RTreeSpatialIndex<T>::insert(const cglib::bbox3<double>& bounds, const T& object) {
+        _pendingRecords.emplace_back(bounds, object);
+        _count++;
+
+        // Repack once the unindexed records start to affect query performance
+        if (_pendingRecords.size() > std::max(MIN_PENDING_COUNT, _records.size() / PENDING_RATIO)) {
+            rebuild();
+        }
+    }
+
+    template<typename T>
+    void RTreeSpatialIndex<T>::insertAll(const std::vector<std::pair<cglib::bbox3<double>, T> >& records) {
+        _pendingRecords.reserve(_pendingRecords.size() + records.size());
+        for (const std::pair<cglib::bbox3<double>, T>& record : records) {
+            _pendingRecords.emplace_back(record.first, record.second);
+        }
+        _count += records.size();
+        rebuild();
+    }
+
+    template<typename T>
+    bool RTreeSpatialIndex<T>::remove(const cglib::bbox3<double>& bounds, const T& object) {
+        std::size_t count = _count;
+
+        for (auto it = _pendingRecords.begin(); it != _pendingRecords.end(); ) {
+            if (it->object == object) {
+                it = _pendingRecords.erase(it);
+                _count--;
+            } else {
+                ++it;
+            }
+        }
+
+        // Traverse the nodes intersecting the bounds, starting from the root
+        if (!_levelOffsets.empty()) {
+            std::vector<std::pair<std::size_t, std::size_t> > stack; // level, node index
+            stack.emplace_back(_levelOffsets.size() - 2, 0);
+            while (!stack.empty()) {
+                std::size_t level = stack.back().first;
+                std::size_t index = stack.back().second;
+                stack.pop_back();
+                if (!bounds.inside(_nodeBounds[_levelOffsets[level] + index])) {
+                    continue;
+                }
+                if (level == 0) {
+                    std::size_t end = std::min((index + 1) * NODE_SIZE, _records.size());
+                    for (std::size_t i = index * NODE_SIZE; i < end; i++) {
+                        Record& record = _records[i];
+                        if (!record.removed && record.object == object) {
+                            record.object = T(); // release the object, record is dropped on next rebuild
+                            record.removed = true;
+                            _removedCount++;
+                            _count--;
+                        }
+                    }
+                } else {
+                    std::size_t end = std::min((index + 1) * NODE_SIZE, _levelOffsets[level] - _levelOffsets[level - 1]);
+                    for (std::size_t i = index * NODE_SIZE; i < end; i++) {
+                        stack.emplace_back(level - 1, i);
+                    }
+                }
+            }
+        }
+
+        if (_removedCount > _records.size() / 2) {
+            rebuild();
+        }
+        return count != _count;
+    }
+
+    template<typename T>
+    bool RTreeSpatialIndex<T>::remove(const T& object) {
+        std::size_t count = _count;
+
+        for (auto it = _pendingRecords.begin(); it != _pendingRecords.end(); ) {
+            if (it->object == object) {
+                it = _pendingRecords.erase(it);
+                _count--;
+            } else {
+                ++it;
+            }
+        }
+
+        for (Record& record : _records) {
+            if (!record.removed && record.object == object) {
+                record.object = T();
+                record.removed = true;
+                _removedCount++;
+                _count--;
+            }
+        }
+
+        if (_removedCount > _records.size() / 2) {
+            rebuild();
+        }
+        return count != _count;
+    }
+
+    template<typename T>
+    std::vector<T> RTreeSpatialIndex<T>::query(const cglib::frustum3<double>& frustum) const {
+        std::vector<T> results;
+        queryTree(frustum, results);
+        return results;
+    }
+
+    template<typename T>
+    std::vector<T> RTreeSpatialIndex<T>::query(const cglib::bbox3<double>& bounds) const {
+        std::vector<T> results;
+        queryTree(bounds, results);
+        return results;
+    }
+
+    template<typename T>
+    std::vector<T> RTreeSpatialIndex<T>::getAll() const {
+        std::vector<T> results;
+        results.reserve(_count);
+        for (const Record& record : _records) {
+            if (!record.removed) {
+                results.push_back(record.object);
+            }
+        }
+        for (const Record& record : _pendingRecords) {
+            results.push_back(record.object);
+        }
+        return results;
+    }
+
+    template<typename T>
+    RTreeSpatialIndex<T>::Record::Record(const cglib::bbox3<double>& bounds, const T& object) :
+        bounds(bounds),
+        object(object),
+        removed(false)
+    {
+    }
+
+    template<typename T>
+    void RTreeSpatialIndex<T>::rebuild() {
+        // Collect all live records
+        std::vector<Record> records;
+        records.reserve(_count);
+        for (Record& record : _records) {
+            if (!record.removed) {
+                records.push_back(std::move(record));
+            }
+        }
+        for (Record& record : _pendingRecords) {
+            records.push_back(std::move(record));
+        }
+        std::swap(_records, records);
+        _pendingRecords.clear();
+        _removedCount = 0;
+        _nodeBounds.clear();
+        _levelOffsets.clear();
+        if (_records.empty()) {
+            return;
+        }
+
+        // Order records so that consecutive NODE_SIZE records form compact leaves.
+        // Only axes with non-zero extent are used, in case of planar surface this gives 2D tiling.
+        cglib::bbox3<double> totalBounds = cglib::bbox3<double>::smallest();
+        std::vector<std::pair<cglib::vec3<double>, std::size_t> > centers;
+        centers.reserve(_records.size());
+        for (std::size_t i = 0; i < _records.size(); i++) {
+            totalBounds.add(_records[i].bounds);
+            centers.emplace_back(_records[i].bounds.center(), i);
+        }
+        std::vector<int> axes;
+        for (int axis = 0; axis < 3; axis++) {
+            if (totalBounds.size()(axis) > 0) {
+                axes.push_back(axis);
+            }
+        }
+        sortRecords(centers, 0, centers.size(), axes, 0);
+        records.clear();
+        records.reserve(_records.size());
+        for (const std::pair<cglib::vec3<double>, std::size_t>& center : centers) {
+            records.push_back(std::move(_records[center.second]));
+        }
+        std::swap(_records, records);
+
+        // Build leaf level
+        _levelOffsets.push_back(0);
+        for (std::size_t i = 0; i < _records.size(); i += NODE_SIZE) {
+            cglib::bbox3<double> bounds = cglib::bbox3<double>::smallest();
+            std::size_t end = std::min(i + NODE_SIZE, _records.size());
+            for (std::size_t j = i; j < end; j++) {
+                bounds.add(_records[j].bounds);
+            }
+            _nodeBounds.push_back(bounds);
+        }
+        _levelOffsets.push_back(_nodeBounds.size());
+
+        // Build upper levels until a single root node remains
+        while (_levelOffsets[_levelOffsets.size() - 1] - _levelOffsets[_levelOffsets.size() - 2] > 1) {
+            std::size_t begin = _levelOffsets[_levelOffsets.size() - 2];
+            std::size_t end = _levelOffsets[_levelOffsets.size() - 1];
+            for (std::size_t i = begin; i < end; i += NODE_SIZE) {
+                cglib::bbox3<double> bounds = cglib::bbox3<double>::smallest();
+                for (std::size_t j = i; j < std::min(i + NODE_SIZE, end); j++) {
+                    bounds.add(_nodeBounds[j]);
+                }
+                _nodeBounds.push_back(bounds);
+            }
+            _levelOffsets.push_back(_nodeBounds.size());
+        }
+    }
+
+    template<typename T>
+    void RTreeSpatialIndex<T>::sortRecords(std::vector<std::pair<cglib::vec3<double>, std::size_t> >& centers, std::size_t begin, std::size_t end, const std::vector<int>& axes, std::size_t axisIndex) const {
+        if (axisIndex >= axes.size()) {
+            return;
+        }
+        int axis = axes[axisIndex];
+        std::sort(centers.begin() + begin, centers.begin() + end, [axis](const std::pair<cglib::vec3<double>, std::size_t>& center1, const std::pair<cglib::vec3<double>, std::size_t>& center2) {
+            return center1.first(axis) < center2.first(axis);
+        });
+        if (axisIndex + 1 >= axes.size()) {
+            return;
+        }
+
+        // Split into slabs along the current axis, each slab is sorted along the next axis
+        std::size_t count = end - begin;
+        std::size_t leafCount = (count + NODE_SIZE - 1) / NODE_SIZE;
+        std::size_t sliceCount = static_cast<std::size_t>(std::ceil(std::pow(static_cast<double>(leafCount), 1.0 / (axes.size() - axisIndex))));
+        std::size_t sliceSize = ((leafCount + sliceCount - 1) / sliceCount) * NODE_SIZE;
+        for (std::size_t i = begin; i < end; i += sliceSize) {
+            sortRecords(centers, i, std::min(i + sliceSize, end), axes, axisIndex + 1);
+        }
+    }
+
+    template<typename T>
+    template<typename Bounds>
+    void RTreeSpatialIndex<T>::queryTree(const Bounds& bounds, std::vector<T>& results) const {
+        if (!_levelOffsets.empty()) {
+            std::vector<std::pair<std::size_t, std::size_t> > stack; // level, node index
+            stack.emplace_back(_levelOffsets.size() - 2, 0);
+            while (!stack.empty()) {
+                std::size_t level = stack.back().first;
+                std::size_t index = stack.back().second;
+                stack.pop_back();
+                if (!bounds.inside(_nodeBounds[_levelOffsets[level] + index])) {
+                    continue;
+                }
+                if (level == 0) {
+                    std::size_t end = std::min((index + 1) * NODE_SIZE, _records.size());
+                    for (std::size_t i = index * NODE_SIZE; i < end; i++) {
+                        const Record& record = _records[i];
+                        if (!record.removed && bounds.inside(record.bounds)) {
+                            results.push_back(record.object);
+                        }
+                    }
+                } else {
+                    std::size_t end = std::min((index + 1) * NODE_SIZE, _levelOffsets[level] - _levelOffsets[level - 1]);
+                    for (std::size_t i = index * NODE_SIZE; i < end; i++) {
+                        stack.emplace_back(level - 1, i);
+                    }
+                }
+            }
+        }
+
+        for (const Record& record : _pendingRecords) {
+            if (bounds.inside(record.bounds)) {
+                results.push_back(record.object);
+            }
+        }
+    }
+
+    template<typename T>
+    const std::size_t RTreeSpatialIndex<T>::NODE_SIZE = 16;
+
+    template<typename T>
+    const std::size_t RTreeSpatialIndex<T>::MIN_PENDING_COUNT = 64;
+
+    template<typename T>
+    const std::size_t RTreeSpatialIndex<T>::PENDING_RATIO = 64;
+
+}
+
+#endif
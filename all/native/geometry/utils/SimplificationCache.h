@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_SIMPLIFICATIONCACHE_H_
+#define _CARTO_SIMPLIFICATIONCACHE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+namespace carto {
+    class ProjectionSurface;
+
+    /**
+     * Cache for simplification results of a single tolerance level.
+     * Simplifier scales are quantized into discrete levels, so that results can be reused
+     * while the view is panned or zoomed only slightly. When the level or the projection surface changes,
+     * the cache is reset. Within a level, the least recently used entries are evicted once the capacity is exceeded.
+     * The class is not thread safe, the owner must synchronize access.
+     */
+    template <typename T>
+    class SimplificationCache {
+    public:
+        explicit SimplificationCache(std::size_t capacity = DEFAULT_CAPACITY);
+
+        std::size_t size() const;
+        std::size_t getCapacity() const;
+        void setCapacity(std::size_t capacity);
+
+        float update(float scale, const std::shared_ptr<ProjectionSurface>& projectionSurface);
+
+        bool get(long long id, T& value);
+        void put(long long id, const T& value);
+        void remove(long long id);
+        void clear();
+
+    private:
+        typedef std::list<std::pair<long long, T> > EntryList;
+
+        static const int LEVELS_PER_OCTAVE = 4;
+        static const std::size_t DEFAULT_CAPACITY = 16384;
+
+        void evictEntries();
+
+        int _level;
+        std::shared_ptr<ProjectionSurface> _projectionSurface;
+        std::size_t _capacity;
+        EntryList _entries; // most recently used first
+        std::unordered_map<long long, typename EntryList::iterator> _entryMap;
+    };
+
+    template <typename T>
+    SimplificationCache<T>::SimplificationCache(std::size_t capacity) :
+        _level(0),
+        _projectionSurface(),
+        _capacity(capacity),
+        _entries(),
+        _entryMap()
+    {
+    }
+
+    template <typename T>
+    std::size_t SimplificationCache<T>::size() const {
+        return _entryMap.size();
+    }
+
+    template <typename T>
+    std::size_t SimplificationCache<T>::getCapacity() const {
+        return _capacity;
+    }
+
+    template <typename T>
+    void SimplificationCache<T>::setCapacity(std::size_t capacity) {
+        _capacity = capacity;
+        evictEntries();
+    }
+
+    template <typename T>
+    float SimplificationCache<T>::update(float scale, const std::shared_ptr<ProjectionSurface>& projectionSurface) {
+        // Round the scale to the nearest level, the simplifier tolerance will differ by less than 10% from the requested one
+        int level = static_cast<int>(std::floor(std::log2(std::max(scale, 1.0e-30f)) * LEVELS_PER_OCTAVE + 0.5f));
+        if (level != _level || projectionSurface != _projectionSurface) {
+            clear();
+            _level = level;
+            _projectionSurface = projectionSurface;
+        }
+        return std::pow(2.0f, static_cast<float>(level) / LEVELS_PER_OCTAVE);
+    }
+
+    template <typename T>
+    bool SimplificationCache<T>::get(long long id, T& value) {
+        auto it = _entryMap.find(id);
+        if (it == _entryMap.end()) {
+            return false;
+        }
+        _entries.splice(_entries.begin(), _entries, it->second);
+        value = it->second->second;
+        return true;
+    }
+
+    template <typename T>
+    void SimplificationCache<T>::put(long long id, const T& value) {
+        auto it = _entryMap.find(id);
+        if (it != _entryMap.end()) {
+            it->second->second = value;
+            _entries.splice(_entries.begin(), _entries, it->second);
+            return;
+        }
+        _entries.emplace_front(id, value);
+        _entryMap.emplace(id, _entries.begin());
+        evictEntries();
+    }
+
+    template <typename T>
+    void SimplificationCache<T>::remove(long long id) {
+        auto it = _entryMap.find(id);
+        if (it != _entryMap.end()) {
+            _entries.erase(it->second);
+            _entryMap.erase(it);
+        }
+    }
+
+    template <typename T>
+    void SimplificationCache<T>::clear() {
+        _entries.clear();
+        _entryMap.clear();
+    }
+
+    template <typename T>
+    void SimplificationCache<T>::evictEntries() {
+        while (_entryMap.size() > _capacity) {
+            _entryMap.erase(_entries.back().first);
+            _entries.pop_back();
+        }
+    }
+
+}
+
+#endif
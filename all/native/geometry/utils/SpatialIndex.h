@@ -7,6 +7,7 @@
 #ifndef _CARTO_SPATIALINDEX_H_
 #define _CARTO_SPATIALINDEX_H_
 
+#include <utility>
 #include <vector>
 
 #include <cglib/vec.h>
@@ -25,6 +26,12 @@ namespace carto {
         
         virtual void clear() = 0;
         virtual void insert(const cglib::bbox3<double>& bounds, const T& object) = 0;
+        virtual void insertAll(const std::vector<std::pair<cglib::bbox3<double>, T> >& records) {
+            reserve(size() + records.size());
+            for (const std::pair<cglib::bbox3<double>, T>& record : records) {
+                insert(record.first, record.second);
+            }
+        }
         virtual bool remove(const cglib::bbox3<double>& bounds, const T& object) = 0;
         virtual bool remove(const T& object) = 0;
         
@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 
 #include <stdext/zlib.h>
@@ -76,6 +77,116 @@ namespace {
         return data;
     }
 
+    struct ResampleFilter {
+        std::vector<unsigned int> firstIndices;
+        std::vector<unsigned int> weightOffsets;
+        std::vector<unsigned int> weights;
+    };
+
+    enum { RESAMPLE_WEIGHT_BITS = 12 };
+
+    ResampleFilter createResampleFilter(unsigned int srcSize, unsigned int destSize) {
+        // Input pixel coverage is calculated in 8-bit fixed point. When downsampling, each output pixel is the box-filtered average of the covered input pixels.
+        // When upsampling, output pixels are linearly interpolated between two neighbouring input pixels.
+        // The weights of each output pixel are normalized so that their sum is exactly 1 << RESAMPLE_WEIGHT_BITS.
+        ResampleFilter filter;
+        bool upsample = srcSize < destSize;
+        float f = 256 * srcSize / static_cast<float>(destSize);
+        std::vector<unsigned int> coverages;
+        for (unsigned int i2 = 0; i2 < destSize; i2++) {
+            int i1a = static_cast<int>(i2 * f);
+            int i1b = static_cast<int>((i2 + 1) * f);
+            if (upsample) {
+                i1b = i1a + 256;
+            }
+            i1b = std::min(i1b, static_cast<int>(256 * srcSize - 1));
+            int i1c = i1a >> 8;
+            int i1d = i1b >> 8;
+
+            coverages.clear();
+            unsigned int coverageSum = 0;
+            for (int i = i1c; i <= i1d; i++) {
+                unsigned int coverage = 256;
+                if (i1c != i1d) {
+                    if (i == i1c) {
+                        coverage = 256 - (i1a & 0xFF);
+                    } else if (i == i1d) {
+                        coverage = (i1b & 0xFF);
+                    }
+                }
+                if (coverage == 0) {
+                    break; // only the last input pixel can have zero coverage
+                }
+                coverages.push_back(coverage);
+                coverageSum += coverage;
+            }
+
+            filter.firstIndices.push_back(i1c);
+            filter.weightOffsets.push_back(static_cast<unsigned int>(filter.weights.size()));
+            unsigned int weightSum = 0;
+            unsigned int maxWeight = 0;
+            std::size_t maxIndex = filter.weights.size();
+            for (unsigned int coverage : coverages) {
+                unsigned int weight = (coverageSum > 0 ? static_cast<unsigned int>((static_cast<std::uint64_t>(coverage) << RESAMPLE_WEIGHT_BITS) / coverageSum) : 0);
+                if (weight > maxWeight) {
+                    maxWeight = weight;
+                    maxIndex = filter.weights.size();
+                }
+                filter.weights.push_back(weight);
+                weightSum += weight;
+            }
+            if (!coverages.empty()) {
+                filter.weights[maxIndex] += (1 << RESAMPLE_WEIGHT_BITS) - weightSum; // distribute rounding error
+            }
+        }
+        filter.weightOffsets.push_back(static_cast<unsigned int>(filter.weights.size()));
+        return filter;
+    }
+
+    template <unsigned int N>
+    void resampleBitmap(const unsigned char* src, unsigned int srcWidth, unsigned int srcHeight, unsigned char* dest, unsigned int destWidth, unsigned int destHeight) {
+        // The filter is separable, so first resample all rows horizontally and then the columns vertically.
+        // The channel count is a template parameter, so that the compiler can unroll and vectorize the inner loops.
+        // As the weights of both passes are normalized, the final sums fit into 32 bits and the division is a shift.
+        ResampleFilter filterX = createResampleFilter(srcWidth, destWidth);
+        ResampleFilter filterY = createResampleFilter(srcHeight, destHeight);
+
+        std::vector<unsigned int> rows(static_cast<std::size_t>(srcHeight) * destWidth * N);
+        for (unsigned int y = 0; y < srcHeight; y++) {
+            const unsigned char* srcRow = src + static_cast<std::size_t>(y) * srcWidth * N;
+            unsigned int* row = &rows[static_cast<std::size_t>(y) * destWidth * N];
+            for (unsigned int x2 = 0; x2 < destWidth; x2++, row += N) {
+                unsigned int sums[N] = { 0 };
+                const unsigned char* srcPixel = srcRow + filterX.firstIndices[x2] * N;
+                for (unsigned int i = filterX.weightOffsets[x2]; i < filterX.weightOffsets[x2 + 1]; i++, srcPixel += N) {
+                    unsigned int weight = filterX.weights[i];
+                    for (unsigned int c = 0; c < N; c++) {
+                        sums[c] += srcPixel[c] * weight;
+                    }
+                }
+                for (unsigned int c = 0; c < N; c++) {
+                    row[c] = sums[c];
+                }
+            }
+        }
+
+        std::vector<unsigned int> sums(static_cast<std::size_t>(destWidth) * N);
+        for (unsigned int y2 = 0; y2 < destHeight; y2++) {
+            std::fill(sums.begin(), sums.end(), 1 << (2 * RESAMPLE_WEIGHT_BITS - 1));
+            const unsigned int* row = &rows[static_cast<std::size_t>(filterY.firstIndices[y2]) * destWidth * N];
+            for (unsigned int i = filterY.weightOffsets[y2]; i < filterY.weightOffsets[y2 + 1]; i++, row += destWidth * N) {
+                unsigned int weight = filterY.weights[i];
+                for (std::size_t j = 0; j < sums.size(); j++) {
+                    sums[j] += row[j] * weight;
+                }
+            }
+
+            unsigned char* destRow = dest + static_cast<std::size_t>(y2) * destWidth * N;
+            for (std::size_t j = 0; j < sums.size(); j++) {
+                destRow[j] = static_cast<unsigned char>(sums[j] >> (2 * RESAMPLE_WEIGHT_BITS));
+            }
+        }
+    }
 }
 
 namespace carto {
@@ -257,133 +368,29 @@ namespace carto {
     }
         
     std::shared_ptr<Bitmap> Bitmap::getResizedBitmap(unsigned int width, unsigned int height) const {
-        if (width <= 0 || height <= 0) {
+        if (width <= 0 || height <= 0 || _width <= 0 || _height <= 0) {
             return std::shared_ptr<Bitmap>();
         }
 
         // This will only scale the actual image part, the padding that was previously added to make the image
         // dimensions power of 2 will be ignored
-        const unsigned char* dsrc = _pixelData.data();
         std::vector<unsigned char> pixelData(width * height * _bytesPerPixel);
-        unsigned char* ddest = pixelData.data();
-    
-        bool bUpsampleX = (_width < width);
-        bool bUpsampleY = (_height < height);
-    
-        // If too many input pixels map to one output pixel, our 32-bit accumulation values
-        // could overflow - so, if we have huge mappings like that, cut down the weights:
-        //    256 max color value
-        //   *256 weight_x
-        //   *256 weight_y
-        //   *256 (16*16) maximum # of input pixels (x,y) - unless we cut the weights down...
-        int weight_shift = 0;
-        float source_texels_per_out_pixel = ((_width / static_cast<float>(width + 1))
-                * (_height / static_cast<float>(height + 1)));
-        float weight_per_pixel = source_texels_per_out_pixel * 256 * 256; //weight_x * weight_y
-        float accum_per_pixel = weight_per_pixel * 256; //color value is 0-255
-        float weight_div = accum_per_pixel / 4294967000.0f;
-        if (weight_div > 1) {
-            weight_shift = static_cast<int>(ceilf(logf(weight_div) / logf(2)));
-        }
-        weight_shift = std::min(15, weight_shift); // this could go to 15 and still be ok.
-    
-        float fh = 256 * _height / static_cast<float>(height);
-        float fw = 256 * _width / static_cast<float>(width);
-        // Cache x1a, x1b for all the columns
-    
-        std::vector<int> g_px1ab(width * 2 * 2);
-    
-        for (std::size_t x2 = 0; x2 < width; x2++) {
-            // Find the x-range of input pixels that will contribute:
-            int x1a = static_cast<int>((x2) * fw);
-            int x1b = static_cast<int>((x2 + 1) * fw);
-            if (bUpsampleX) {
-                // Map to same pixel -> we want to interpolate between two pixels!
-                x1b = x1a + 256;
-            }
-            x1b = std::min(x1b, static_cast<int>(256 * _width - 1));
-            g_px1ab[x2 * 2 + 0] = x1a;
-            g_px1ab[x2 * 2 + 1] = x1b;
-        }
-    
-        // For every output pixel
-        for (std::size_t y2 = 0; y2 < height; y2++) {
-            // Find the y-range of input pixels that will contribute:
-            int y1a = static_cast<int>((y2) * fh);
-            int y1b = static_cast<int>((y2 + 1) * fh);
-            if (bUpsampleY) {
-                // Map to same pixel -> we want to interpolate between two pixels!
-                y1b = y1a + 256;
-            }
-            y1b = std::min(y1b, static_cast<int>(256 * _height - 1));
-            int y1c = y1a >> 8;
-            int y1d = y1b >> 8;
-    
-            for (std::size_t x2 = 0; x2 < width; x2++) {
-                // Find the x-range of input pixels that will contribute
-                int x1a = g_px1ab[x2 * 2 + 0];
-                int x1b = g_px1ab[x2 * 2 + 1];
-                int x1c = x1a >> 8;
-                int x1d = x1b >> 8;
-    
-                // Add ip all input pixels contributing to this output pixel
-                unsigned int r = 0, g = 0, b = 0, a = 0, wa = 0;
-                for (int y = y1c; y <= y1d; y++) {
-                    unsigned int weight_y = 256;
-                    if (y1c != y1d) {
-                        if (y == y1c) {
-                            weight_y = 256 - (y1a & 0xFF);
-                        } else if (y == y1d) {
-                            weight_y = (y1b & 0xFF);
-                        }
-                    }
-    
-                    const unsigned char* dsrc2 = &dsrc[y * _width * _bytesPerPixel + x1c * _bytesPerPixel];
-                    for (int x = x1c; x <= x1d; x++) {
-                        unsigned int weight_x = 256;
-                        if (x1c != x1d) {
-                            if (x == x1c) {
-                                weight_x = 256 - (x1a & 0xFF);
-                            } else if (x == x1d) {
-                                weight_x = (x1b & 0xFF);
-                            }
-                        }
-    
-                        unsigned int w = (weight_x * weight_y) >> weight_shift;
-
-                        unsigned char r_src = *dsrc2++;
-                        r += r_src * w;
-                        if (_bytesPerPixel > 1) {
-                            unsigned char g_src = *dsrc2++;
-                            g += g_src * w;
-                        }
-                        if (_bytesPerPixel > 2) {
-                            unsigned char b_src = *dsrc2++;
-                            b += b_src * w;
-                        }
-                        if (_bytesPerPixel > 3) {
-                            unsigned char a_src = *dsrc2++;
-                            a += a_src * w;
-                        }
-                        wa += w;
-                    }
-                }
-                if (wa <= 0) {
-                    wa = std::numeric_limits<int>::max();
-                }
-    
-                // Write results
-                *ddest++ = r / wa;
-                if (_bytesPerPixel > 1) {
-                    *ddest++ = g / wa;
-                }
-                if (_bytesPerPixel > 2) {
-                    *ddest++ = b / wa;
-                }
-                if (_bytesPerPixel > 3) {
-                    *ddest++ = a / wa;
-                }
-            }
+        switch (_bytesPerPixel) {
+        case 1:
+            resampleBitmap<1>(_pixelData.data(), _width, _height, pixelData.data(), width, height);
+            break;
+        case 2:
+            resampleBitmap<2>(_pixelData.data(), _width, _height, pixelData.data(), width, height);
+            break;
+        case 3:
+            resampleBitmap<3>(_pixelData.data(), _width, _height, pixelData.data(), width, height);
+            break;
+        case 4:
+            resampleBitmap<4>(_pixelData.data(), _width, _height, pixelData.data(), width, height);
+            break;
+        default:
+            Log::Error("Bitmap::getResizedBitmap: Failed to resize bitmap due to unsupported color format");
+            return std::shared_ptr<Bitmap>();
         }
         
         return std::make_shared<Bitmap>(pixelData.data(), width, height, _colorFormat, -static_cast<int>(width * _bytesPerPixel));
@@ -416,76 +423,69 @@ namespace carto {
     }
     
     std::shared_ptr<Bitmap> Bitmap::getRGBABitmap() const {
-        std::vector<unsigned char> pixelData(_width * _height * 4, 255);
-        for (unsigned int i = 0; i < _height; i++) {
-            for (unsigned int j = 0; j < _width; j++) {
-                unsigned int destIndex = (i * _width + j) * 4;
-                unsigned int srcIndex = (i * _width + j) * _bytesPerPixel;
-                switch (_colorFormat) {
-                case ColorFormat::COLOR_FORMAT_GRAYSCALE:
-                    pixelData[destIndex + 0] = _pixelData[srcIndex];
-                    pixelData[destIndex + 1] = _pixelData[srcIndex];
-                    pixelData[destIndex + 2] = _pixelData[srcIndex];
-                    break;
-                case ColorFormat::COLOR_FORMAT_GRAYSCALE_ALPHA:
-                    pixelData[destIndex + 0] = _pixelData[srcIndex];
-                    pixelData[destIndex + 1] = _pixelData[srcIndex];
-                    pixelData[destIndex + 2] = _pixelData[srcIndex];
-                    pixelData[destIndex + 3] = _pixelData[srcIndex + 1];
-                    break;
-                case ColorFormat::COLOR_FORMAT_RGB:
-                    pixelData[destIndex + 0] = _pixelData[srcIndex + 0];
-                    pixelData[destIndex + 1] = _pixelData[srcIndex + 1];
-                    pixelData[destIndex + 2] = _pixelData[srcIndex + 2];
-                    break;
-                case ColorFormat::COLOR_FORMAT_RGBA:
-                    pixelData[destIndex + 0] = _pixelData[srcIndex + 0];
-                    pixelData[destIndex + 1] = _pixelData[srcIndex + 1];
-                    pixelData[destIndex + 2] = _pixelData[srcIndex + 2];
-                    pixelData[destIndex + 3] = _pixelData[srcIndex + 3];
-                    break;
-                case ColorFormat::COLOR_FORMAT_BGRA:
-                    pixelData[destIndex + 0] = _pixelData[srcIndex + 2];
-                    pixelData[destIndex + 1] = _pixelData[srcIndex + 1];
-                    pixelData[destIndex + 2] = _pixelData[srcIndex + 0];
-                    pixelData[destIndex + 3] = _pixelData[srcIndex + 3];
-                    break;
-                case ColorFormat::COLOR_FORMAT_RGBA_4444:
-                    {
-                        unsigned short color = *reinterpret_cast<const unsigned short*>(&_pixelData[srcIndex]);
-                        unsigned char r = (color & 0xF000) >> 8;
-                        r = r | (r >> 4);
-                        unsigned char g = (color & 0xF00) >> 4;
-                        g = g | (g >> 4);
-                        unsigned char b = (color & 0xF0);
-                        b = b | (b >> 4);
-                        unsigned char a = (color & 0xF) << 4;
-                        a = a | (a >> 4);
-                        pixelData[destIndex + 0] = r;
-                        pixelData[destIndex + 1] = g;
-                        pixelData[destIndex + 2] = b;
-                        pixelData[destIndex + 3] = a;
-                    }
-                    break;
-                case ColorFormat::COLOR_FORMAT_RGB_565:
-                    {
-                        unsigned short color = *reinterpret_cast<const unsigned short*>(&_pixelData[srcIndex]);
-                        unsigned char r = (color & 0xF800) >> 8;
-                        r = r | (r >> 5);
-                        unsigned char g = (color & 0x7E0) >> 3;
-                        g = g | (g >> 6);
-                        unsigned char b = (color & 0x1F) << 3;
-                        b = b | (b >> 5);
-                        pixelData[destIndex + 0] = r;
-                        pixelData[destIndex + 1] = g;
-                        pixelData[destIndex + 2] = b;
-                    }
-                    break;
-                default:
-                    Log::Error("Bitmap::getRGBABitmap: Failed to convert bitmap due to unsupported color format");
-                    break;
-                }
+        std::size_t pixelCount = static_cast<std::size_t>(_width) * _height;
+        std::vector<unsigned char> pixelData(pixelCount * 4, 255);
+        const unsigned char* src = _pixelData.data();
+        unsigned char* dest = pixelData.data();
+
+        // Use separate loop for each format, so that the inner loops do not contain branches
+        switch (_colorFormat) {
+        case ColorFormat::COLOR_FORMAT_GRAYSCALE:
+            for (std::size_t i = 0; i < pixelCount; i++, src += 1, dest += 4) {
+                dest[0] = dest[1] = dest[2] = src[0];
             }
+            break;
+        case ColorFormat::COLOR_FORMAT_GRAYSCALE_ALPHA:
+            for (std::size_t i = 0; i < pixelCount; i++, src += 2, dest += 4) {
+                dest[0] = dest[1] = dest[2] = src[0];
+                dest[3] = src[1];
+            }
+            break;
+        case ColorFormat::COLOR_FORMAT_RGB:
+            for (std::size_t i = 0; i < pixelCount; i++, src += 3, dest += 4) {
+                dest[0] = src[0];
+                dest[1] = src[1];
+                dest[2] = src[2];
+            }
+            break;
+        case ColorFormat::COLOR_FORMAT_RGBA:
+            std::copy(_pixelData.begin(), _pixelData.end(), pixelData.begin());
+            break;
+        case ColorFormat::COLOR_FORMAT_BGRA:
+            for (std::size_t i = 0; i < pixelCount; i++, src += 4, dest += 4) {
+                dest[0] = src[2];
+                dest[1] = src[1];
+                dest[2] = src[0];
+                dest[3] = src[3];
+            }
+            break;
+        case ColorFormat::COLOR_FORMAT_RGBA_4444:
+            for (std::size_t i = 0; i < pixelCount; i++, src += 2, dest += 4) {
+                unsigned short color = *reinterpret_cast<const unsigned short*>(src);
+                unsigned char r = (color & 0xF000) >> 8;
+                unsigned char g = (color & 0xF00) >> 4;
+                unsigned char b = (color & 0xF0);
+                unsigned char a = (color & 0xF) << 4;
+                dest[0] = r | (r >> 4);
+                dest[1] = g | (g >> 4);
+                dest[2] = b | (b >> 4);
+                dest[3] = a | (a >> 4);
+            }
+            break;
+        case ColorFormat::COLOR_FORMAT_RGB_565:
+            for (std::size_t i = 0; i < pixelCount; i++, src += 2, dest += 4) {
+                unsigned short color = *reinterpret_cast<const unsigned short*>(src);
+                unsigned char r = (color & 0xF800) >> 8;
+                unsigned char g = (color & 0x7E0) >> 3;
+                unsigned char b = (color & 0x1F) << 3;
+                dest[0] = r | (r >> 5);
+                dest[1] = g | (g >> 6);
+                dest[2] = b | (b >> 5);
+            }
+            break;
+        default:
+            Log::Error("Bitmap::getRGBABitmap: Failed to convert bitmap due to unsupported color format");
+            break;
         }
         
         // Create new bitmap
@@ -101,7 +101,7 @@ namespace carto {
     }
 
     std::shared_ptr<AssetPackage> CartoVectorTileLayer::CreateStyleAssetPackage() {
-        auto styleAsset = std::make_shared<BinaryData>(cartostyles_v2_zip, cartostyles_v2_zip_len);
+        auto styleAsset = std::make_shared<BinaryData>(cartostyles_v2_zip, cartostyles_v2_zip_len, std::shared_ptr<const void>()); // NOTE: static data, no need to copy
         return std::make_shared<ZippedAssetPackage>(styleAsset);
     }
 
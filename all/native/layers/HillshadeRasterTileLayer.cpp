@@ -6,6 +6,7 @@
 
 #include <array>
 #include <algorithm>
+#include <cstring>
 
 #include <vt/TileId.h>
 #include <vt/Tile.h>
@@ -15,6 +16,50 @@
 #include <vt/TileLayerBuilder.h>
 #include <vt/NormalMapBuilder.h>
 
+namespace {
+
+    std::vector<std::uint32_t> createHeightMapData(const carto::Bitmap& bitmap) {
+        // Pack the pixels directly into RGBA words, without creating an intermediate RGBA bitmap
+        std::size_t pixelCount = static_cast<std::size_t>(bitmap.getWidth()) * bitmap.getHeight();
+        std::vector<std::uint32_t> data(pixelCount);
+        const std::uint8_t* src = bitmap.getPixelData().data();
+        std::uint8_t* dest = reinterpret_cast<std::uint8_t*>(data.data());
+        switch (bitmap.getColorFormat()) {
+        case carto::ColorFormat::COLOR_FORMAT_GRAYSCALE:
+            for (std::size_t i = 0; i < pixelCount; i++, src += 1, dest += 4) {
+                dest[0] = dest[1] = dest[2] = src[0];
+                dest[3] = 255;
+            }
+            break;
+        case carto::ColorFormat::COLOR_FORMAT_GRAYSCALE_ALPHA:
+            for (std::size_t i = 0; i < pixelCount; i++, src += 2, dest += 4) {
+                dest[0] = dest[1] = dest[2] = src[0];
+                dest[3] = src[1];
+            }
+            break;
+        case carto::ColorFormat::COLOR_FORMAT_RGB:
+            for (std::size_t i = 0; i < pixelCount; i++, src += 3, dest += 4) {
+                dest[0] = src[0];
+                dest[1] = src[1];
+                dest[2] = src[2];
+                dest[3] = 255;
+            }
+            break;
+        case carto::ColorFormat::COLOR_FORMAT_RGBA:
+            std::memcpy(dest, src, pixelCount * 4);
+            break;
+        default:
+            {
+                std::shared_ptr<carto::Bitmap> rgbaBitmap = bitmap.getRGBABitmap();
+                std::memcpy(dest, rgbaBitmap->getPixelData().data(), pixelCount * 4);
+            }
+            break;
+        }
+        return data;
+    }
+
+}
+
 namespace carto {
 
     HillshadeRasterTileLayer::HillshadeRasterTileLayer(const std::shared_ptr<TileDataSource>& dataSource) :
@@ -118,10 +163,7 @@ namespace carto {
         
         // Build normal map from height map
         vt::TileId vtTileId(tile.getZoom(), tile.getX(), tile.getY());
-        std::shared_ptr<Bitmap> rgbaBitmap = bitmap->getRGBABitmap();
-        auto rgbaBitmapDataPtr = reinterpret_cast<const std::uint32_t*>(rgbaBitmap->getPixelData().data());
-        std::vector<std::uint32_t> rgbaBitmapData(rgbaBitmapDataPtr, rgbaBitmapDataPtr + rgbaBitmap->getWidth() * rgbaBitmap->getHeight());
-        auto vtBitmap = std::make_shared<vt::Bitmap>(rgbaBitmap->getWidth(), rgbaBitmap->getHeight(), std::move(rgbaBitmapData));
+        auto vtBitmap = std::make_shared<vt::Bitmap>(bitmap->getWidth(), bitmap->getHeight(), createHeightMapData(*bitmap));
         vt::NormalMapBuilder normalMapBuilder(scales, alpha);
         std::shared_ptr<const vt::Bitmap> normalMap = normalMapBuilder.buildNormalMapFromHeightMap(vtTileId, vtBitmap);
         auto normalMapDataPtr = reinterpret_cast<const std::uint8_t*>(normalMap->data.data());
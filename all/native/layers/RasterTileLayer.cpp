@@ -75,11 +75,13 @@ namespace carto {
     RasterTileLayer::RasterTileLayer(const std::shared_ptr<TileDataSource>& dataSource) :
         TileLayer(dataSource),
         _tileFilterMode(RasterTileFilterMode::RASTER_TILE_FILTER_MODE_BILINEAR),
+        _overzoomTextureSharing(true),
         _rasterTileEventListener(),
         _visibleTileIds(),
         _tempDrawDatas(),
         _visibleCache(128 * 1024 * 1024), // limit should be never reached during normal use cases
-        _preloadingCache(DEFAULT_PRELOADING_CACHE_SIZE)
+        _preloadingCache(DEFAULT_PRELOADING_CACHE_SIZE),
+        _overzoomParentTiles()
     {
         setCullDelay(DEFAULT_CULL_DELAY);
     }
@@ -110,6 +112,22 @@ namespace carto {
         redraw();
     }
 
+    bool RasterTileLayer::isOverzoomTextureSharing() const {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return _overzoomTextureSharing;
+    }
+
+    void RasterTileLayer::setOverzoomTextureSharing(bool enabled) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            if (_overzoomTextureSharing == enabled) {
+                return;
+            }
+            _overzoomTextureSharing = enabled;
+        }
+        tilesChanged(false);
+    }
+
     std::shared_ptr<RasterTileEventListener> RasterTileLayer::getRasterTileEventListener() const {
         return _rasterTileEventListener.get();
     }
@@ -145,7 +163,7 @@ namespace carto {
     
     void RasterTileLayer::fetchTile(const MapTile& tile, bool preloadingTile, bool invalidated) {
         long long tileId = tile.getTileId();
-        if (_fetchingTiles.exists(tile.getTileId())) {
+        if (_fetchingTiles.reuse(tileId, preloadingTile)) {
             return;
         }
 
@@ -185,6 +203,7 @@ namespace carto {
             _preloadingCache.clear();
         } else {
             _visibleCache.clear();
+            _overzoomParentTiles.clear();
         }
     }
 
@@ -204,6 +223,10 @@ namespace carto {
             _visibleCache.invalidate_all(std::chrono::steady_clock::now());
             _preloadingCache.clear();
         }
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+            _overzoomParentTiles.clear();
+        }
         refresh();
     }
 
@@ -448,40 +471,78 @@ namespace carto {
                 break;
             }
     
-            // Save tile to texture cache, unless invalidated
-            vt::TileId vtTile(_tile.getZoom(), _tile.getX(), _tile.getY());
-            vt::TileId vtDataSourceTile(dataSourceTile.getZoom(), dataSourceTile.getX(), dataSourceTile.getY());
-            std::shared_ptr<Bitmap> bitmap = Bitmap::CreateFromCompressed(tileData->getData());
-            if (bitmap) {
-                // Check if we received the requested tile or extract/scale the corresponding part
-                if (dataSourceTile != _tile) {
-                    bitmap = ExtractSubTile(_tile, dataSourceTile, bitmap);
+            // Check if the tile can share the already loaded parent tile
+            bool shareParentTile = false;
+            std::shared_ptr<vt::TileTransformer> tileTransformer;
+            std::shared_ptr<const vt::Tile> vtTile;
+            {
+                std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
+                shareParentTile = dataSourceTile != _tile && layer->_overzoomTextureSharing;
+                tileTransformer = layer->getTileTransformer();
+                if (shareParentTile) {
+                    auto it = layer->_overzoomParentTiles.find(dataSourceTile.getTileId());
+                    if (it != layer->_overzoomParentTiles.end()) {
+                        vtTile = it->second.lock();
+                    }
                 }
-                std::shared_ptr<vt::TileTransformer> tileTransformer = layer->getTileTransformer();
-                std::shared_ptr<vt::Tile> vtTile = layer->createVectorTile(_tile, bitmap);
-                std::size_t vtTileSize = EXTRA_TILE_FOOTPRINT + vtTile->getResidentSize();
-
-                if (!isInvalidated()) {
-                    // Build the bitmap object
-                    std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
-                    if (layer->getTileTransformer() == tileTransformer) { // extra check that the tile is created with correct transformer. Otherwise simply drop it.
-                        if (isPreloading()) {
-                            layer->_preloadingCache.put(_tile.getTileId(), vtTile, vtTileSize);
-                            if (tileData->getMaxAge() >= 0) {
-                                layer->_preloadingCache.invalidate(_tile.getTileId(), std::chrono::steady_clock::now() + std::chrono::milliseconds(tileData->getMaxAge()));
-                            }
-                        } else {
-                            layer->_visibleCache.put(_tile.getTileId(), vtTile, vtTileSize);
-                            if (tileData->getMaxAge() >= 0) {
-                                layer->_visibleCache.invalidate(_tile.getTileId(), std::chrono::steady_clock::now() + std::chrono::milliseconds(tileData->getMaxAge()));
+            }
+
+            if (!vtTile) {
+                std::shared_ptr<Bitmap> bitmap = Bitmap::CreateFromCompressed(tileData->getData());
+                if (!bitmap) {
+                    Log::Error("RasterTileLayer::FetchTask: Failed to decode tile");
+                    break;
+                }
+
+                if (shareParentTile) {
+                    // Build the parent tile, the renderer will draw only the part covered by this tile and magnify it using the tile filter mode
+                    vtTile = layer->createVectorTile(dataSourceTile, bitmap);
+                } else {
+                    // Check if we received the requested tile or extract/scale the corresponding part
+                    if (dataSourceTile != _tile) {
+                        bitmap = ExtractSubTile(_tile, dataSourceTile, bitmap);
+                    }
+                    vtTile = layer->createVectorTile(_tile, bitmap);
+                }
+            }
+
+            // Shared parent tiles are accounted proportionally to the covered area
+            std::size_t vtTileSize = vtTile->getResidentSize();
+            if (shareParentTile) {
+                int shift = 2 * (_tile.getZoom() - dataSourceTile.getZoom());
+                vtTileSize = (shift < static_cast<int>(sizeof(std::size_t) * 8) ? vtTileSize >> shift : 0);
+            }
+            vtTileSize += EXTRA_TILE_FOOTPRINT;
+
+            // Save tile to texture cache, unless invalidated
+            if (!isInvalidated()) {
+                std::lock_guard<std::recursive_mutex> lock(layer->_mutex);
+                if (layer->getTileTransformer() == tileTransformer) { // extra check that the tile is created with correct transformer. Otherwise simply drop it.
+                    if (shareParentTile) {
+                        for (auto it = layer->_overzoomParentTiles.begin(); it != layer->_overzoomParentTiles.end(); ) {
+                            if (it->second.expired()) {
+                                it = layer->_overzoomParentTiles.erase(it);
+                            } else {
+                                it++;
                             }
                         }
+                        layer->_overzoomParentTiles[dataSourceTile.getTileId()] = vtTile;
+                    }
+
+                    if (isPreloading()) {
+                        layer->_preloadingCache.put(_tile.getTileId(), vtTile, vtTileSize);
+                        if (tileData->getMaxAge() >= 0) {
+                            layer->_preloadingCache.invalidate(_tile.getTileId(), std::chrono::steady_clock::now() + std::chrono::milliseconds(tileData->getMaxAge()));
+                        }
+                    } else {
+                        layer->_visibleCache.put(_tile.getTileId(), vtTile, vtTileSize);
+                        if (tileData->getMaxAge() >= 0) {
+                            layer->_visibleCache.invalidate(_tile.getTileId(), std::chrono::steady_clock::now() + std::chrono::milliseconds(tileData->getMaxAge()));
+                        }
                     }
                 }
-                refresh = true; // NOTE: need to refresh even when invalidated
-            } else {
-                Log::Error("RasterTileLayer::FetchTask: Failed to decode tile");
             }
+            refresh = true; // NOTE: need to refresh even when invalidated
             break;
         }
         
@@ -16,6 +16,7 @@
 #include <atomic>
 #include <memory>
 #include <map>
+#include <unordered_map>
 
 #include <stdext/timed_lru_cache.h>
 
@@ -90,6 +91,19 @@ namespace carto {
          */
         void setTileFilterMode(RasterTileFilterMode::RasterTileFilterMode filterMode);
 
+        /**
+         * Returns true if overzoomed tiles share the texture of the loaded parent tile.
+         * @return True if overzoomed tiles share the parent tile texture. The default is true.
+         */
+        bool isOverzoomTextureSharing() const;
+        /**
+         * Sets the overzoomed tile texture sharing mode. When enabled, tiles that are not available from the data source
+         * are drawn using the texture of the loaded parent tile, magnified by the GPU using the current tile filter mode.
+         * When disabled, the corresponding part of the parent tile is extracted and resized to a separate texture for each tile.
+         * @param enabled True if overzoomed tiles should share the parent tile texture.
+         */
+        void setOverzoomTextureSharing(bool enabled);
+
         /**
          * Returns the raster tile event listener.
          * @return The raster tile event listener.
@@ -142,6 +156,7 @@ namespace carto {
         virtual void unregisterDataSourceListener();
 
         RasterTileFilterMode::RasterTileFilterMode _tileFilterMode;
+        bool _overzoomTextureSharing;
 
     private:    
         static const int DEFAULT_CULL_DELAY;
@@ -157,6 +172,8 @@ namespace carto {
         
         cache::timed_lru_cache<long long, std::shared_ptr<const vt::Tile> > _visibleCache;
         cache::timed_lru_cache<long long, std::shared_ptr<const vt::Tile> > _preloadingCache;
+
+        std::unordered_map<long long, std::weak_ptr<const vt::Tile> > _overzoomParentTiles;
     };
     
 }
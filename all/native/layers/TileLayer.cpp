@@ -2,6 +2,7 @@
 #include "core/BinaryData.h"
 #include "components/Exceptions.h"
 #include "components/CancelableTask.h"
+#include "components/CancelableThreadPool.h"
 #include "datasources/components/TileData.h"
 #include "layers/TileLoadListener.h"
 #include "layers/UTFGridEventListener.h"
@@ -258,20 +259,23 @@ namespace carto {
             }
         }
     
-        // Cancel old tasks
-        for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getTasks()) {
-            task->cancel();
-        }
+        // Mark old tasks as stale. Tasks for tiles that are requested again will be reused, the rest will be canceled.
+        _fetchingTiles.startGeneration();
         
         // Check if layer should be drawn
         if (!isVisible() || !getVisibleZoomRange().inRange(cullState->getViewState().getZoom()) || getOpacity() <= 0) {
+            for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getStaleTasks()) {
+                task->cancel();
+            }
+
             _calculatingTiles = false;
 
             refreshDrawData(cullState);
             return;
         }
         
-        if (!_lastCullState || _frameNr != _lastFrameNr || cullState->getViewState().getModelviewProjectionMat() != _lastCullState->getViewState().getModelviewProjectionMat()) {
+        bool viewChanged = !_lastCullState || _frameNr != _lastFrameNr || cullState->getViewState().getModelviewProjectionMat() != _lastCullState->getViewState().getModelviewProjectionMat();
+        if (viewChanged) {
             // If the view has changed calculate new visible tiles, otherwise use the old ones
             calculateVisibleTiles(cullState);
         }
@@ -294,6 +298,16 @@ namespace carto {
                 }
             }
         }
+
+        // Cancel old tasks that were not requested again
+        for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getStaleTasks()) {
+            task->cancel();
+        }
+
+        // Reorder the queued tasks according to the new tile ranking
+        if (viewChanged) {
+            rescheduleFetchTasks();
+        }
     
         _calculatingTiles = false;
         _refreshedTiles = true;
@@ -418,8 +432,9 @@ namespace carto {
             }
         }
         
-        sortTiles(_visibleTiles, cullState->getViewState(), false);
-        sortTiles(_preloadingTiles, cullState->getViewState(), true);
+        cglib::vec2<double> screenFocus = calculateScreenFocus(cullState->getViewState());
+        sortTiles(_visibleTiles, cullState->getViewState(), screenFocus, false);
+        sortTiles(_preloadingTiles, cullState->getViewState(), screenFocus, true);
     }
 
     void TileLayer::calculateVisibleTilesRecursive(const std::shared_ptr<CullState>& cullState, const MapTile& tile, const MapBounds& dataExtent) {
@@ -473,10 +488,10 @@ namespace carto {
         }
     }
     
-    void TileLayer::sortTiles(std::vector<MapTile>& tiles, const ViewState& viewState, bool preloadingTiles) {
-        typedef std::pair<std::tuple<int, int, double>, MapTile> TaggedMapTile;
+    void TileLayer::sortTiles(std::vector<MapTile>& tiles, const ViewState& viewState, const cglib::vec2<double>& screenFocus, bool preloadingTiles) {
+        typedef std::pair<std::tuple<int, int, double, double>, MapTile> TaggedMapTile;
 
-        // Create tagged tile list. Store parent/child substitution level and distance from camera center
+        // Create tagged tile list. Store parent/child substitution level, screen rank and distance from camera center
         std::vector<TaggedMapTile> taggedTiles;
         taggedTiles.reserve(tiles.size());
         for (const MapTile& mapTile : tiles) {
@@ -494,10 +509,12 @@ namespace carto {
                 }
             }
 
+            double rank = calculateTileRank(mapTile, viewState, screenFocus);
+
             cglib::vec3<double> center = getTileTransformer()->calculateTileOrigin(vt::TileId(mapTile.getZoom(), mapTile.getX(), mapTile.getY()));
             double dist = cglib::length(center - viewState.getCameraPos());
 
-            taggedTiles.emplace_back(std::make_tuple(parentSubstLevel, childSubstLevel, dist), mapTile);
+            taggedTiles.emplace_back(std::make_tuple(parentSubstLevel, childSubstLevel, rank, dist), mapTile);
         }
 
         // Sort tiles
@@ -511,6 +528,70 @@ namespace carto {
         });
     }
     
+    cglib::vec2<double> TileLayer::calculateScreenFocus(const ViewState& viewState) const {
+        if (!_lastCullState) {
+            return cglib::vec2<double>(0, 0);
+        }
+
+        // Project the last focus point using the current view. If the camera is moving,
+        // the last focus point moves away from the screen center in the opposite direction of the motion.
+        const cglib::mat4x4<double>& mvpMat = viewState.getModelviewProjectionMat();
+        const cglib::vec3<double>& lastFocusPos = _lastCullState->getViewState().getFocusPos();
+        double w = lastFocusPos(0) * mvpMat(3, 0) + lastFocusPos(1) * mvpMat(3, 1) + lastFocusPos(2) * mvpMat(3, 2) + mvpMat(3, 3);
+        if (w <= 0) {
+            return cglib::vec2<double>(0, 0);
+        }
+        double x = (lastFocusPos(0) * mvpMat(0, 0) + lastFocusPos(1) * mvpMat(0, 1) + lastFocusPos(2) * mvpMat(0, 2) + mvpMat(0, 3)) / w;
+        double y = (lastFocusPos(0) * mvpMat(1, 0) + lastFocusPos(1) * mvpMat(1, 1) + lastFocusPos(2) * mvpMat(1, 2) + mvpMat(1, 3)) / w;
+
+        // Extrapolate the motion, so that tiles in the direction of the motion are loaded first
+        double focusX = std::max(-1.0, std::min(1.0, -x * CAMERA_MOTION_LOOKAHEAD));
+        double focusY = std::max(-1.0, std::min(1.0, -y * CAMERA_MOTION_LOOKAHEAD));
+        return cglib::vec2<double>(focusX, focusY);
+    }
+
+    double TileLayer::calculateTileRank(const MapTile& tile, const ViewState& viewState, const cglib::vec2<double>& screenFocus) const {
+        // Calculate the screen space bounds of the tile in normalized device coordinates
+        const cglib::mat4x4<double>& mvpMat = viewState.getModelviewProjectionMat();
+        cglib::bbox3<double> tileBounds = getTileTransformer()->calculateTileBBox(vt::TileId(tile.getZoom(), tile.getX(), tile.getY()));
+        cglib::bbox2<double> screenBounds = cglib::bbox2<double>::smallest();
+        for (int i = 0; i < 8; i++) {
+            cglib::vec3<double> pos((i & 1 ? tileBounds.max : tileBounds.min)(0), (i & 2 ? tileBounds.max : tileBounds.min)(1), (i & 4 ? tileBounds.max : tileBounds.min)(2));
+            double w = pos(0) * mvpMat(3, 0) + pos(1) * mvpMat(3, 1) + pos(2) * mvpMat(3, 2) + mvpMat(3, 3);
+            if (w <= 0) {
+                // Tile crosses the camera plane, treat it as covering the whole screen
+                screenBounds = cglib::bbox2<double>(cglib::vec2<double>(-1, -1), cglib::vec2<double>(1, 1));
+                break;
+            }
+            double x = (pos(0) * mvpMat(0, 0) + pos(1) * mvpMat(0, 1) + pos(2) * mvpMat(0, 2) + mvpMat(0, 3)) / w;
+            double y = (pos(0) * mvpMat(1, 0) + pos(1) * mvpMat(1, 1) + pos(2) * mvpMat(1, 2) + mvpMat(1, 3)) / w;
+            screenBounds.add(cglib::vec2<double>(x, y));
+        }
+
+        // Clip against the screen, calculate the covered fraction of the screen and the distance of the visible part from the focus point
+        cglib::vec2<double> clippedMin(std::max(-1.0, std::min(1.0, screenBounds.min(0))), std::max(-1.0, std::min(1.0, screenBounds.min(1))));
+        cglib::vec2<double> clippedMax(std::max(-1.0, std::min(1.0, screenBounds.max(0))), std::max(-1.0, std::min(1.0, screenBounds.max(1))));
+        double coverage = (clippedMax(0) - clippedMin(0)) * (clippedMax(1) - clippedMin(1)) / 4.0;
+        cglib::vec2<double> clippedCenter = (clippedMin + clippedMax) * 0.5;
+        double dist = cglib::length(clippedCenter - screenFocus);
+
+        // Tiles close to the focus point and tiles covering large part of the screen get lower (better) rank
+        return dist * (1.0 - coverage);
+    }
+
+    void TileLayer::rescheduleFetchTasks() {
+        std::shared_ptr<CancelableThreadPool> tileThreadPool = _tileThreadPool;
+        if (!tileThreadPool) {
+            return;
+        }
+
+        std::vector<std::shared_ptr<CancelableTask> > tasks;
+        for (const std::shared_ptr<FetchTaskBase>& task : _fetchingTiles.getRequestedTasks()) {
+            tasks.push_back(task);
+        }
+        tileThreadPool->reschedule(tasks);
+    }
+
     void TileLayer::findTiles(const std::vector<MapTile>& visTiles, bool preloadingTiles) {
         for (const MapTile& visTile : visTiles) {
             int tileMask = (1 << visTile.getZoom()) - 1;
@@ -635,7 +716,8 @@ namespace carto {
         _dataSourceTiles(),
         _preloadingTile(preloadingTile),
         _started(false),
-        _invalidated(false)
+        _invalidated(false),
+        _requestTime(std::chrono::steady_clock::now())
     {
         for (MapTile dataSourceTile = tile; true; ) {
             int zoom = dataSourceTile.getZoom();
@@ -688,9 +770,11 @@ namespace carto {
             _started = true;
         }
         
+        bool loaded = false;
         bool refresh = false;
         try {
-            refresh = loadTile(layer) && !_preloadingTile;
+            loaded = loadTile(layer);
+            refresh = loaded && !_preloadingTile;
             if (refresh) {
                 loadUTFGridTile(layer);
             }
@@ -701,6 +785,15 @@ namespace carto {
     
         layer->_fetchingTiles.remove(_tile.getTileId());
 
+        if (loaded) {
+            DirectorPtr<TileLoadListener> tileLoadListener = layer->_tileLoadListener;
+
+            if (tileLoadListener) {
+                float loadTime = std::chrono::duration_cast<std::chrono::duration<float> >(std::chrono::steady_clock::now() - _requestTime).count();
+                tileLoadListener->onTileLoaded(_tile, loadTime);
+            }
+        }
+
         if (refresh) {
             if (auto mapRenderer = layer->getMapRenderer()) {
                 mapRenderer->layerChanged(layer->shared_from_this(), false);
@@ -756,5 +849,6 @@ namespace carto {
 
     const double TileLayer::PRELOADING_TILE_SCALE = 1.5;
     const float TileLayer::SUBDIVISION_THRESHOLD = Const::WORLD_SIZE;
+    const double TileLayer::CAMERA_MOTION_LOOKAHEAD = 4.0;
     
 }
@@ -17,6 +17,7 @@
 #include "layers/components/FetchingTileTasks.h"
 
 #include <atomic>
+#include <chrono>
 #include <unordered_map>
 
 namespace carto {
@@ -254,6 +255,7 @@ namespace carto {
             bool _preloadingTile;
             bool _started;
             bool _invalidated;
+            std::chrono::steady_clock::time_point _requestTime;
         };
         
         explicit TileLayer(const std::shared_ptr<TileDataSource>& dataSource);
@@ -324,7 +326,10 @@ namespace carto {
         void calculateVisibleTiles(const std::shared_ptr<CullState>& cullState);
         void calculateVisibleTilesRecursive(const std::shared_ptr<CullState>& cullState, const MapTile& mapTile, const MapBounds& dataExtent);
 
-        void sortTiles(std::vector<MapTile>& tiles, const ViewState& viewState, bool preloadingTiles);
+        void sortTiles(std::vector<MapTile>& tiles, const ViewState& viewState, const cglib::vec2<double>& screenFocus, bool preloadingTiles);
+        cglib::vec2<double> calculateScreenFocus(const ViewState& viewState) const;
+        double calculateTileRank(const MapTile& tile, const ViewState& viewState, const cglib::vec2<double>& screenFocus) const;
+        void rescheduleFetchTasks();
         void findTiles(const std::vector<MapTile>& visTiles, bool preloadingTiles);
         bool findParentTile(const MapTile& visTile, const MapTile& tile, int depth, bool preloadingCache, bool preloadingTile);
         int findChildTiles(const MapTile& visTile, const MapTile& tile, int depth, bool preloadingCache, bool preloadingTile);
@@ -334,6 +339,7 @@ namespace carto {
         
         static const double PRELOADING_TILE_SCALE;
         static const float SUBDIVISION_THRESHOLD;
+        static const double CAMERA_MOTION_LOOKAHEAD;
         
         std::vector<MapTile> _visibleTiles;
         std::vector<MapTile> _preloadingTiles;
@@ -7,6 +7,8 @@
 #ifndef _CARTO_TILELOADLISTENER_H_
 #define _CARTO_TILELOADLISTENER_H_
 
+#include "core/MapTile.h"
+
 namespace carto {
 
     /**
@@ -26,6 +28,13 @@ namespace carto {
          * This method gets called after onVisibleTilesLoaded() and only if preloading is enabled.
          */
         virtual void onPreloadingTilesLoaded() { }
+
+        /**
+         * Listener method that gets called when a single tile has finished loading.
+         * @param mapTile The tile that was loaded.
+         * @param loadTime The time elapsed between the first request of the tile and the end of loading, in seconds.
+         */
+        virtual void onTileLoaded(const MapTile& mapTile, float loadTime) { }
     };
         
 }
@@ -139,7 +139,7 @@ namespace carto {
     
     void VectorTileLayer::fetchTile(const MapTile& tile, bool preloadingTile, bool invalidated) {
         long long tileId = getTileId(tile);
-        if (_fetchingTiles.exists(tileId)) {
+        if (_fetchingTiles.reuse(tileId, preloadingTile)) {
             return;
         }
 
@@ -7,24 +7,58 @@
 #ifndef _CARTO_FETCHINGTILETASKS_H_
 #define _CARTO_FETCHINGTILETASKS_H_
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace carto {
 
     template <typename Task>
     class FetchingTileTasks {
     public:
-        FetchingTileTasks() : _fetchingTiles(), _mutex() { }
+        FetchingTileTasks() : _fetchingTiles(), _generation(0), _requestCount(0), _mutex() { }
         
         void add(long long tileId, const std::shared_ptr<Task>& task) {
             std::lock_guard<std::mutex> lock(_mutex);
-            _fetchingTiles[tileId] = task;
+            _fetchingTiles[tileId] = TaskRecord(task, _generation, _requestCount++);
         }
         
         bool exists(long long tileId) {
             std::lock_guard<std::mutex> lock(_mutex);
             return _fetchingTiles.find(tileId) != _fetchingTiles.end();
         }
+
+        bool reuse(long long tileId, bool preloading) {
+            std::shared_ptr<Task> task;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto it = _fetchingTiles.find(tileId);
+                if (it == _fetchingTiles.end()) {
+                    return false;
+                }
+                task = it->second.task;
+                if (preloading || !task->isPreloading()) {
+                    it->second.generation = _generation;
+                    it->second.order = _requestCount++;
+                    return true;
+                }
+            }
+
+            // Preloading task is requested as a visible task. Try to cancel it, so that it can be requeued with higher priority.
+            // Note: canceling removes the task from the list, unless it is already running.
+            task->cancel();
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _fetchingTiles.find(tileId);
+            if (it == _fetchingTiles.end()) {
+                return false;
+            }
+            it->second.generation = _generation;
+            it->second.order = _requestCount++;
+            return true;
+        }
         
         void remove(long long tileId) {
             std::lock_guard<std::mutex> lock(_mutex);
@@ -35,7 +69,43 @@ namespace carto {
             std::lock_guard<std::mutex> lock(_mutex);
             std::vector<std::shared_ptr<Task> > tasks;
             for (const auto& pair : _fetchingTiles) {
-                tasks.push_back(pair.second);
+                tasks.push_back(pair.second.task);
+            }
+            return tasks;
+        }
+
+        void startGeneration() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _generation++;
+            _requestCount = 0;
+        }
+
+        std::vector<std::shared_ptr<Task> > getRequestedTasks() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::vector<std::pair<int, std::shared_ptr<Task> > > orderedTasks;
+            for (const auto& pair : _fetchingTiles) {
+                if (pair.second.generation == _generation) {
+                    orderedTasks.emplace_back(pair.second.order, pair.second.task);
+                }
+            }
+            std::sort(orderedTasks.begin(), orderedTasks.end(), [](const std::pair<int, std::shared_ptr<Task> >& task1, const std::pair<int, std::shared_ptr<Task> >& task2) {
+                return task1.first < task2.first;
+            });
+            std::vector<std::shared_ptr<Task> > tasks;
+            tasks.reserve(orderedTasks.size());
+            for (const auto& orderedTask : orderedTasks) {
+                tasks.push_back(orderedTask.second);
+            }
+            return tasks;
+        }
+
+        std::vector<std::shared_ptr<Task> > getStaleTasks() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::vector<std::shared_ptr<Task> > tasks;
+            for (const auto& pair : _fetchingTiles) {
+                if (pair.second.generation != _generation) {
+                    tasks.push_back(pair.second.task);
+                }
             }
             return tasks;
         }
@@ -44,7 +114,7 @@ namespace carto {
             std::lock_guard<std::mutex> lock(_mutex);
             int count = 0;
             for (const auto& pair : _fetchingTiles) {
-                if (pair.second->isPreloading()) {
+                if (pair.second.task->isPreloading()) {
                     count++;
                 }
             }
@@ -55,7 +125,7 @@ namespace carto {
             std::lock_guard<std::mutex> lock(_mutex);
             int count = 0;
             for (const auto& pair : _fetchingTiles) {
-                if (!pair.second->isPreloading()) {
+                if (!pair.second.task->isPreloading()) {
                     count++;
                 }
             }
@@ -63,7 +133,18 @@ namespace carto {
         }
 
     private:
-        std::unordered_map<long long, std::shared_ptr<Task> > _fetchingTiles;
+        struct TaskRecord {
+            std::shared_ptr<Task> task;
+            int generation;
+            int order; // request order within the generation
+
+            TaskRecord() : task(), generation(0), order(0) { }
+            TaskRecord(const std::shared_ptr<Task>& task, int generation, int order) : task(task), generation(generation), order(order) { }
+        };
+
+        std::unordered_map<long long, TaskRecord> _fetchingTiles;
+        int _generation;
+        int _requestCount;
         mutable std::mutex _mutex;
     };
     
@@ -96,7 +96,7 @@ namespace carto {
         if (request.headers.count("Accept") == 0) {
             request.headers["Accept"] = "*/*";
         }
-        if (offset > 0) {
+        if (offset > 0 && request.headers.count("Range") == 0) {
             request.headers["Range"] = "bytes=" + boost::lexical_cast<std::string>(offset) + "-";
         }
 
@@ -114,6 +114,11 @@ namespace carto {
             response.statusCode = statusCode;
             response.headers.insert(headers.begin(), headers.end());
 
+            // If the server ignored the range request, the content starts from the beginning
+            if (statusCode == 200) {
+                offset = 0;
+            }
+
             // Read Content-Range
             if (statusCode == 206) {
                 auto it = response.headers.find("Content-Range");
@@ -917,11 +917,14 @@ namespace carto {
         // Create new package file or reuse partly downloaded file
         bool packageSizeIndeterminate = package->getSize() == 0;
         std::string packageFileName = createLocalFilePath(createPackageFileName(task.packageId, task.packageType, task.packageVersion));
+        std::string rangesFileName = packageFileName + ".ranges";
         try {
             // Try to download the package
             for (int retry = 0; true; retry++) {
                 if (retry > 0) {
                     utf8_filesystem::unlink(packageFileName.c_str());
+                    utf8_filesystem::unlink(rangesFileName.c_str());
+                    utf8_filesystem::unlink((rangesFileName + ".tmp").c_str());
                     Log::Infof("PackageManager: Retrying package %s download", task.packageId.c_str());
                 }
                 FILE* fpRaw = utf8_filesystem::fopen(packageFileName.c_str(), "ab");
@@ -932,7 +935,22 @@ namespace carto {
                 utf8_filesystem::fseek64(fp.get(), 0, SEEK_END);
                 std::uint64_t fileOffset = utf8_filesystem::ftell64(fp.get());
                 std::uint64_t fileSize = package->getSize();
-                if (!packageSizeIndeterminate && fileOffset == fileSize) {
+                bool rangesPending = false;
+                if (!packageSizeIndeterminate) {
+                    // The package file may contain holes, so only the saved range state tells how much data is present
+                    std::vector<DownloadRange> ranges;
+                    if (LoadDownloadRanges(rangesFileName, fileSize, ranges)) {
+                        rangesPending = true;
+                    } else if (fileOffset > 0) {
+                        Log::Warnf("PackageManager: No valid download state for package %s, restarting download", task.packageId.c_str());
+                        utf8_filesystem::unlink(rangesFileName.c_str());
+                        utf8_filesystem::unlink((rangesFileName + ".tmp").c_str());
+                        utf8_filesystem::fseek64(fp.get(), 0, SEEK_SET);
+                        utf8_filesystem::ftruncate64(fp.get(), 0);
+                        fileOffset = 0;
+                    }
+                }
+                if (!packageSizeIndeterminate && fileOffset == fileSize && !rangesPending) {
                     break;
                 }
                 if (fileSize > 0) {
@@ -943,33 +961,59 @@ namespace carto {
                 if (packageURL.empty()) {
                     throw PackageException(PackageErrorType::PACKAGE_ERROR_TYPE_NO_OFFLINE_PLAN, "Offline packages not available");
                 }
-                int errorCode = DownloadFile(packageURL, [this, fp, taskId, packageFileName, &fileOffset, fileSize](std::uint64_t offset, std::uint64_t length, const unsigned char* buf, std::size_t size) {
-                    if (isTaskCancelled(taskId)) {
-                        return false;
-                    }
-                    if (isTaskPaused(taskId)) {
-                        return false;
-                    }
 
-                    if (offset != fileOffset) {
-                        Log::Infof("PackageManager: Truncating file");
-                        utf8_filesystem::fseek64(fp.get(), offset, SEEK_SET);
-                        utf8_filesystem::ftruncate64(fp.get(), offset);
-                    }
-                    if (fwrite(buf, sizeof(unsigned char), size, fp.get()) != size) {
-                        Log::Errorf("PackageManager: Storage full? Could not write to package file %s", packageFileName.c_str());
-                        return false;
-                    }
-                    fileOffset = offset + size;
-                    std::uint64_t realSize = fileSize;
-                    if (fileSize == 0 && length != std::numeric_limits<std::uint64_t>::max()) {
-                        realSize = length;
-                    }
-                    if (realSize > 0) {
-                        updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_DOWNLOADING, static_cast<float>(fileOffset) / static_cast<float>(realSize));
+                // Use multiple connections for large packages, fall back to single connection if the server does not support range requests
+                int errorCode = -1;
+                bool rangesSupported = false;
+                if (rangesPending || (!packageSizeIndeterminate && fileSize > fileOffset && fileSize - fileOffset >= 2 * MIN_DOWNLOAD_RANGE_SIZE)) {
+                    rangesSupported = true;
+                    errorCode = downloadPackageRanges(taskId, packageURL, packageFileName, fileOffset, fileSize, rangesSupported);
+                    if (rangesSupported) {
+                        if (errorCode == 0) {
+                            fileOffset = fileSize;
+                        }
+                    } else {
+                        Log::Infof("PackageManager: Range requests not supported, downloading package %s using single connection", task.packageId.c_str());
+                        utf8_filesystem::fseek64(fp.get(), 0, SEEK_END);
+                        fileOffset = utf8_filesystem::ftell64(fp.get());
                     }
-                    return true;
-                }, fileOffset);
+                }
+                if (!rangesSupported) {
+                    std::uint64_t savedOffset = fileOffset;
+                    errorCode = DownloadFile(packageURL, [this, fp, taskId, packageFileName, rangesFileName, packageSizeIndeterminate, &fileOffset, &savedOffset, fileSize](std::uint64_t offset, std::uint64_t length, const unsigned char* buf, std::size_t size) {
+                        if (isTaskCancelled(taskId)) {
+                            return false;
+                        }
+                        if (isTaskPaused(taskId)) {
+                            return false;
+                        }
+
+                        if (offset != fileOffset) {
+                            Log::Infof("PackageManager: Truncating file");
+                            utf8_filesystem::fseek64(fp.get(), offset, SEEK_SET);
+                            utf8_filesystem::ftruncate64(fp.get(), offset);
+                        }
+                        if (fwrite(buf, sizeof(unsigned char), size, fp.get()) != size) {
+                            Log::Errorf("PackageManager: Storage full? Could not write to package file %s", packageFileName.c_str());
+                            return false;
+                        }
+                        fileOffset = offset + size;
+                        if (!packageSizeIndeterminate && (fileOffset == fileSize || fileOffset < savedOffset || fileOffset - savedOffset >= DOWNLOAD_RANGE_SAVE_INTERVAL)) {
+                            // Record the progress as a single pending range, so that the download can be resumed
+                            fflush(fp.get());
+                            SaveDownloadRanges(rangesFileName, fileSize, std::vector<DownloadRange> { DownloadRange { fileOffset, fileSize } });
+                            savedOffset = fileOffset;
+                        }
+                        std::uint64_t realSize = fileSize;
+                        if (fileSize == 0 && length != std::numeric_limits<std::uint64_t>::max()) {
+                            realSize = length;
+                        }
+                        if (realSize > 0) {
+                            updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_DOWNLOADING, static_cast<float>(fileOffset) / static_cast<float>(realSize));
+                        }
+                        return true;
+                    }, fileOffset);
+                }
 
                 if (errorCode == 0) {
                     if (packageSizeIndeterminate || fileOffset == fileSize) {
@@ -1000,6 +1044,17 @@ namespace carto {
                 }
             }
 
+            utf8_filesystem::unlink(rangesFileName.c_str());
+            utf8_filesystem::unlink((rangesFileName + ".tmp").c_str());
+
+            // Calculate tile mask if not provided by the server. This requires reading the whole package, so do it before locking the package manager.
+            std::string tileMaskValue;
+            if (package->getTileMask()) {
+                tileMaskValue = EncodeTileMask(package->getTileMask());
+            } else if (auto handler = PackageHandlerFactory(_serverEncKey, _localEncKey).createPackageHandler(task.packageType, packageFileName)) {
+                tileMaskValue = EncodeTileMask(handler->calculateTileMask());
+            }
+
             // Get package id, create package record
             int id = -1;
             {
@@ -1015,12 +1070,6 @@ namespace carto {
                     if (package->getMetaInfo()) {
                         metaInfo = package->getMetaInfo()->getVariant().toString();
                     }
-                    std::string tileMaskValue;
-                    if (package->getTileMask()) {
-                        tileMaskValue = EncodeTileMask(package->getTileMask());
-                    } else if (auto handler = PackageHandlerFactory(_serverEncKey, _localEncKey).createPackageHandler(task.packageType, packageFileName)) {
-                        tileMaskValue = EncodeTileMask(handler->calculateTileMask());
-                    }
                     std::uint64_t fileSize = package->getSize();
                     if (packageSizeIndeterminate) {
                         FILE* fpRaw = utf8_filesystem::fopen(packageFileName.c_str(), "rb");
@@ -1051,10 +1100,14 @@ namespace carto {
         }
         catch (const CancelException&) {
             utf8_filesystem::unlink(packageFileName.c_str());
+            utf8_filesystem::unlink(rangesFileName.c_str());
+            utf8_filesystem::unlink((rangesFileName + ".tmp").c_str());
             throw;
         }
         catch (...) {
             utf8_filesystem::unlink(packageFileName.c_str());
+            utf8_filesystem::unlink(rangesFileName.c_str());
+            utf8_filesystem::unlink((rangesFileName + ".tmp").c_str());
             throw;
         }
 
@@ -1062,6 +1115,141 @@ namespace carto {
         return true;
     }
 
+    int PackageManager::downloadPackageRanges(int taskId, const std::string& packageURL, const std::string& packageFileName, std::uint64_t fileOffset, std::uint64_t fileSize, bool& rangesSupported) {
+        std::string rangesFileName = packageFileName + ".ranges";
+
+        // Resume pending ranges or split the remaining part of the package into ranges
+        std::vector<DownloadRange> ranges;
+        if (!LoadDownloadRanges(rangesFileName, fileSize, ranges)) {
+            ranges.clear();
+            std::uint64_t rangeCount = std::max(static_cast<std::uint64_t>(1), std::min(static_cast<std::uint64_t>(DOWNLOAD_CONNECTION_COUNT), (fileSize - fileOffset) / MIN_DOWNLOAD_RANGE_SIZE));
+            for (std::uint64_t i = 0; i < rangeCount; i++) {
+                DownloadRange range;
+                range.offset = fileOffset + (fileSize - fileOffset) * i / rangeCount;
+                range.end = fileOffset + (fileSize - fileOffset) * (i + 1) / rangeCount;
+                ranges.push_back(range);
+            }
+            if (!SaveDownloadRanges(rangesFileName, fileSize, ranges)) {
+                return -1; // the package file must not get holes without the range state
+            }
+        }
+
+        std::uint64_t downloadedSize = fileSize;
+        for (const DownloadRange& range : ranges) {
+            downloadedSize -= range.end - range.offset;
+        }
+
+        // Download each range using a separate connection. Data is written directly to the package file, range state is saved periodically for resuming.
+        std::mutex rangesMutex;
+        int errorCode = 0;
+        auto downloadRange = [&, this](std::size_t index) {
+            std::uint64_t rangeOffset = ranges[index].offset;
+            std::uint64_t rangeEnd = ranges[index].end;
+            std::uint64_t savedOffset = rangeOffset;
+
+            FILE* fpRaw = utf8_filesystem::fopen(packageFileName.c_str(), "r+b");
+            if (!fpRaw) {
+                Log::Errorf("PackageManager::downloadPackageRanges: Could not open package file %s", packageFileName.c_str());
+                std::lock_guard<std::mutex> lock(rangesMutex);
+                errorCode = -1;
+                return;
+            }
+            std::shared_ptr<FILE> fp(fpRaw, fclose);
+            utf8_filesystem::fseek64(fp.get(), rangeOffset, SEEK_SET);
+
+            int rangeErrorCode = DownloadFile(packageURL, [&, this](std::uint64_t offset, std::uint64_t length, const unsigned char* buf, std::size_t size) {
+                if (isTaskCancelled(taskId)) {
+                    return false;
+                }
+                if (isTaskPaused(taskId)) {
+                    return false;
+                }
+
+                if (offset != rangeOffset) {
+                    std::lock_guard<std::mutex> lock(rangesMutex);
+                    rangesSupported = false; // the server ignored the range and sent the whole file
+                    return false;
+                }
+                std::size_t writeSize = static_cast<std::size_t>(std::min(static_cast<std::uint64_t>(size), rangeEnd - rangeOffset));
+                if (fwrite(buf, sizeof(unsigned char), writeSize, fp.get()) != writeSize) {
+                    Log::Errorf("PackageManager: Storage full? Could not write to package file %s", packageFileName.c_str());
+                    return false;
+                }
+                rangeOffset += writeSize;
+                bool saveRanges = rangeOffset == rangeEnd || rangeOffset - savedOffset >= DOWNLOAD_RANGE_SAVE_INTERVAL;
+                if (saveRanges) {
+                    fflush(fp.get());
+                    savedOffset = rangeOffset;
+                }
+
+                float progress = 0;
+                {
+                    std::lock_guard<std::mutex> lock(rangesMutex);
+                    if (!rangesSupported || errorCode != 0) {
+                        return false;
+                    }
+                    downloadedSize += writeSize;
+                    progress = static_cast<float>(downloadedSize) / static_cast<float>(fileSize);
+                    if (saveRanges) {
+                        ranges[index].offset = rangeOffset;
+                        SaveDownloadRanges(rangesFileName, fileSize, ranges);
+                    }
+                }
+                updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_DOWNLOADING, progress);
+                return rangeOffset < rangeEnd;
+            }, rangeOffset, rangeEnd);
+
+            fflush(fp.get());
+            std::lock_guard<std::mutex> lock(rangesMutex);
+            ranges[index].offset = rangeOffset;
+            if (rangeOffset < rangeEnd && errorCode == 0) {
+                errorCode = (rangeErrorCode != 0 ? rangeErrorCode : -1);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < ranges.size(); i++) {
+            if (ranges[i].offset < ranges[i].end) {
+                threads.emplace_back(downloadRange, i);
+            }
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        if (!rangesSupported) {
+            // Keep only the continuous part of the file, the rest will be downloaded using a single connection
+            std::uint64_t validSize = fileSize;
+            for (const DownloadRange& range : ranges) {
+                if (range.offset < range.end) {
+                    validSize = range.offset;
+                    break;
+                }
+            }
+            // Save the state before truncating, the single connection download keeps updating it
+            if (!SaveDownloadRanges(rangesFileName, fileSize, std::vector<DownloadRange> { DownloadRange { validSize, fileSize } })) {
+                utf8_filesystem::unlink(rangesFileName.c_str());
+                utf8_filesystem::unlink((rangesFileName + ".tmp").c_str());
+                validSize = 0;
+            }
+            FILE* fpRaw = utf8_filesystem::fopen(packageFileName.c_str(), "r+b");
+            if (fpRaw) {
+                std::shared_ptr<FILE> fp(fpRaw, fclose);
+                utf8_filesystem::ftruncate64(fp.get(), validSize);
+            }
+            return -1;
+        }
+
+        if (errorCode != 0) {
+            SaveDownloadRanges(rangesFileName, fileSize, ranges);
+            return errorCode;
+        }
+        utf8_filesystem::unlink(rangesFileName.c_str());
+        utf8_filesystem::unlink((rangesFileName + ".tmp").c_str());
+        updateTaskStatus(taskId, PackageAction::PACKAGE_ACTION_DOWNLOADING, 1.0f);
+        return 0;
+    }
+
     bool PackageManager::removePackage(int taskId) {
         Task task = _taskQueue->getTask(taskId);
 
@@ -1543,9 +1731,73 @@ namespace carto {
         return tileMask->getStringValue() + ":" + boost::lexical_cast<std::string>(tileMask->getMaxZoomLevel());
     }
 
-    int PackageManager::DownloadFile(const std::string& url, NetworkUtils::HandlerFunc handler, std::uint64_t offset) {
+    bool PackageManager::LoadDownloadRanges(const std::string& rangesFileName, std::uint64_t fileSize, std::vector<DownloadRange>& ranges) {
+        // If the range file is missing, a complete temporary file may be left from an interrupted save
+        FILE* fpRaw = utf8_filesystem::fopen(rangesFileName.c_str(), "rb");
+        if (!fpRaw) {
+            fpRaw = utf8_filesystem::fopen((rangesFileName + ".tmp").c_str(), "rb");
+            if (!fpRaw) {
+                return false;
+            }
+        }
+        std::shared_ptr<FILE> fp(fpRaw, fclose);
+
+        // The first line contains the package size and range count, following lines contain offsets and end offsets of the ranges
+        unsigned long long size = 0, count = 0;
+        if (fscanf(fp.get(), "%llu %llu", &size, &count) != 2 || size != fileSize || count == 0) {
+            Log::Warnf("PackageManager::LoadDownloadRanges: Ignoring invalid range file %s", rangesFileName.c_str());
+            return false;
+        }
+        ranges.clear();
+        for (unsigned long long i = 0; i < count; i++) {
+            unsigned long long offset = 0, end = 0;
+            if (fscanf(fp.get(), "%llu %llu", &offset, &end) != 2 || offset > end || end > fileSize) {
+                Log::Warnf("PackageManager::LoadDownloadRanges: Ignoring invalid range file %s", rangesFileName.c_str());
+                ranges.clear();
+                return false;
+            }
+            DownloadRange range;
+            range.offset = offset;
+            range.end = end;
+            ranges.push_back(range);
+        }
+        return true;
+    }
+
+    bool PackageManager::SaveDownloadRanges(const std::string& rangesFileName, std::uint64_t fileSize, const std::vector<DownloadRange>& ranges) {
+        // Write to a temporary file first, so that an interrupted save never leaves a truncated range file
+        std::string tempRangesFileName = rangesFileName + ".tmp";
+        FILE* fpRaw = utf8_filesystem::fopen(tempRangesFileName.c_str(), "wb");
+        if (!fpRaw) {
+            Log::Errorf("PackageManager::SaveDownloadRanges: Could not create range file %s", tempRangesFileName.c_str());
+            return false;
+        }
+        std::shared_ptr<FILE> fp(fpRaw, fclose);
+        bool success = fprintf(fp.get(), "%llu %llu\n", static_cast<unsigned long long>(fileSize), static_cast<unsigned long long>(ranges.size())) > 0;
+        for (const DownloadRange& range : ranges) {
+            success = success && fprintf(fp.get(), "%llu %llu\n", static_cast<unsigned long long>(range.offset), static_cast<unsigned long long>(range.end)) > 0;
+        }
+        success = fflush(fp.get()) == 0 && success;
+        fp.reset();
+        if (!success) {
+            Log::Errorf("PackageManager::SaveDownloadRanges: Could not write to range file %s", tempRangesFileName.c_str());
+            utf8_filesystem::unlink(tempRangesFileName.c_str());
+            return false;
+        }
+        utf8_filesystem::unlink(rangesFileName.c_str());
+        if (utf8_filesystem::rename(tempRangesFileName.c_str(), rangesFileName.c_str()) != 0) {
+            Log::Errorf("PackageManager::SaveDownloadRanges: Could not rename range file %s", tempRangesFileName.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    int PackageManager::DownloadFile(const std::string& url, NetworkUtils::HandlerFunc handler, std::uint64_t offset, std::uint64_t endOffset) {
         Log::Debugf("PackageManager::DownloadFile: %s", url.c_str());
         std::map<std::string, std::string> requestHeaders = NetworkUtils::CreateAppRefererHeader();
+        if (endOffset != std::numeric_limits<std::uint64_t>::max()) {
+            requestHeaders["Range"] = "bytes=" + boost::lexical_cast<std::string>(offset) + "-" + boost::lexical_cast<std::string>(endOffset - 1);
+        }
         std::map<std::string, std::string> responseHeaders;
         return NetworkUtils::StreamHTTPResponse("GET", url, requestHeaders, responseHeaders, handler, offset, Log::IsShowDebug());
     }
@@ -1678,6 +1930,9 @@ namespace carto {
     }
 
     const int PackageManager::DEFAULT_TILEMASK_ZOOMLEVEL = 14;
+    const int PackageManager::DOWNLOAD_CONNECTION_COUNT = 4;
+    const std::uint64_t PackageManager::MIN_DOWNLOAD_RANGE_SIZE = 8 * 1024 * 1024;
+    const std::uint64_t PackageManager::DOWNLOAD_RANGE_SAVE_INTERVAL = 1024 * 1024;
 }
 
 #endif
@@ -22,6 +22,7 @@
 
 #include <string>
 #include <cstdint>
+#include <limits>
 #include <vector>
 #include <memory>
 #include <mutex>
@@ -307,11 +308,17 @@ namespace carto {
             PackageErrorType::PackageErrorType _errorType;
         };
 
+        struct DownloadRange {
+            std::uint64_t offset;
+            std::uint64_t end;
+        };
+
         void run();
 
         bool downloadPackageList(int taskId);
         bool importPackage(int taskId);
         bool downloadPackage(int taskId);
+        int downloadPackageRanges(int taskId, const std::string& packageURL, const std::string& packageFileName, std::uint64_t fileOffset, std::uint64_t fileSize, bool& rangesSupported);
         bool removePackage(int taskId);
         bool downloadStyle(int taskId);
         
@@ -339,9 +346,15 @@ namespace carto {
         static std::shared_ptr<PackageTileMask> DecodeTileMask(const std::string& tileMaskStr);
         static std::string EncodeTileMask(const std::shared_ptr<PackageTileMask>& tileMask);
 
-        static int DownloadFile(const std::string& url, NetworkUtils::HandlerFunc handler, std::uint64_t offset = 0);
+        static bool LoadDownloadRanges(const std::string& rangesFileName, std::uint64_t fileSize, std::vector<DownloadRange>& ranges);
+        static bool SaveDownloadRanges(const std::string& rangesFileName, std::uint64_t fileSize, const std::vector<DownloadRange>& ranges);
+
+        static int DownloadFile(const std::string& url, NetworkUtils::HandlerFunc handler, std::uint64_t offset = 0, std::uint64_t endOffset = std::numeric_limits<std::uint64_t>::max());
 
         static const int DEFAULT_TILEMASK_ZOOMLEVEL;
+        static const int DOWNLOAD_CONNECTION_COUNT;
+        static const std::uint64_t MIN_DOWNLOAD_RANGE_SIZE;
+        static const std::uint64_t DOWNLOAD_RANGE_SAVE_INTERVAL;
 
         const std::string _packageListURL;
         const std::string _packageListFileName;
@@ -23,8 +23,10 @@ namespace carto {
         PackageHandler(fileName),
         _serverEncKey(serverEncKey),
         _localEncKey(localEncKey),
-        _packageDb(),
-        _decryptFunc(),
+        _databaseOpen(false),
+        _encrypted(false),
+        _generation(0),
+        _idleConnections(),
         _sharedDictionary()
     {
     }
@@ -35,43 +37,31 @@ namespace carto {
     void MapPackageHandler::openDatabase() {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
 
-        if (_packageDb) {
+        if (_databaseOpen) {
             return;
         }
 
         try {
-            // Open package database
-            _packageDb.reset(new sqlite3pp::database());
-            if (_packageDb->connect_v2(_fileName.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+            // Open package database. This connection is used only for checking encryption and loading metadata, connections for reading tiles are pooled.
+            sqlite3pp::database packageDb;
+            if (packageDb.connect_v2(_fileName.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
                 Log::Errorf("MapPackageHandler::openDatabase: Failed to open database %s", _fileName.c_str());
                 return;
             }
 
-            // Create new sqlite decryption function. First check if the database is crypted.
-            std::string encKey = _serverEncKey;
-            bool encrypted = CheckDbEncryption(*_packageDb, _serverEncKey + _localEncKey); // NOTE: this is a hack - though tiles are actually encrypted with server key only, with check that local key is included in the hash also
-            _decryptFunc.reset(new sqlite3pp::ext::function(*_packageDb));
-            _decryptFunc->create("tile_decrypt", [encrypted, encKey](sqlite3pp::ext::context& ctx) {
-                const unsigned char* encData = reinterpret_cast<const unsigned char*>(ctx.get<const void*>(0));
-                std::size_t encSize = ctx.args_bytes(0);
-                int zoom = ctx.get<int>(1);
-                int x = ctx.get<int>(2);
-                int y = ctx.get<int>(3);
-                std::vector<unsigned char> encVector(encData, encData + encSize);
-                if (encrypted) {
-                    DecryptTile(encVector, zoom, x, y, encKey);
-                }
-                ctx.result(encVector.empty() ? nullptr : &encVector[0], static_cast<int>(encVector.size()), false);
-            }, 4);
+            // Check if the database is crypted
+            _encrypted = CheckDbEncryption(packageDb, _serverEncKey + _localEncKey); // NOTE: this is a hack - though tiles are actually encrypted with server key only, with check that local key is included in the hash also
 
             // Try to load shared dictionary
             _sharedDictionary.reset();
-            sqlite3pp::query query(*_packageDb, "SELECT value FROM metadata WHERE name='shared_zlib_dict'");
+            sqlite3pp::query query(packageDb, "SELECT value FROM metadata WHERE name='shared_zlib_dict'");
             for (auto qit = query.begin(); qit != query.end(); qit++) {
                 const unsigned char* dataPtr = reinterpret_cast<const unsigned char*>(qit->get<const void*>(0));
                 std::size_t dataSize = qit->column_bytes(0);
-                _sharedDictionary.reset(new BinaryData(dataPtr, dataSize));
+                _sharedDictionary = std::make_shared<BinaryData>(dataPtr, dataSize);
             }
+
+            _databaseOpen = true;
         }
         catch (const std::exception& ex) {
             Log::Errorf("MapPackageHandler::openDatabase: Exception %s", ex.what());
@@ -81,36 +71,43 @@ namespace carto {
     void MapPackageHandler::closeDatabase() {
         std::lock_guard<std::recursive_mutex> lock(_mutex);
 
-        _packageDb.reset();
-        _decryptFunc.reset();
+        // Connections currently in use will be closed once released
+        _idleConnections.clear();
         _sharedDictionary.reset();
+        _databaseOpen = false;
+        _generation++;
     }
 
     std::shared_ptr<BinaryData> MapPackageHandler::loadTile(const MapTile& mapTile) {
-        std::lock_guard<std::recursive_mutex> lock(_mutex);
-
         try {
-            openDatabase();
+            std::unique_ptr<Connection> connection = acquireConnection();
+            if (!connection) {
+                return std::shared_ptr<BinaryData>();
+            }
 
             // Try to load the tile (this could fail, as tile masks may not be complete to the last zoom level)
-            sqlite3pp::query query(*_packageDb, "SELECT tile_decrypt(tile_data, zoom_level, tile_column, tile_row) FROM tiles WHERE zoom_level=:zoom AND tile_column=:x AND tile_row=:y");
-            query.bind(":zoom", mapTile.getZoom());
-            query.bind(":x", mapTile.getX());
-            query.bind(":y", mapTile.getY());
-            for (auto qit = query.begin(); qit != query.end(); qit++) {
-                const unsigned char* dataPtr = reinterpret_cast<const unsigned char*>(qit->get<const void*>(0));
-                std::size_t dataSize = qit->column_bytes(0);
-                std::vector<unsigned char> data(dataPtr, dataPtr + dataSize);
-                if (_sharedDictionary) {
-                    std::vector<unsigned char> uncompressedData;
-                    if (!zlib::inflate_raw(data.data(), data.size(), _sharedDictionary->data(), _sharedDictionary->size(), uncompressedData)) {
-                        Log::Warnf("MapPackageHandler::loadTile: Failed to decompress tile with shared dictionary");
-                        return std::shared_ptr<BinaryData>();
-                    }
-                    std::swap(data, uncompressedData);
+            std::vector<unsigned char> data;
+            bool found = false;
+            {
+                sqlite3pp::query query(*connection->db, "SELECT tile_decrypt(tile_data, zoom_level, tile_column, tile_row) FROM tiles WHERE zoom_level=:zoom AND tile_column=:x AND tile_row=:y");
+                query.bind(":zoom", mapTile.getZoom());
+                query.bind(":x", mapTile.getX());
+                query.bind(":y", mapTile.getY());
+                for (auto qit = query.begin(); qit != query.end(); qit++) {
+                    const unsigned char* dataPtr = reinterpret_cast<const unsigned char*>(qit->get<const void*>(0));
+                    std::size_t dataSize = qit->column_bytes(0);
+                    data.assign(dataPtr, dataPtr + dataSize);
+                    found = true;
+                    break;
                 }
-                return std::make_shared<BinaryData>(std::move(data));
             }
+            std::shared_ptr<BinaryData> sharedDictionary = connection->sharedDictionary;
+            releaseConnection(std::move(connection));
+
+            if (!found || !DecompressTile(data, sharedDictionary)) {
+                return std::shared_ptr<BinaryData>();
+            }
+            return std::make_shared<BinaryData>(std::move(data));
         }
         catch (const std::exception& ex) {
             Log::Errorf("MapPackageHandler::loadTile: Exception %s", ex.what());
@@ -155,6 +152,85 @@ namespace carto {
         return std::make_shared<PackageTileMask>(tiles, maxZoomLevel);
     }
 
+    std::unique_ptr<MapPackageHandler::Connection> MapPackageHandler::createConnection(bool encrypted, int generation) const {
+        std::unique_ptr<Connection> connection(new Connection());
+        connection->db.reset(new sqlite3pp::database());
+        if (connection->db->connect_v2(_fileName.c_str(), SQLITE_OPEN_READONLY) != SQLITE_OK) {
+            Log::Errorf("MapPackageHandler::createConnection: Failed to open database %s", _fileName.c_str());
+            return std::unique_ptr<Connection>();
+        }
+
+        // Create new sqlite decryption function
+        std::string encKey = _serverEncKey;
+        connection->decryptFunc.reset(new sqlite3pp::ext::function(*connection->db));
+        connection->decryptFunc->create("tile_decrypt", [encrypted, encKey](sqlite3pp::ext::context& ctx) {
+            const unsigned char* encData = reinterpret_cast<const unsigned char*>(ctx.get<const void*>(0));
+            std::size_t encSize = ctx.args_bytes(0);
+            int zoom = ctx.get<int>(1);
+            int x = ctx.get<int>(2);
+            int y = ctx.get<int>(3);
+            std::vector<unsigned char> encVector(encData, encData + encSize);
+            if (encrypted) {
+                DecryptTile(encVector, zoom, x, y, encKey);
+            }
+            ctx.result(encVector.empty() ? nullptr : &encVector[0], static_cast<int>(encVector.size()), false);
+        }, 4);
+        connection->generation = generation;
+        return connection;
+    }
+
+    std::unique_ptr<MapPackageHandler::Connection> MapPackageHandler::acquireConnection() {
+        bool encrypted = false;
+        int generation = 0;
+        std::shared_ptr<BinaryData> sharedDictionary;
+        {
+            std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+            openDatabase();
+            if (!_databaseOpen) {
+                return std::unique_ptr<Connection>();
+            }
+
+            if (!_idleConnections.empty()) {
+                std::unique_ptr<Connection> connection = std::move(_idleConnections.back());
+                _idleConnections.pop_back();
+                return connection;
+            }
+
+            encrypted = _encrypted;
+            generation = _generation;
+            sharedDictionary = _sharedDictionary;
+        }
+
+        // Open the new connection without holding the lock, so that other threads can use the pooled connections meanwhile
+        std::unique_ptr<Connection> connection = createConnection(encrypted, generation);
+        if (connection) {
+            connection->sharedDictionary = sharedDictionary;
+        }
+        return connection;
+    }
+
+    void MapPackageHandler::releaseConnection(std::unique_ptr<Connection> connection) {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+        // Keep the connection only if the database has not been closed meanwhile
+        if (connection->generation == _generation && _idleConnections.size() < MAX_IDLE_CONNECTIONS) {
+            _idleConnections.push_back(std::move(connection));
+        }
+    }
+
+    bool MapPackageHandler::DecompressTile(std::vector<unsigned char>& data, const std::shared_ptr<BinaryData>& sharedDictionary) {
+        if (sharedDictionary) {
+            std::vector<unsigned char> uncompressedData;
+            if (!zlib::inflate_raw(data.data(), data.size(), sharedDictionary->data(), sharedDictionary->size(), uncompressedData)) {
+                Log::Warnf("MapPackageHandler::DecompressTile: Failed to decompress tile with shared dictionary");
+                return false;
+            }
+            std::swap(data, uncompressedData);
+        }
+        return true;
+    }
+
     bool MapPackageHandler::CheckDbEncryption(sqlite3pp::database& db, const std::string& encKey) {
         sqlite3pp::query query(db, "SELECT value FROM metadata WHERE name='nutikeysha1'");
         for (auto qit = query.begin(); qit != query.end(); qit++) {
@@ -247,6 +323,8 @@ namespace carto {
         std::copy(encKey.begin(), encKey.begin() + std::min(encKey.size(), static_cast<std::size_t>(CryptoPP::RC5::DEFAULT_KEYLENGTH)), k);
     }
 
+    const unsigned int MapPackageHandler::MAX_IDLE_CONNECTIONS = 4;
+
 }
 
 #endif
@@ -12,6 +12,7 @@
 #include "core/MapTile.h"
 #include "packagemanager/handlers/PackageHandler.h"
 
+#include <memory>
 #include <vector>
 
 namespace sqlite3pp {
@@ -39,9 +40,24 @@ namespace carto {
         virtual std::shared_ptr<PackageTileMask> calculateTileMask() const;
 
     private:
+        struct Connection {
+            std::unique_ptr<sqlite3pp::database> db;
+            std::unique_ptr<sqlite3pp::ext::function> decryptFunc;
+            std::shared_ptr<BinaryData> sharedDictionary;
+            int generation;
+        };
+
+        static const unsigned int MAX_IDLE_CONNECTIONS;
+
+        std::unique_ptr<Connection> createConnection(bool encrypted, int generation) const;
+        std::unique_ptr<Connection> acquireConnection();
+        void releaseConnection(std::unique_ptr<Connection> connection);
+
         static bool CheckDbEncryption(sqlite3pp::database& db, const std::string& encKey);
         static void UpdateDbEncryption(sqlite3pp::database& db, const std::string& encKey);
 
+        static bool DecompressTile(std::vector<unsigned char>& data, const std::shared_ptr<BinaryData>& sharedDictionary);
+
         static std::string CalculateKeyHash(const std::string& encKey);
         static void EncryptTile(std::vector<unsigned char>& data, int zoom, int x, int y, const std::string& encKey);
         static void DecryptTile(std::vector<unsigned char>& data, int zoom, int x, int y, const std::string& encKey);
@@ -50,9 +66,11 @@ namespace carto {
         const std::string _serverEncKey;
         const std::string _localEncKey;
 
-        std::unique_ptr<sqlite3pp::database> _packageDb;
-        std::unique_ptr<sqlite3pp::ext::function> _decryptFunc;
-        std::unique_ptr<BinaryData> _sharedDictionary;
+        bool _databaseOpen;
+        bool _encrypted;
+        int _generation;
+        std::vector<std::unique_ptr<Connection> > _idleConnections;
+        std::shared_ptr<BinaryData> _sharedDictionary;
     };
     
 }
@@ -57,6 +57,14 @@ namespace carto {
         return OSRMRoutingProxy::CalculateRoute(_routeFinder, request);
     }
 
+    std::shared_ptr<RoutingMatrixResult> OSRMOfflineRoutingService::calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const {
+        if (!request) {
+            throw NullArgumentException("Null request");
+        }
+
+        return OSRMRoutingProxy::CalculateMatrix(_routeFinder, request);
+    }
+
 }
 
 #endif
@@ -41,6 +41,8 @@ namespace carto {
 
         virtual std::shared_ptr<RoutingResult> calculateRoute(const std::shared_ptr<RoutingRequest>& request) const;
 
+        virtual std::shared_ptr<RoutingMatrixResult> calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const;
+
     protected:
         std::shared_ptr<osrm::RouteFinder> _routeFinder;
     };
@@ -9,11 +9,17 @@
 #include "routing/RoutingResult.h"
 #include "routing/RouteMatchingRequest.h"
 #include "routing/RouteMatchingResult.h"
+#include "routing/RoutingMatrixRequest.h"
+#include "routing/RoutingMatrixResult.h"
 #include "network/HTTPClient.h"
 #include "utils/NetworkUtils.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+#include <exception>
+#include <thread>
+
 #include <boost/lexical_cast.hpp>
 
 #include <rapidjson/rapidjson.h>
@@ -94,6 +100,66 @@ namespace carto {
         return std::make_shared<RoutingResult>(proj, points, instructions);
     }
 
+    std::shared_ptr<RoutingMatrixResult> OSRMRoutingProxy::CalculateMatrix(const std::shared_ptr<osrm::RouteFinder>& routeFinder, const std::shared_ptr<RoutingMatrixRequest>& request) {
+        std::shared_ptr<Projection> proj = request->getProjection();
+
+        std::vector<osrm::WGSPos> sourcePoses, targetPoses;
+        for (const MapPos& pos : request->getSourcePoints()) {
+            MapPos posWgs84 = proj->toWgs84(pos);
+            sourcePoses.emplace_back(posWgs84.getY(), posWgs84.getX());
+        }
+        for (const MapPos& pos : request->getTargetPoints()) {
+            MapPos posWgs84 = proj->toWgs84(pos);
+            targetPoses.emplace_back(posWgs84.getY(), posWgs84.getX());
+        }
+
+        // Route finder has no one-to-many search, so only distances and times of the individual paths are collected, in parallel across sources.
+        std::size_t sourceCount = sourcePoses.size();
+        std::size_t targetCount = targetPoses.size();
+        std::vector<double> distances(sourceCount * targetCount, -1);
+        std::vector<double> times(sourceCount * targetCount, -1);
+        std::size_t threadCount = std::max(std::size_t(1), std::min({ sourceCount, static_cast<std::size_t>(std::thread::hardware_concurrency()), MAX_MATRIX_THREADS }));
+        std::vector<std::exception_ptr> exceptions(threadCount);
+        auto calculateRows = [&](std::size_t threadIndex) {
+            try {
+                for (std::size_t i = threadIndex; i < sourceCount; i += threadCount) {
+                    for (std::size_t j = 0; j < targetCount; j++) {
+                        osrm::Result result = routeFinder->find(osrm::Query(sourcePoses[i], targetPoses[j]));
+                        if (result.getStatus() == osrm::Result::Status::FAILED) {
+                            continue;
+                        }
+                        double distance = 0, time = 0;
+                        for (const osrm::Instruction& instr : result.getInstructions()) {
+                            distance += instr.getDistance();
+                            time += instr.getTime();
+                        }
+                        distances[i * targetCount + j] = distance;
+                        times[i * targetCount + j] = time;
+                    }
+                }
+            }
+            catch (...) {
+                exceptions[threadIndex] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < threadCount; i++) {
+            threads.emplace_back(calculateRows, i);
+        }
+        calculateRows(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        for (const std::exception_ptr& exception : exceptions) {
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+
+        return std::make_shared<RoutingMatrixResult>(proj, static_cast<int>(sourceCount), static_cast<int>(targetCount), distances, times);
+    }
+
     std::shared_ptr<RoutingResult> OSRMRoutingProxy::CalculateRoute(HTTPClient& httpClient, const std::string& url, const std::shared_ptr<RoutingRequest>& request) {
         std::shared_ptr<Projection> proj = request->getProjection();
         EPSG3857 epsg3857;
@@ -293,6 +359,7 @@ namespace carto {
     }
     
     const double OSRMRoutingProxy::COORDINATE_SCALE = 1.0e-6;
+    const std::size_t OSRMRoutingProxy::MAX_MATRIX_THREADS = 4;
     
 }
 
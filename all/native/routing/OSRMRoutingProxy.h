@@ -26,10 +26,14 @@ namespace carto {
     class RoutingResult;
     class RouteMatchingRequest;
     class RouteMatchingResult;
+    class RoutingMatrixRequest;
+    class RoutingMatrixResult;
 
     class OSRMRoutingProxy {
     public:
         static std::shared_ptr<RoutingResult> CalculateRoute(const std::shared_ptr<osrm::RouteFinder>& routeFinder, const std::shared_ptr<RoutingRequest>& request);
+
+        static std::shared_ptr<RoutingMatrixResult> CalculateMatrix(const std::shared_ptr<osrm::RouteFinder>& routeFinder, const std::shared_ptr<RoutingMatrixRequest>& request);
         
         static std::shared_ptr<RoutingResult> CalculateRoute(HTTPClient& httpClient, const std::string& url, const std::shared_ptr<RoutingRequest>& request);
 
@@ -45,6 +49,7 @@ namespace carto {
         static std::vector<MapPos> DecodeGeometry(const std::string& encodedGeometry);
         
         static const double COORDINATE_SCALE;
+        static const std::size_t MAX_MATRIX_THREADS;
     };
     
 }
@@ -18,7 +18,7 @@ namespace carto {
         _packageManager(packageManager),
         _profile("pedestrian"),
         _configuration(ValhallaRoutingProxy::GetDefaultConfiguration()),
-        _cachedPackageDatabases(),
+        _cachedEngine(),
         _mutex()
     {
         if (!packageManager) {
@@ -62,6 +62,7 @@ namespace carto {
         }
         *subValue = value.toPicoJSON();
         _configuration = Variant::FromPicoJSON(config);
+        _cachedEngine.reset();
     }
 
     std::string PackageManagerValhallaRoutingService::getProfile() const {
@@ -79,39 +80,36 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
-        // Do routing via package manager, so that all packages are locked during routing
-        std::shared_ptr<RouteMatchingResult> result;
-        _packageManager->accessLocalPackages([this, &result, &request](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
-            // Build map of routing packages and graph files
-            std::vector<std::shared_ptr<sqlite3pp::database> > packageDatabases;
-            for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
-                if (auto valhallaRoutingHandler = std::dynamic_pointer_cast<ValhallaRoutingPackageHandler>(it->second)) {
-                    if (std::shared_ptr<sqlite3pp::database> database = valhallaRoutingHandler->getDatabase()) {
-                        packageDatabases.push_back(database);
-                    }
-                }
-            }
-
-            // Now check if we have already a cached route finder for the files. If not, create new instance.
-            std::lock_guard<std::mutex> lock(_mutex);
-            if (packageDatabases != _cachedPackageDatabases) {
-                _cachedPackageDatabases = packageDatabases;
-            }
+        std::string profile;
+        std::shared_ptr<ValhallaRoutingProxy::Engine> engine = getEngine(profile);
+        return ValhallaRoutingProxy::MatchRoute(*engine, profile, request);
+    }
 
-            result = ValhallaRoutingProxy::MatchRoute(_cachedPackageDatabases, _profile, _configuration, request);
-        });
+    std::shared_ptr<RoutingResult> PackageManagerValhallaRoutingService::calculateRoute(const std::shared_ptr<RoutingRequest>& request) const {
+        if (!request) {
+            throw NullArgumentException("Null request");
+        }
 
-        return result;
+        std::string profile;
+        std::shared_ptr<ValhallaRoutingProxy::Engine> engine = getEngine(profile);
+        return ValhallaRoutingProxy::CalculateRoute(*engine, profile, request);
     }
 
-    std::shared_ptr<RoutingResult> PackageManagerValhallaRoutingService::calculateRoute(const std::shared_ptr<RoutingRequest>& request) const {
+    std::shared_ptr<RoutingMatrixResult> PackageManagerValhallaRoutingService::calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const {
         if (!request) {
             throw NullArgumentException("Null request");
         }
 
-        // Do routing via package manager, so that all packages are locked during routing
-        std::shared_ptr<RoutingResult> result;
-        _packageManager->accessLocalPackages([this, &result, &request](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
+        std::string profile;
+        std::shared_ptr<ValhallaRoutingProxy::Engine> engine = getEngine(profile);
+        return ValhallaRoutingProxy::CalculateMatrix(*engine, profile, request);
+    }
+
+    std::shared_ptr<ValhallaRoutingProxy::Engine> PackageManagerValhallaRoutingService::getEngine(std::string& profile) const {
+        // Collect the package databases via package manager, so that the package list does not change meanwhile.
+        // Routing itself is done outside the package manager lock, the engine keeps the databases open and uses a separate worker for each request.
+        std::shared_ptr<ValhallaRoutingProxy::Engine> engine;
+        _packageManager->accessLocalPackages([this, &engine, &profile](const std::map<std::shared_ptr<PackageInfo>, std::shared_ptr<PackageHandler> >& packageHandlerMap) {
             // Build map of routing packages and graph files
             std::vector<std::shared_ptr<sqlite3pp::database> > packageDatabases;
             for (auto it = packageHandlerMap.begin(); it != packageHandlerMap.end(); it++) {
@@ -122,16 +120,15 @@ namespace carto {
                 }
             }
 
-            // Now check if we have already a cached route finder for the files. If not, create new instance.
+            // Now check if we have already a cached routing engine for the files. If not, create new instance.
             std::lock_guard<std::mutex> lock(_mutex);
-            if (packageDatabases != _cachedPackageDatabases) {
-                _cachedPackageDatabases = packageDatabases;
+            if (!_cachedEngine || _cachedEngine->getDatabases() != packageDatabases) {
+                _cachedEngine = std::make_shared<ValhallaRoutingProxy::Engine>(packageDatabases, _configuration);
             }
-
-            result = ValhallaRoutingProxy::CalculateRoute(_cachedPackageDatabases, _profile, _configuration, request);
+            engine = _cachedEngine;
+            profile = _profile;
         });
-
-        return result;
+        return engine;
     }
             
     PackageManagerValhallaRoutingService::PackageManagerListener::PackageManagerListener(PackageManagerValhallaRoutingService& service) :
@@ -141,7 +138,7 @@ namespace carto {
         
     void PackageManagerValhallaRoutingService::PackageManagerListener::onPackagesChanged() {
         std::lock_guard<std::mutex> lock(_service._mutex);
-        _service._cachedPackageDatabases.clear();
+        _service._cachedEngine.reset();
     }
 
     void PackageManagerValhallaRoutingService::PackageManagerListener::onStylesChanged() {
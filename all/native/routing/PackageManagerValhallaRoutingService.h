@@ -12,6 +12,7 @@
 #include "core/Variant.h"
 #include "packagemanager/PackageManager.h"
 #include "routing/RoutingService.h"
+#include "routing/ValhallaRoutingProxy.h"
 
 #include <memory>
 #include <string>
@@ -56,6 +57,8 @@ namespace carto {
 
         virtual std::shared_ptr<RoutingResult> calculateRoute(const std::shared_ptr<RoutingRequest>& request) const;
 
+        virtual std::shared_ptr<RoutingMatrixResult> calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const;
+
     protected:
         class PackageManagerListener : public PackageManager::OnChangeListener {
         public:
@@ -68,11 +71,13 @@ namespace carto {
             PackageManagerValhallaRoutingService& _service;
         };
 
+        std::shared_ptr<ValhallaRoutingProxy::Engine> getEngine(std::string& profile) const;
+
         const std::shared_ptr<PackageManager> _packageManager;
         std::string _profile;
         Variant _configuration;
 
-        mutable std::vector<std::shared_ptr<sqlite3pp::database> > _cachedPackageDatabases;
+        mutable std::shared_ptr<ValhallaRoutingProxy::Engine> _cachedEngine;
 
         mutable std::mutex _mutex;
 
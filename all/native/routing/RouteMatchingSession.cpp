@@ -0,0 +1,203 @@
+#ifdef _CARTO_ROUTING_SUPPORT
+
+#include "RouteMatchingSession.h"
+#include "components/Exceptions.h"
+#include "routing/RoutingService.h"
+#include "routing/RouteMatchingRequest.h"
+#include "routing/RouteMatchingResult.h"
+#include "routing/RouteMatchingPoint.h"
+#include "utils/Log.h"
+
+#include <algorithm>
+
+#include <boost/algorithm/string.hpp>
+
+namespace carto {
+
+    RouteMatchingSession::RouteMatchingSession(const std::shared_ptr<RoutingService>& routingService, const std::shared_ptr<Projection>& projection, float accuracy) :
+        _routingService(routingService),
+        _projection(projection),
+        _accuracy(accuracy),
+        _customParams(),
+        _pendingPoints(),
+        _pendingResult(),
+        _windowVersion(0),
+        _mutex()
+    {
+        if (!routingService) {
+            throw NullArgumentException("Null routingService");
+        }
+        if (!projection) {
+            throw NullArgumentException("Null projection");
+        }
+    }
+
+    RouteMatchingSession::~RouteMatchingSession() {
+    }
+
+    const std::shared_ptr<RoutingService>& RouteMatchingSession::getRoutingService() const {
+        return _routingService;
+    }
+
+    const std::shared_ptr<Projection>& RouteMatchingSession::getProjection() const {
+        return _projection;
+    }
+
+    float RouteMatchingSession::getAccuracy() const {
+        return _accuracy;
+    }
+
+    Variant RouteMatchingSession::getCustomParameter(const std::string& param) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<std::string> keys;
+        boost::split(keys, param, boost::is_any_of("."));
+        picojson::value subValue = _customParams.toPicoJSON();
+        for (const std::string& key : keys) {
+            if (!subValue.is<picojson::object>()) {
+                return Variant();
+            }
+            subValue = subValue.get(key);
+        }
+        return Variant::FromPicoJSON(subValue);
+    }
+
+    void RouteMatchingSession::setCustomParameter(const std::string& param, const Variant& value) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<std::string> keys;
+        boost::split(keys, param, boost::is_any_of("."));
+        picojson::value rootValue = _customParams.toPicoJSON();
+        picojson::value* subValue = &rootValue;
+        for (const std::string& key : keys) {
+            if (!subValue->is<picojson::object>()) {
+                subValue->set(picojson::object());
+            }
+            subValue = &subValue->get<picojson::object>()[key];
+        }
+        *subValue = value.toPicoJSON();
+        _customParams = Variant::FromPicoJSON(rootValue);
+    }
+
+    std::shared_ptr<RouteMatchingResult> RouteMatchingSession::getPendingResult() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _pendingResult;
+    }
+
+    std::vector<RouteMatchingEdge> RouteMatchingSession::addPoints(const std::vector<MapPos>& points) {
+        std::vector<MapPos> windowPoints;
+        std::size_t firstNewIndex = 0;
+        Variant customParams;
+        int windowVersion = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pendingPoints.insert(_pendingPoints.end(), points.begin(), points.end());
+
+            // Keep the window bounded even if no edges can be confirmed
+            if (_pendingPoints.size() > MAX_PENDING_POINTS) {
+                Log::Warnf("RouteMatchingSession::addPoints: Dropping %d unconfirmed points", static_cast<int>(_pendingPoints.size() - MAX_PENDING_POINTS));
+                _pendingPoints.erase(_pendingPoints.begin(), _pendingPoints.end() - MAX_PENDING_POINTS);
+                _windowVersion++;
+            }
+            if (_pendingPoints.size() < 2) {
+                return std::vector<RouteMatchingEdge>();
+            }
+
+            windowPoints = _pendingPoints;
+            firstNewIndex = _pendingPoints.size() - std::min(points.size(), _pendingPoints.size());
+            customParams = _customParams;
+            windowVersion = _windowVersion;
+        }
+
+        // Match without holding the lock, as matching may involve network requests
+        std::shared_ptr<RouteMatchingResult> result;
+        try {
+            result = matchPoints(windowPoints, customParams);
+        }
+        catch (const GenericException& ex) {
+            // Restart the window from the new points, or drop the new points if the window consisted of these only. Otherwise the same points would fail every following update.
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (windowVersion == _windowVersion) {
+                std::size_t dropCount = (firstNewIndex > 0 ? firstNewIndex : windowPoints.size());
+                Log::Warnf("RouteMatchingSession::addPoints: Matching failed, dropping %d points: %s", static_cast<int>(dropCount), ex.what());
+                _pendingPoints.erase(_pendingPoints.begin(), _pendingPoints.begin() + dropCount);
+                _pendingResult.reset();
+                _windowVersion++;
+            }
+            return std::vector<RouteMatchingEdge>();
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (windowVersion != _windowVersion) {
+            return std::vector<RouteMatchingEdge>(); // the window was changed by a concurrent update, the result is stale
+        }
+        _pendingResult = result;
+
+        // Edges are confirmed once the last CONFIRMATION_POINTS points are all matched to later edges
+        const std::vector<RouteMatchingPoint>& matchingPoints = result->getMatchingPoints();
+        const std::vector<RouteMatchingEdge>& matchingEdges = result->getMatchingEdges();
+        std::vector<RouteMatchingEdge> confirmedEdges;
+        if (matchingPoints.size() == windowPoints.size() && matchingPoints.size() > CONFIRMATION_POINTS) {
+            int minEdgeIndex = -1;
+            for (std::size_t i = matchingPoints.size() - CONFIRMATION_POINTS; i < matchingPoints.size(); i++) {
+                const RouteMatchingPoint& matchingPoint = matchingPoints[i];
+                if (matchingPoint.getType() != RouteMatchingPointType::ROUTE_MATCHING_POINT_UNMATCHED && matchingPoint.getEdgeIndex() >= 0) {
+                    minEdgeIndex = (minEdgeIndex < 0 ? matchingPoint.getEdgeIndex() : std::min(minEdgeIndex, matchingPoint.getEdgeIndex()));
+                }
+            }
+
+            if (minEdgeIndex > 0) {
+                confirmedEdges.assign(matchingEdges.begin(), matchingEdges.begin() + std::min(static_cast<std::size_t>(minEdgeIndex), matchingEdges.size()));
+
+                // Drop the points preceding the first point on an unconfirmed edge, the next window starts from there
+                std::size_t firstPendingIndex = 0;
+                while (firstPendingIndex < matchingPoints.size()) {
+                    const RouteMatchingPoint& matchingPoint = matchingPoints[firstPendingIndex];
+                    if (matchingPoint.getType() != RouteMatchingPointType::ROUTE_MATCHING_POINT_UNMATCHED && matchingPoint.getEdgeIndex() >= minEdgeIndex) {
+                        break;
+                    }
+                    firstPendingIndex++;
+                }
+                _pendingPoints.erase(_pendingPoints.begin(), _pendingPoints.begin() + firstPendingIndex);
+                _windowVersion++;
+            }
+        }
+        return confirmedEdges;
+    }
+
+    std::vector<RouteMatchingEdge> RouteMatchingSession::finish() {
+        std::vector<MapPos> windowPoints;
+        Variant customParams;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::swap(windowPoints, _pendingPoints);
+            customParams = _customParams;
+            _pendingResult.reset();
+            _windowVersion++;
+        }
+
+        if (windowPoints.size() < 2) {
+            return std::vector<RouteMatchingEdge>();
+        }
+        return matchPoints(windowPoints, customParams)->getMatchingEdges();
+    }
+
+    std::shared_ptr<RouteMatchingResult> RouteMatchingSession::matchPoints(const std::vector<MapPos>& points, const Variant& customParams) const {
+        auto request = std::make_shared<RouteMatchingRequest>(_projection, points, _accuracy);
+        if (customParams.getType() == VariantType::VARIANT_TYPE_OBJECT) {
+            for (const std::string& key : customParams.getObjectKeys()) {
+                request->setCustomParameter(key, customParams.getObjectElement(key));
+            }
+        }
+
+        std::shared_ptr<RouteMatchingResult> result = _routingService->matchRoute(request);
+        if (!result) {
+            throw GenericException("Route matching failed");
+        }
+        return result;
+    }
+
+    const std::size_t RouteMatchingSession::CONFIRMATION_POINTS = 8;
+    const std::size_t RouteMatchingSession::MAX_PENDING_POINTS = 256;
+
+}
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_ROUTEMATCHINGSESSION_H_
+#define _CARTO_ROUTEMATCHINGSESSION_H_
+
+#ifdef _CARTO_ROUTING_SUPPORT
+
+#include "core/MapPos.h"
+#include "core/Variant.h"
+#include "routing/RouteMatchingEdge.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace carto {
+    class Projection;
+    class RoutingService;
+    class RouteMatchingResult;
+
+    /**
+     * A stateful route matching session for live GPS traces.
+     * Points are added incrementally and only a bounded window of the most recent points is matched
+     * on each update, so the cost of an update does not depend on the length of the whole trace.
+     * Matched edges are reported once they are confirmed by the following points and will not change afterwards.
+     */
+    class RouteMatchingSession {
+    public:
+        /**
+         * Constructs a new RouteMatchingSession instance.
+         * @param routingService The routing service to use for matching.
+         * @param projection The projection of the points.
+         * @param accuracy The GPS accuracy in meters.
+         */
+        RouteMatchingSession(const std::shared_ptr<RoutingService>& routingService, const std::shared_ptr<Projection>& projection, float accuracy);
+        virtual ~RouteMatchingSession();
+
+        /**
+         * Returns the routing service used for matching.
+         * @return The routing service used for matching.
+         */
+        const std::shared_ptr<RoutingService>& getRoutingService() const;
+        /**
+         * Returns the projection of the points.
+         * @return The projection of the points.
+         */
+        const std::shared_ptr<Projection>& getProjection() const;
+        /**
+         * Returns the GPS accuracy used for matching.
+         * @return The GPS accuracy in meters.
+         */
+        float getAccuracy() const;
+
+        /**
+         * Returns the custom parameter value used for the matching requests.
+         * @param param The name of the parameter to return.
+         * @return The value of the parameter. If the parameter does not exist, empty variant is returned.
+         */
+        Variant getCustomParameter(const std::string& param) const;
+        /**
+         * Sets a custom parameter value for the matching requests.
+         * @param param The name of the parameter. For example, "trace_options.search_radius".
+         * @param value The new value for the parameter.
+         */
+        void setCustomParameter(const std::string& param, const Variant& value);
+
+        /**
+         * Returns the latest matching result of the current window of unconfirmed points.
+         * @return The matching result of the current window. Can be null if no points are pending.
+         */
+        std::shared_ptr<RouteMatchingResult> getPendingResult() const;
+
+        /**
+         * Adds new points to the trace and rematches the current window.
+         * If the window can not be matched, the older points are dropped and the window restarts from the new points.
+         * @param points The new points to add.
+         * @return The list of edges that became confirmed after this update, in trace order.
+         * @throws std::runtime_error If IO error occured during the route matching.
+         */
+        std::vector<RouteMatchingEdge> addPoints(const std::vector<MapPos>& points);
+        /**
+         * Ends the trace, matches the remaining points and resets the session.
+         * @return The list of remaining edges, in trace order.
+         * @throws std::runtime_error If IO error occured during the route matching.
+         */
+        std::vector<RouteMatchingEdge> finish();
+
+    private:
+        std::shared_ptr<RouteMatchingResult> matchPoints(const std::vector<MapPos>& points, const Variant& customParams) const;
+
+        static const std::size_t CONFIRMATION_POINTS;
+        static const std::size_t MAX_PENDING_POINTS;
+
+        const std::shared_ptr<RoutingService> _routingService;
+        const std::shared_ptr<Projection> _projection;
+        const float _accuracy;
+        Variant _customParams;
+
+        std::vector<MapPos> _pendingPoints;
+        std::shared_ptr<RouteMatchingResult> _pendingResult;
+        int _windowVersion; // incremented whenever points are removed from the window
+
+        mutable std::mutex _mutex;
+    };
+    
+}
+
+#endif
+
+#endif
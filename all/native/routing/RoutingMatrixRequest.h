@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_ROUTINGMATRIXREQUEST_H_
+#define _CARTO_ROUTINGMATRIXREQUEST_H_
+
+#ifdef _CARTO_ROUTING_SUPPORT
+
+#include "core/MapPos.h"
+#include "core/Variant.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace carto {
+    class Projection;
+
+    /**
+     * A class that defines required attributes for routing matrix calculation (source and target points, etc).
+     */
+    class RoutingMatrixRequest {
+    public:
+        /**
+         * Constructs a new RoutingMatrixRequest instance from projection, source points and target points.
+         * @param projection The projection of the points.
+         * @param sourcePoints The list of source points. Must contain at least 1 element.
+         * @param targetPoints The list of target points. Must contain at least 1 element.
+         */
+        RoutingMatrixRequest(const std::shared_ptr<Projection>& projection, const std::vector<MapPos>& sourcePoints, const std::vector<MapPos>& targetPoints);
+        virtual ~RoutingMatrixRequest();
+
+        /**
+         * Returns the projection of the points in the request.
+         * @return The projection of the request.
+         */
+        const std::shared_ptr<Projection>& getProjection() const;
+        /**
+         * Returns the source point list of the request.
+         * @return The source point list of the request.
+         */
+        const std::vector<MapPos>& getSourcePoints() const;
+        /**
+         * Returns the target point list of the request.
+         * @return The target point list of the request.
+         */
+        const std::vector<MapPos>& getTargetPoints() const;
+
+        /**
+         * Returns the set of custom parameters of the request as a variant.
+         * @return The set of custom parameters as a variant. Can be empty.
+         */
+        Variant getCustomParameters() const;
+        /**
+         * Returns the custom parameter value of the request.
+         * @param param The name of the parameter to return.
+         * @return The value of the parameter. If the parameter does not exist, empty variant is returned.
+         */
+        Variant getCustomParameter(const std::string& param) const;
+        /**
+         * Sets a custom parameter value for the the request.
+         * @param param The name of the parameter. For example, "costing_options.auto.use_highways".
+         * @param value The new value for the parameter.
+         */
+        void setCustomParameter(const std::string& param, const Variant& value);
+
+        /**
+         * Creates a string representation of this request object, useful for logging.
+         * @return The string representation of this request object.
+         */
+        std::string toString() const;
+        
+    private:
+        const std::shared_ptr<Projection> _projection;
+        const std::vector<MapPos> _sourcePoints;
+        const std::vector<MapPos> _targetPoints;
+        Variant _customParams;
+
+        mutable std::mutex _mutex;
+    };
+    
+}
+
+#endif
+
+#endif
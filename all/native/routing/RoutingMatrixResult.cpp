@@ -0,0 +1,70 @@
+#ifdef _CARTO_ROUTING_SUPPORT
+
+#include "RoutingMatrixResult.h"
+#include "components/Exceptions.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace carto {
+
+    RoutingMatrixResult::RoutingMatrixResult(const std::shared_ptr<Projection>& projection, int sourceCount, int targetCount, const std::vector<double>& distances, const std::vector<double>& times) :
+        _projection(projection),
+        _sourceCount(sourceCount),
+        _targetCount(targetCount),
+        _distances(distances),
+        _times(times)
+    {
+        if (!projection) {
+            throw NullArgumentException("Null projection");
+        }
+        if (sourceCount < 0 || targetCount < 0) {
+            throw InvalidArgumentException("Negative matrix dimensions");
+        }
+        if (distances.size() != static_cast<std::size_t>(sourceCount) * targetCount || times.size() != static_cast<std::size_t>(sourceCount) * targetCount) {
+            throw InvalidArgumentException("Matrix size mismatch");
+        }
+    }
+
+    RoutingMatrixResult::~RoutingMatrixResult() {
+    }
+
+    const std::shared_ptr<Projection>& RoutingMatrixResult::getProjection() const {
+        return _projection;
+    }
+
+    int RoutingMatrixResult::getSourceCount() const {
+        return _sourceCount;
+    }
+
+    int RoutingMatrixResult::getTargetCount() const {
+        return _targetCount;
+    }
+
+    double RoutingMatrixResult::getDistance(int sourceIndex, int targetIndex) const {
+        if (sourceIndex < 0 || sourceIndex >= _sourceCount || targetIndex < 0 || targetIndex >= _targetCount) {
+            throw OutOfRangeException("Matrix index out of range");
+        }
+        return _distances[static_cast<std::size_t>(sourceIndex) * _targetCount + targetIndex];
+    }
+
+    double RoutingMatrixResult::getTime(int sourceIndex, int targetIndex) const {
+        if (sourceIndex < 0 || sourceIndex >= _sourceCount || targetIndex < 0 || targetIndex >= _targetCount) {
+            throw OutOfRangeException("Matrix index out of range");
+        }
+        return _times[static_cast<std::size_t>(sourceIndex) * _targetCount + targetIndex];
+    }
+
+    std::string RoutingMatrixResult::toString() const {
+        std::stringstream ss;
+        ss << std::setiosflags(std::ios::fixed);
+        ss << "RoutingMatrixResult [";
+        ss << "sourceCount=" << _sourceCount << ", ";
+        ss << "targetCount=" << _targetCount;
+        ss << "]";
+        return ss.str();
+    }
+
+}
+
+#endif
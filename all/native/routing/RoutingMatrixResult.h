@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_ROUTINGMATRIXRESULT_H_
+#define _CARTO_ROUTINGMATRIXRESULT_H_
+
+#ifdef _CARTO_ROUTING_SUPPORT
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace carto {
+    class Projection;
+
+    /**
+     * A class that contains distances and durations between all source and target point pairs of a routing matrix request.
+     */
+    class RoutingMatrixResult {
+    public:
+        /**
+         * Constructs a new RoutingMatrixResult instance from projection, point counts and flattened distance and time matrices.
+         * @param projection The projection of the routing result (same as the request).
+         * @param sourceCount The number of source points.
+         * @param targetCount The number of target points.
+         * @param distances The distances in meters, in row-major order (source index major). Negative values denote unreachable pairs.
+         * @param times The durations in seconds, in row-major order (source index major). Negative values denote unreachable pairs.
+         */
+        RoutingMatrixResult(const std::shared_ptr<Projection>& projection, int sourceCount, int targetCount, const std::vector<double>& distances, const std::vector<double>& times);
+        virtual ~RoutingMatrixResult();
+
+        /**
+         * Returns the projection of the result.
+         * @return The projection of the result.
+         */
+        const std::shared_ptr<Projection>& getProjection() const;
+        /**
+         * Returns the number of source points (matrix rows).
+         * @return The number of source points.
+         */
+        int getSourceCount() const;
+        /**
+         * Returns the number of target points (matrix columns).
+         * @return The number of target points.
+         */
+        int getTargetCount() const;
+
+        /**
+         * Returns the route distance between the given source and target points.
+         * @param sourceIndex The index of the source point.
+         * @param targetIndex The index of the target point.
+         * @return The distance in meters. If the target is not reachable from the source, -1 is returned.
+         */
+        double getDistance(int sourceIndex, int targetIndex) const;
+        /**
+         * Returns the approximate route duration between the given source and target points.
+         * @param sourceIndex The index of the source point.
+         * @param targetIndex The index of the target point.
+         * @return The duration in seconds. If the target is not reachable from the source, -1 is returned.
+         */
+        double getTime(int sourceIndex, int targetIndex) const;
+
+        /**
+         * Creates a string representation of this result object, useful for logging.
+         * @return The string representation of this result object.
+         */
+        std::string toString() const;
+        
+    private:
+        std::shared_ptr<Projection> _projection;
+        int _sourceCount;
+        int _targetCount;
+        std::vector<double> _distances;
+        std::vector<double> _times;
+    };
+    
+}
+
+#endif
+
+#endif
@@ -1,6 +1,7 @@
 #ifdef _CARTO_ROUTING_SUPPORT
 
 #include "RoutingService.h"
+#include "components/Exceptions.h"
 
 namespace carto {
 
@@ -10,6 +11,41 @@ namespace carto {
     RoutingService::~RoutingService() {
     }
 
+    std::shared_ptr<RoutingMatrixResult> RoutingService::calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const {
+        if (!request) {
+            throw NullArgumentException("Null request");
+        }
+
+        const std::vector<MapPos>& sourcePoints = request->getSourcePoints();
+        const std::vector<MapPos>& targetPoints = request->getTargetPoints();
+        Variant customParams = request->getCustomParameters();
+
+        std::vector<double> distances(sourcePoints.size() * targetPoints.size(), -1);
+        std::vector<double> times(sourcePoints.size() * targetPoints.size(), -1);
+        for (std::size_t i = 0; i < sourcePoints.size(); i++) {
+            for (std::size_t j = 0; j < targetPoints.size(); j++) {
+                auto routingRequest = std::make_shared<RoutingRequest>(request->getProjection(), std::vector<MapPos> { sourcePoints[i], targetPoints[j] });
+                if (customParams.getType() == VariantType::VARIANT_TYPE_OBJECT) {
+                    for (const std::string& key : customParams.getObjectKeys()) {
+                        routingRequest->setCustomParameter(key, customParams.getObjectElement(key));
+                    }
+                }
+
+                // Routing failures for individual pairs only mark the pair as unreachable, IO errors are propagated
+                std::shared_ptr<RoutingResult> result;
+                try {
+                    result = calculateRoute(routingRequest);
+                } catch (const GenericException&) {
+                }
+                if (result) {
+                    distances[i * targetPoints.size() + j] = result->getTotalDistance();
+                    times[i * targetPoints.size() + j] = result->getTotalTime();
+                }
+            }
+        }
+        return std::make_shared<RoutingMatrixResult>(request->getProjection(), static_cast<int>(sourcePoints.size()), static_cast<int>(targetPoints.size()), distances, times);
+    }
+
 }
 
 #endif
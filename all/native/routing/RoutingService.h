@@ -13,6 +13,8 @@
 #include "routing/RoutingResult.h"
 #include "routing/RouteMatchingRequest.h"
 #include "routing/RouteMatchingResult.h"
+#include "routing/RoutingMatrixRequest.h"
+#include "routing/RoutingMatrixResult.h"
 
 #include <memory>
 
@@ -52,6 +54,16 @@ namespace carto {
          */
         virtual std::shared_ptr<RoutingResult> calculateRoute(const std::shared_ptr<RoutingRequest>& request) const = 0;
 
+        /**
+         * Calculates route distances and durations between all source and target point pairs.
+         * The default implementation calculates a separate route for each pair, services that support
+         * one-to-many searches override this with a more efficient implementation.
+         * @param request The routing matrix request defining source and target points.
+         * @return The result or null if matrix calculation failed.
+         * @throws std::runtime_error If IO error occured during the calculation.
+         */
+        virtual std::shared_ptr<RoutingMatrixResult> calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const;
+
     protected:
         /**
          * The default constructor.
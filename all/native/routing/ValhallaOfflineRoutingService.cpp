@@ -16,6 +16,7 @@ namespace carto {
         _database(),
         _profile("pedestrian"),
         _configuration(ValhallaRoutingProxy::GetDefaultConfiguration()),
+        _cachedEngine(),
         _mutex()
     {
         _database.reset(new sqlite3pp::database());
@@ -55,6 +56,7 @@ namespace carto {
         }
         *subValue = value.toPicoJSON();
         _configuration = Variant::FromPicoJSON(config);
+        _cachedEngine.reset();
     }
 
     std::string ValhallaOfflineRoutingService::getProfile() const {
@@ -72,8 +74,17 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
-        std::lock_guard<std::mutex> lock(_mutex);
-        return ValhallaRoutingProxy::MatchRoute(std::vector<std::shared_ptr<sqlite3pp::database> > { _database }, _profile, _configuration, request);
+        std::shared_ptr<ValhallaRoutingProxy::Engine> engine;
+        std::string profile;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_cachedEngine) {
+                _cachedEngine = std::make_shared<ValhallaRoutingProxy::Engine>(std::vector<std::shared_ptr<sqlite3pp::database> > { _database }, _configuration);
+            }
+            engine = _cachedEngine;
+            profile = _profile;
+        }
+        return ValhallaRoutingProxy::MatchRoute(*engine, profile, request);
     }
 
     std::shared_ptr<RoutingResult> ValhallaOfflineRoutingService::calculateRoute(const std::shared_ptr<RoutingRequest>& request) const {
@@ -81,8 +92,35 @@ namespace carto {
             throw NullArgumentException("Null request");
         }
 
-        std::lock_guard<std::mutex> lock(_mutex);
-        return ValhallaRoutingProxy::CalculateRoute(std::vector<std::shared_ptr<sqlite3pp::database> > { _database }, _profile, _configuration, request);
+        std::shared_ptr<ValhallaRoutingProxy::Engine> engine;
+        std::string profile;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_cachedEngine) {
+                _cachedEngine = std::make_shared<ValhallaRoutingProxy::Engine>(std::vector<std::shared_ptr<sqlite3pp::database> > { _database }, _configuration);
+            }
+            engine = _cachedEngine;
+            profile = _profile;
+        }
+        return ValhallaRoutingProxy::CalculateRoute(*engine, profile, request);
+    }
+
+    std::shared_ptr<RoutingMatrixResult> ValhallaOfflineRoutingService::calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const {
+        if (!request) {
+            throw NullArgumentException("Null request");
+        }
+
+        std::shared_ptr<ValhallaRoutingProxy::Engine> engine;
+        std::string profile;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_cachedEngine) {
+                _cachedEngine = std::make_shared<ValhallaRoutingProxy::Engine>(std::vector<std::shared_ptr<sqlite3pp::database> > { _database }, _configuration);
+            }
+            engine = _cachedEngine;
+            profile = _profile;
+        }
+        return ValhallaRoutingProxy::CalculateMatrix(*engine, profile, request);
     }
 
 }
@@ -11,6 +11,7 @@
 
 #include "core/Variant.h"
 #include "routing/RoutingService.h"
+#include "routing/ValhallaRoutingProxy.h"
 
 #include <memory>
 #include <mutex>
@@ -55,10 +56,13 @@ namespace carto {
 
         virtual std::shared_ptr<RoutingResult> calculateRoute(const std::shared_ptr<RoutingRequest>& request) const;
 
+        virtual std::shared_ptr<RoutingMatrixResult> calculateMatrix(const std::shared_ptr<RoutingMatrixRequest>& request) const;
+
     private:
         std::shared_ptr<sqlite3pp::database> _database;
         std::string _profile;
         Variant _configuration;
+        mutable std::shared_ptr<ValhallaRoutingProxy::Engine> _cachedEngine;
         mutable std::mutex _mutex;
     };
     
@@ -13,11 +13,14 @@
 #include "routing/RouteMatchingResult.h"
 #include "routing/RouteMatchingPoint.h"
 #include "routing/RouteMatchingEdge.h"
+#include "routing/RoutingMatrixRequest.h"
+#include "routing/RoutingMatrixResult.h"
 #include "network/HTTPClient.h"
 #include "utils/NetworkUtils.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
 
+#include <algorithm>
 #include <ctime>
 #include <vector>
 #include <functional>
@@ -27,6 +30,8 @@
 #include <cstdint>
 #include <sstream>
 #include <utility>
+#include <thread>
+#include <exception>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -69,6 +74,8 @@
 #include <valhalla/tyr/serializers.h>
 #include <valhalla/odin/util.h>
 #include <valhalla/odin/directionsbuilder.h>
+#include <valhalla/proto/api.pb.h>
+#include <valhalla/proto/directions.pb.h>
 
 #else
 
@@ -192,22 +199,87 @@ namespace carto {
     }
 
 #ifdef _CARTO_VALHALLA_ROUTING_SUPPORT
-    std::shared_ptr<RouteMatchingResult> ValhallaRoutingProxy::MatchRoute(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::string& profile, const Variant& config, const std::shared_ptr<RouteMatchingRequest>& request) {
-        std::string resultString;
+    struct ValhallaRoutingProxy::Engine::Worker {
+        std::shared_ptr<valhalla::baldr::GraphReader> reader;
+        valhalla::loki::loki_worker_t lokiWorker;
+        valhalla::thor::thor_worker_t thorWorker;
+        valhalla::odin::odin_worker_t odinWorker;
+
+        Worker(const boost::property_tree::ptree& configTree, const std::shared_ptr<valhalla::baldr::GraphReader>& reader) :
+            reader(reader),
+            lokiWorker(configTree, reader),
+            thorWorker(configTree, reader),
+            odinWorker(configTree)
+        {
+        }
+
+        void cleanup() {
+            lokiWorker.cleanup();
+            thorWorker.cleanup();
+            odinWorker.cleanup();
+        }
+    };
+
+    ValhallaRoutingProxy::Engine::Engine(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const Variant& config) :
+        _databases(databases),
+        _configTree(),
+        _idleWorkers(),
+        _mutex()
+    {
         try {
             std::stringstream ss;
             ss << config.toPicoJSON().serialize();
-            boost::property_tree::ptree configTree;
-            rapidjson::read_json(ss, configTree);
-            auto reader = std::make_shared<valhalla::baldr::GraphReader>(databases);
+            auto configTree = std::make_shared<boost::property_tree::ptree>();
+            rapidjson::read_json(ss, *configTree);
+            _configTree = configTree;
+        }
+        catch (const std::exception& ex) {
+            throw GenericException("Exception while parsing routing configuration", ex.what());
+        }
+    }
+
+    ValhallaRoutingProxy::Engine::~Engine() {
+    }
+
+    const std::vector<std::shared_ptr<sqlite3pp::database> >& ValhallaRoutingProxy::Engine::getDatabases() const {
+        return _databases;
+    }
+
+    std::shared_ptr<ValhallaRoutingProxy::Engine::Worker> ValhallaRoutingProxy::Engine::acquireWorker() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_idleWorkers.empty()) {
+                std::shared_ptr<Worker> worker = _idleWorkers.back();
+                _idleWorkers.pop_back();
+                return worker;
+            }
+        }
 
+        // Each worker has its own graph reader, as the tile cache of the reader is not synchronized
+        auto reader = std::make_shared<valhalla::baldr::GraphReader>(_databases);
+        return std::make_shared<Worker>(*_configTree, reader);
+    }
+
+    void ValhallaRoutingProxy::Engine::releaseWorker(const std::shared_ptr<Worker>& worker) {
+        worker->cleanup();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_idleWorkers.size() < MAX_IDLE_WORKERS) {
+            _idleWorkers.push_back(worker);
+        }
+    }
+
+    std::shared_ptr<RouteMatchingResult> ValhallaRoutingProxy::MatchRoute(Engine& engine, const std::string& profile, const std::shared_ptr<RouteMatchingRequest>& request) {
+        std::string resultString;
+        try {
             valhalla::Api api;
             valhalla::ParseApi(SerializeRouteMatchingRequest(profile, request), valhalla::Options::trace_attributes, api);
 
-            valhalla::loki::loki_worker_t lokiworker(configTree, reader);
-            lokiworker.trace(api);
-            valhalla::thor::thor_worker_t thorworker(configTree, reader);
-            resultString = thorworker.trace_attributes(api);
+            // Note: the worker is released only after successful requests, workers may be left in inconsistent state by exceptions
+            std::shared_ptr<Engine::Worker> worker = engine.acquireWorker();
+            worker->lokiWorker.trace(api);
+            resultString = worker->thorWorker.trace_attributes(api);
+            engine.releaseWorker(worker);
         }
         catch (const std::exception& ex) {
             throw GenericException("Exception while matching route", ex.what());
@@ -215,30 +287,83 @@ namespace carto {
         return ParseRouteMatchingResult(request->getProjection(), resultString);
     }
 
-    std::shared_ptr<RoutingResult> ValhallaRoutingProxy::CalculateRoute(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::string& profile, const Variant& config, const std::shared_ptr<RoutingRequest>& request) {
-        std::string resultString;
+    std::shared_ptr<RoutingResult> ValhallaRoutingProxy::CalculateRoute(Engine& engine, const std::string& profile, const std::shared_ptr<RoutingRequest>& request) {
+        valhalla::Api api;
         try {
-            std::stringstream ss;
-            ss << config.toPicoJSON().serialize();
-            boost::property_tree::ptree configTree;
-            rapidjson::read_json(ss, configTree);
-            auto reader = std::make_shared<valhalla::baldr::GraphReader>(databases);
-
-            valhalla::Api api;
             valhalla::ParseApi(SerializeRoutingRequest(profile, request), valhalla::Options::route, api);
 
-            valhalla::loki::loki_worker_t lokiworker(configTree, reader);
-            lokiworker.route(api);
-            valhalla::thor::thor_worker_t thorworker(configTree, reader);
-            thorworker.route(api);
-            valhalla::odin::odin_worker_t odinworker(configTree);
-            odinworker.narrate(api);
-            resultString = valhalla::tyr::serializeDirections(api);
+            // Note: the worker is released only after successful requests, workers may be left in inconsistent state by exceptions
+            std::shared_ptr<Engine::Worker> worker = engine.acquireWorker();
+            worker->lokiWorker.route(api);
+            worker->thorWorker.route(api);
+            worker->odinWorker.narrate(api);
+            engine.releaseWorker(worker);
         }
         catch (const std::exception& ex) {
             throw GenericException("Exception while calculating route", ex.what());
         }
-        return ParseRoutingResult(request->getProjection(), resultString);
+        return TranslateRoutingResult(request->getProjection(), api);
+    }
+
+    std::shared_ptr<RoutingMatrixResult> ValhallaRoutingProxy::CalculateMatrix(Engine& engine, const std::string& profile, const std::shared_ptr<RoutingMatrixRequest>& request) {
+        std::size_t sourceCount = request->getSourcePoints().size();
+        std::size_t targetCount = request->getTargetPoints().size();
+        std::vector<double> distances(sourceCount * targetCount, -1);
+        std::vector<double> times(sourceCount * targetCount, -1);
+        if (sourceCount == 0 || targetCount == 0) {
+            return std::make_shared<RoutingMatrixResult>(request->getProjection(), static_cast<int>(sourceCount), static_cast<int>(targetCount), distances, times);
+        }
+
+        // Split the sources into row blocks and calculate each block on a separate worker in parallel
+        std::size_t threadCount = std::max(std::size_t(1), std::min({ sourceCount, static_cast<std::size_t>(std::thread::hardware_concurrency()), Engine::MAX_MATRIX_THREADS }));
+        std::size_t blockSize = (sourceCount + threadCount - 1) / threadCount;
+        std::vector<std::exception_ptr> exceptions(threadCount);
+        auto calculateBlock = [&](std::size_t blockIndex) {
+            std::size_t sourceBegin = blockIndex * blockSize;
+            std::size_t sourceEnd = std::min(sourceCount, sourceBegin + blockSize);
+            if (sourceBegin >= sourceEnd) {
+                return;
+            }
+            try {
+                valhalla::Api api;
+                valhalla::ParseApi(SerializeRoutingMatrixRequest(profile, request, sourceBegin, sourceEnd), valhalla::Options::sources_to_targets, api);
+
+                // Note: the worker is released only after successful requests, workers may be left in inconsistent state by exceptions
+                std::shared_ptr<Engine::Worker> worker = engine.acquireWorker();
+                worker->lokiWorker.matrix(api);
+                std::string resultString = worker->thorWorker.matrix(api);
+                engine.releaseWorker(worker);
+
+                ParseRoutingMatrixResult(resultString, sourceEnd - sourceBegin, targetCount, &distances[sourceBegin * targetCount], &times[sourceBegin * targetCount]);
+            }
+            catch (...) {
+                exceptions[blockIndex] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < threadCount; i++) {
+            threads.emplace_back(calculateBlock, i);
+        }
+        calculateBlock(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        for (const std::exception_ptr& exception : exceptions) {
+            if (exception) {
+                try {
+                    std::rethrow_exception(exception);
+                }
+                catch (const GenericException&) {
+                    throw;
+                }
+                catch (const std::exception& ex) {
+                    throw GenericException("Exception while calculating matrix", ex.what());
+                }
+            }
+        }
+        return std::make_shared<RoutingMatrixResult>(request->getProjection(), static_cast<int>(sourceCount), static_cast<int>(targetCount), distances, times);
     }
 #endif
 
@@ -443,6 +568,37 @@ namespace carto {
         return picojson::value(json).serialize();
     }
 
+    std::string ValhallaRoutingProxy::SerializeRoutingMatrixRequest(const std::string& profile, const std::shared_ptr<RoutingMatrixRequest>& request, std::size_t sourceBegin, std::size_t sourceEnd) {
+        std::shared_ptr<Projection> proj = request->getProjection();
+
+        auto serializeLocations = [&proj](std::vector<MapPos>::const_iterator begin, std::vector<MapPos>::const_iterator end) {
+            picojson::array locations;
+            for (auto it = begin; it != end; it++) {
+                MapPos posWgs84 = proj->toWgs84(*it);
+                picojson::object location;
+                location["lon"] = picojson::value(posWgs84.getX());
+                location["lat"] = picojson::value(posWgs84.getY());
+                locations.emplace_back(location);
+            }
+            return locations;
+        };
+
+        const std::vector<MapPos>& sourcePoints = request->getSourcePoints();
+        const std::vector<MapPos>& targetPoints = request->getTargetPoints();
+
+        picojson::value customParams = request->getCustomParameters().toPicoJSON();
+
+        picojson::object json;
+        if (customParams.is<picojson::object>()) {
+            json = customParams.get<picojson::object>();
+        }
+        json["sources"] = picojson::value(serializeLocations(sourcePoints.begin() + sourceBegin, sourcePoints.begin() + sourceEnd));
+        json["targets"] = picojson::value(serializeLocations(targetPoints.begin(), targetPoints.end()));
+        json["costing"] = picojson::value(profile);
+        json["units"] = picojson::value("kilometers");
+        return picojson::value(json).serialize();
+    }
+
     std::shared_ptr<RouteMatchingResult> ValhallaRoutingProxy::ParseRouteMatchingResult(const std::shared_ptr<Projection>& proj, const std::string& resultString) {
         picojson::value result;
         std::string err = picojson::parse(result, resultString);
@@ -556,6 +712,99 @@ namespace carto {
         return std::make_shared<RoutingResult>(proj, points, instructions);
     }
 
+#ifdef _CARTO_VALHALLA_ROUTING_SUPPORT
+    std::shared_ptr<RoutingResult> ValhallaRoutingProxy::TranslateRoutingResult(const std::shared_ptr<Projection>& proj, const valhalla::Api& api) {
+        if (api.directions().routes_size() < 1) {
+            throw GenericException("No trip info in the result");
+        }
+
+        EPSG3857 epsg3857;
+        std::vector<MapPos> points;
+        std::vector<MapPos> epsg3857Points;
+        std::vector<RoutingInstruction> instructions;
+        try {
+            for (const valhalla::DirectionsLeg& leg : api.directions().routes(0).legs()) {
+                std::vector<valhalla::midgard::PointLL> shape = valhalla::midgard::decode<std::vector<valhalla::midgard::PointLL> >(leg.shape());
+                points.reserve(points.size() + shape.size());
+                epsg3857Points.reserve(epsg3857Points.size() + shape.size());
+
+                for (int i = 0; i < leg.maneuver_size(); i++) {
+                    const valhalla::DirectionsLeg::Maneuver& maneuver = leg.maneuver(i);
+
+                    RoutingAction::RoutingAction action = RoutingAction::ROUTING_ACTION_NO_TURN;
+                    TranslateManeuverType(static_cast<int>(maneuver.type()), action);
+                    if (action == RoutingAction::ROUTING_ACTION_FINISH && i + 1 < leg.maneuver_size()) {
+                        action = RoutingAction::ROUTING_ACTION_REACH_VIA_LOCATION;
+                    }
+
+                    std::size_t pointIndex = points.size();
+                    for (std::size_t j = maneuver.begin_shape_index(); j <= maneuver.end_shape_index(); j++) {
+                        const valhalla::midgard::PointLL& point = shape.at(j);
+                        epsg3857Points.push_back(epsg3857.fromLatLong(point.second, point.first));
+                        points.push_back(proj->fromLatLong(point.second, point.first));
+                    }
+
+                    float turnAngle = CalculateTurnAngle(epsg3857Points, pointIndex);
+                    float azimuth = CalculateAzimuth(epsg3857Points, pointIndex);
+
+                    std::string streetName;
+                    if (maneuver.street_name_size() > 0) {
+                        streetName = maneuver.street_name(0).value();
+                    }
+
+                    instructions.emplace_back(
+                        action,
+                        pointIndex,
+                        streetName,
+                        turnAngle,
+                        azimuth,
+                        maneuver.length() * 1000.0,
+                        maneuver.time()
+                    );
+                }
+            }
+        }
+        catch (const std::exception& ex) {
+            throw GenericException("Exception while translating route", ex.what());
+        }
+        return std::make_shared<RoutingResult>(proj, points, instructions);
+    }
+#endif
+
+    void ValhallaRoutingProxy::ParseRoutingMatrixResult(const std::string& resultString, std::size_t sourceCount, std::size_t targetCount, double* distances, double* times) {
+        picojson::value result;
+        std::string err = picojson::parse(result, resultString);
+        if (!err.empty()) {
+            throw GenericException("Failed to parse result", err);
+        }
+        if (!result.get("sources_to_targets").is<picojson::array>()) {
+            throw GenericException("No sources_to_targets info in the result");
+        }
+
+        const picojson::array& rows = result.get("sources_to_targets").get<picojson::array>();
+        if (rows.size() != sourceCount) {
+            throw GenericException("Unexpected number of sources_to_targets rows in the result");
+        }
+
+        try {
+            for (std::size_t i = 0; i < rows.size(); i++) {
+                const picojson::array& row = rows[i].get<picojson::array>();
+                for (std::size_t j = 0; j < row.size() && j < targetCount; j++) {
+                    // Unreachable pairs have null distance and time, these are kept as -1
+                    const picojson::value& distance = row[j].get("distance");
+                    const picojson::value& time = row[j].get("time");
+                    if (distance.is<double>() && time.is<double>()) {
+                        distances[i * targetCount + j] = distance.get<double>() * 1000.0;
+                        times[i * targetCount + j] = time.get<double>();
+                    }
+                }
+            }
+        }
+        catch (const std::exception& ex) {
+            throw GenericException("Exception while translating matrix", ex.what());
+        }
+    }
+
     std::string ValhallaRoutingProxy::MakeHTTPRequest(HTTPClient& httpClient, const std::string& url) {
         std::map<std::string, std::string> requestHeaders;
         requestHeaders["Connection"] = "close";
@@ -591,6 +840,11 @@ namespace carto {
     ValhallaRoutingProxy::ValhallaRoutingProxy() {
     }
 
+#ifdef _CARTO_VALHALLA_ROUTING_SUPPORT
+    const std::size_t ValhallaRoutingProxy::Engine::MAX_IDLE_WORKERS = 4;
+    const std::size_t ValhallaRoutingProxy::Engine::MAX_MATRIX_THREADS = 4;
+#endif
+
 }
 
 #endif
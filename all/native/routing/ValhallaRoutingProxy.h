@@ -13,13 +13,24 @@
 #include "routing/RoutingInstruction.h"
 
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <unordered_map>
 
+#ifdef _CARTO_VALHALLA_ROUTING_SUPPORT
+#include <boost/property_tree/ptree_fwd.hpp>
+#endif
+
 namespace sqlite3pp {
     class database;
 }
 
+#ifdef _CARTO_VALHALLA_ROUTING_SUPPORT
+namespace valhalla {
+    class Api;
+}
+#endif
+
 namespace carto {
     class HTTPClient;
     class Projection;
@@ -27,6 +38,8 @@ namespace carto {
     class RoutingResult;
     class RouteMatchingRequest;
     class RouteMatchingResult;
+    class RoutingMatrixRequest;
+    class RoutingMatrixResult;
     
     class ValhallaRoutingProxy {
     public:
@@ -34,8 +47,33 @@ namespace carto {
         static std::shared_ptr<RoutingResult> CalculateRoute(HTTPClient& httpClient, const std::string& baseURL, const std::string& profile, const std::shared_ptr<RoutingRequest>& request);
 
 #ifdef _CARTO_VALHALLA_ROUTING_SUPPORT
-        static std::shared_ptr<RouteMatchingResult> MatchRoute(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::string& profile, const Variant& config, const std::shared_ptr<RouteMatchingRequest>& request);
-        static std::shared_ptr<RoutingResult> CalculateRoute(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const std::string& profile, const Variant& config, const std::shared_ptr<RoutingRequest>& request);
+        class Engine {
+        public:
+            Engine(const std::vector<std::shared_ptr<sqlite3pp::database> >& databases, const Variant& config);
+            ~Engine();
+
+            const std::vector<std::shared_ptr<sqlite3pp::database> >& getDatabases() const;
+
+        private:
+            friend class ValhallaRoutingProxy;
+
+            struct Worker;
+
+            std::shared_ptr<Worker> acquireWorker();
+            void releaseWorker(const std::shared_ptr<Worker>& worker);
+
+            static const std::size_t MAX_IDLE_WORKERS;
+            static const std::size_t MAX_MATRIX_THREADS;
+
+            const std::vector<std::shared_ptr<sqlite3pp::database> > _databases;
+            std::shared_ptr<const boost::property_tree::ptree> _configTree;
+            std::vector<std::shared_ptr<Worker> > _idleWorkers;
+            mutable std::mutex _mutex;
+        };
+
+        static std::shared_ptr<RouteMatchingResult> MatchRoute(Engine& engine, const std::string& profile, const std::shared_ptr<RouteMatchingRequest>& request);
+        static std::shared_ptr<RoutingResult> CalculateRoute(Engine& engine, const std::string& profile, const std::shared_ptr<RoutingRequest>& request);
+        static std::shared_ptr<RoutingMatrixResult> CalculateMatrix(Engine& engine, const std::string& profile, const std::shared_ptr<RoutingMatrixRequest>& request);
 #endif
 
         static Variant GetDefaultConfiguration();
@@ -53,10 +91,18 @@ namespace carto {
 
         static std::string SerializeRoutingRequest(const std::string& profile, const std::shared_ptr<RoutingRequest>& request);
 
+        static std::string SerializeRoutingMatrixRequest(const std::string& profile, const std::shared_ptr<RoutingMatrixRequest>& request, std::size_t sourceBegin, std::size_t sourceEnd);
+
         static std::shared_ptr<RouteMatchingResult> ParseRouteMatchingResult(const std::shared_ptr<Projection>& proj, const std::string& resultString);
 
         static std::shared_ptr<RoutingResult> ParseRoutingResult(const std::shared_ptr<Projection>& proj, const std::string& resultString);
 
+        static void ParseRoutingMatrixResult(const std::string& resultString, std::size_t sourceCount, std::size_t targetCount, double* distances, double* times);
+
+#ifdef _CARTO_VALHALLA_ROUTING_SUPPORT
+        static std::shared_ptr<RoutingResult> TranslateRoutingResult(const std::shared_ptr<Projection>& proj, const valhalla::Api& api);
+#endif
+
         static std::string MakeHTTPRequest(HTTPClient& httpClient, const std::string& url);
     };
 
@@ -5,17 +5,60 @@
 #include "geometry/Geometry.h"
 #include "geometry/Feature.h"
 #include "geometry/FeatureCollection.h"
+#include "geometry/utils/RTreeSpatialIndex.h"
 #include "search/SearchProxy.h"
+#include "search/query/QueryExpressionImpl.h"
 #include "projections/Projection.h"
 #include "projections/EPSG3857.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace {
+
+    template <typename Pred>
+    bool ExtractPropertyComparison(const std::shared_ptr<carto::QueryExpression>& expr, std::string& name, carto::Variant& value, bool& swapped) {
+        using namespace carto::queryexpressionimpl;
+
+        auto predExpr = std::dynamic_pointer_cast<BinaryPredicateExpression<Pred> >(expr);
+        if (!predExpr) {
+            return false;
+        }
+
+        auto varOp = std::dynamic_pointer_cast<VariableOperand>(predExpr->getOperand1());
+        auto constOp = std::dynamic_pointer_cast<ConstOperand>(predExpr->getOperand2());
+        swapped = false;
+        if (!varOp || !constOp) {
+            varOp = std::dynamic_pointer_cast<VariableOperand>(predExpr->getOperand2());
+            constOp = std::dynamic_pointer_cast<ConstOperand>(predExpr->getOperand1());
+            swapped = true;
+        }
+        if (!varOp || !constOp || varOp->isNoCase()) {
+            return false;
+        }
+
+        // Special variables are not stored in feature properties
+        if (varOp->getName() == "layer::name" || varOp->getName() == "geometry::type" || varOp->getName() == "geometry::vertices") {
+            return false;
+        }
+
+        name = varOp->getName();
+        value = constOp->getValue();
+        return true;
+    }
+
+}
+
 namespace carto {
 
     FeatureCollectionSearchService::FeatureCollectionSearchService(const std::shared_ptr<Projection>& projection, const std::shared_ptr<FeatureCollection>& featureCollection) :
         _projection(projection),
         _featureCollection(featureCollection),
+        _spatialIndex(),
         _maxResults(1000),
+        _propertyIndices(),
         _mutex()
     {
         if (!projection) {
@@ -24,6 +67,17 @@ namespace carto {
         if (!featureCollection) {
             throw NullArgumentException("Null featureCollection");
         }
+
+        std::vector<std::pair<cglib::bbox3<double>, int> > records;
+        records.reserve(featureCollection->getFeatureCount());
+        for (int i = 0; i < featureCollection->getFeatureCount(); i++) {
+            if (std::shared_ptr<Geometry> geometry = featureCollection->getFeature(i)->getGeometry()) {
+                const MapBounds& bounds = geometry->getBounds();
+                records.emplace_back(cglib::bbox3<double>(cglib::vec3<double>(bounds.getMin().getX(), bounds.getMin().getY(), 0), cglib::vec3<double>(bounds.getMax().getX(), bounds.getMax().getY(), 0)), i);
+            }
+        }
+        _spatialIndex = std::make_shared<RTreeSpatialIndex<int> >();
+        _spatialIndex->insertAll(records);
     }
 
     FeatureCollectionSearchService::~FeatureCollectionSearchService() {
@@ -59,13 +113,47 @@ namespace carto {
             maxResults = _maxResults;
         }
 
+        // Use the spatial and attribute indices to find the candidate features. The candidates are tested
+        // in the original order, so the results are the same as when testing all the features.
+        std::vector<int> candidates;
+        bool constrained = false;
+        if (request->getGeometry()) {
+            MapBounds searchBounds = proxy.getSearchBounds();
+            if (!std::dynamic_pointer_cast<EPSG3857>(_projection)) {
+                EPSG3857 epsg3857;
+                MapBounds projectedBounds;
+                projectedBounds.expandToContain(_projection->fromWgs84(epsg3857.toWgs84(searchBounds.getMin())));
+                projectedBounds.expandToContain(_projection->fromWgs84(epsg3857.toWgs84(MapPos(searchBounds.getMin().getX(), searchBounds.getMax().getY()))));
+                projectedBounds.expandToContain(_projection->fromWgs84(epsg3857.toWgs84(searchBounds.getMax())));
+                projectedBounds.expandToContain(_projection->fromWgs84(epsg3857.toWgs84(MapPos(searchBounds.getMax().getX(), searchBounds.getMin().getY()))));
+                searchBounds = projectedBounds;
+            }
+            candidates = _spatialIndex->query(cglib::bbox3<double>(cglib::vec3<double>(searchBounds.getMin().getX(), searchBounds.getMin().getY(), 0), cglib::vec3<double>(searchBounds.getMax().getX(), searchBounds.getMax().getY(), 0)));
+            std::sort(candidates.begin(), candidates.end());
+            constrained = true;
+        }
+        if (proxy.getFilterExpression()) {
+            std::vector<int> exprCandidates;
+            if (findCandidates(proxy.getFilterExpression(), exprCandidates)) {
+                if (constrained) {
+                    std::vector<int> intersection;
+                    std::set_intersection(candidates.begin(), candidates.end(), exprCandidates.begin(), exprCandidates.end(), std::back_inserter(intersection));
+                    std::swap(candidates, intersection);
+                } else {
+                    std::swap(candidates, exprCandidates);
+                }
+                constrained = true;
+            }
+        }
+
         std::vector<std::shared_ptr<Feature> > features;
-        for (int i = 0; i < _featureCollection->getFeatureCount(); i++) {
+        int featureCount = (constrained ? static_cast<int>(candidates.size()) : _featureCollection->getFeatureCount());
+        for (int i = 0; i < featureCount; i++) {
             if (static_cast<int>(features.size()) >= maxResults) {
                 break;
             }
 
-            const std::shared_ptr<Feature>& feature = _featureCollection->getFeature(i);
+            std::shared_ptr<Feature> feature = _featureCollection->getFeature(constrained ? candidates[i] : i);
 
             if (proxy.testElement(feature->getGeometry(), nullptr, feature->getProperties())) {
                 features.push_back(feature);
@@ -74,6 +162,123 @@ namespace carto {
         return std::make_shared<FeatureCollection>(features);
     }
 
+    bool FeatureCollectionSearchService::findCandidates(const std::shared_ptr<QueryExpression>& expr, std::vector<int>& candidates) const {
+        using namespace queryexpressionimpl;
+
+        if (auto andExpr = std::dynamic_pointer_cast<AndExpression>(expr)) {
+            std::vector<int> candidates1, candidates2;
+            bool constrained1 = findCandidates(andExpr->getExpression1(), candidates1);
+            bool constrained2 = findCandidates(andExpr->getExpression2(), candidates2);
+            if (constrained1 && constrained2) {
+                std::set_intersection(candidates1.begin(), candidates1.end(), candidates2.begin(), candidates2.end(), std::back_inserter(candidates));
+            } else if (constrained1) {
+                std::swap(candidates, candidates1);
+            } else if (constrained2) {
+                std::swap(candidates, candidates2);
+            }
+            return constrained1 || constrained2;
+        }
+
+        if (auto orExpr = std::dynamic_pointer_cast<OrExpression>(expr)) {
+            std::vector<int> candidates1, candidates2;
+            if (!findCandidates(orExpr->getExpression1(), candidates1) || !findCandidates(orExpr->getExpression2(), candidates2)) {
+                return false;
+            }
+            std::set_union(candidates1.begin(), candidates1.end(), candidates2.begin(), candidates2.end(), std::back_inserter(candidates));
+            return true;
+        }
+
+        // Comparisons between a property and a constant. Integer values are indexed as doubles and
+        // numeric ranges are always inclusive, thus the candidates may include features not matching the expression.
+        std::string name;
+        Variant value;
+        bool swapped = false;
+        double minValue = -std::numeric_limits<double>::infinity();
+        double maxValue = std::numeric_limits<double>::infinity();
+        if (ExtractPropertyComparison<EqPredicate>(expr, name, value, swapped)) {
+            switch (value.getType()) {
+            case VariantType::VARIANT_TYPE_STRING:
+            case VariantType::VARIANT_TYPE_BOOL:
+                {
+                    std::shared_ptr<PropertyIndex> index = getPropertyIndex(name);
+                    auto it = index->stringValues.find(value.getString());
+                    if (it != index->stringValues.end()) {
+                        candidates = it->second;
+                    }
+                }
+                return true;
+            case VariantType::VARIANT_TYPE_INTEGER:
+            case VariantType::VARIANT_TYPE_DOUBLE:
+                minValue = maxValue = value.getDouble();
+                break;
+            case VariantType::VARIANT_TYPE_NULL:
+                return true; // comparison with null is always false
+            default:
+                return false;
+            }
+        } else if (ExtractPropertyComparison<LtPredicate>(expr, name, value, swapped) || ExtractPropertyComparison<LtePredicate>(expr, name, value, swapped)) {
+            (swapped ? minValue : maxValue) = value.getDouble();
+        } else if (ExtractPropertyComparison<GtPredicate>(expr, name, value, swapped) || ExtractPropertyComparison<GtePredicate>(expr, name, value, swapped)) {
+            (swapped ? maxValue : minValue) = value.getDouble();
+        } else {
+            return false;
+        }
+
+        if (value.getType() != VariantType::VARIANT_TYPE_INTEGER && value.getType() != VariantType::VARIANT_TYPE_DOUBLE) {
+            return false;
+        }
+
+        std::shared_ptr<PropertyIndex> index = getPropertyIndex(name);
+        auto it0 = std::lower_bound(index->numericValues.begin(), index->numericValues.end(), std::make_pair(minValue, std::numeric_limits<int>::min()));
+        auto it1 = std::upper_bound(index->numericValues.begin(), index->numericValues.end(), std::make_pair(maxValue, std::numeric_limits<int>::max()));
+        for (auto it = it0; it < it1; it++) {
+            candidates.push_back(it->second);
+        }
+        std::sort(candidates.begin(), candidates.end());
+        return true;
+    }
+
+    std::shared_ptr<FeatureCollectionSearchService::PropertyIndex> FeatureCollectionSearchService::getPropertyIndex(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _propertyIndices.find(name);
+        if (it != _propertyIndices.end()) {
+            return it->second;
+        }
+
+        // Index the values the same way they are resolved when evaluating the expressions
+        auto index = std::make_shared<PropertyIndex>();
+        for (int i = 0; i < _featureCollection->getFeatureCount(); i++) {
+            const Variant& properties = _featureCollection->getFeature(i)->getProperties();
+            Variant value;
+            if (properties.getType() == VariantType::VARIANT_TYPE_OBJECT) {
+                if (!properties.containsObjectKey(name)) {
+                    continue;
+                }
+                value = properties.getObjectElement(name);
+            } else if (properties.getType() != VariantType::VARIANT_TYPE_ARRAY && name == "value") {
+                value = properties;
+            }
+
+            switch (value.getType()) {
+            case VariantType::VARIANT_TYPE_STRING:
+            case VariantType::VARIANT_TYPE_BOOL:
+                index->stringValues[value.getString()].push_back(i);
+                break;
+            case VariantType::VARIANT_TYPE_INTEGER:
+            case VariantType::VARIANT_TYPE_DOUBLE:
+                index->numericValues.emplace_back(value.getDouble(), i);
+                break;
+            default:
+                break;
+            }
+        }
+        std::sort(index->numericValues.begin(), index->numericValues.end());
+
+        _propertyIndices[name] = index;
+        return index;
+    }
+
 }
 
 #endif
@@ -11,16 +11,24 @@
 
 #include "search/SearchRequest.h"
 
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace carto {
     class FeatureCollection;
     class Projection;
+    class QueryExpression;
+    template <typename T> class RTreeSpatialIndex;
 
     /**
      * A search service for finding features from a specified feature collection.
+     * A spatial index of the features is built when the service is constructed. Attribute indices are built
+     * on demand, when a filter expression first uses a property in an equality or numeric range comparison.
      */
     class FeatureCollectionSearchService {
     public:
@@ -64,11 +72,23 @@ namespace carto {
         virtual std::shared_ptr<FeatureCollection> findFeatures(const std::shared_ptr<SearchRequest>& request) const;
 
     protected:
+        struct PropertyIndex {
+            std::unordered_map<std::string, std::vector<int> > stringValues;
+            std::vector<std::pair<double, int> > numericValues; // sorted by value
+        };
+
+        bool findCandidates(const std::shared_ptr<QueryExpression>& expr, std::vector<int>& candidates) const;
+
+        std::shared_ptr<PropertyIndex> getPropertyIndex(const std::string& name) const;
+
         const std::shared_ptr<Projection> _projection;
         const std::shared_ptr<FeatureCollection> _featureCollection;
+        std::shared_ptr<RTreeSpatialIndex<int> > _spatialIndex;
 
         int _maxResults;
 
+        mutable std::map<std::string, std::shared_ptr<PropertyIndex> > _propertyIndices;
+
         mutable std::mutex _mutex;
     };
     
@@ -13,29 +13,23 @@
 #include "geometry/MultiPolygonGeometry.h"
 #include "geometry/MultiGeometry.h"
 #include "search/query/QueryContext.h"
+#include "search/query/QueryExpressionImpl.h"
 #include "search/query/QueryExpressionParser.h"
 #include "projections/Projection.h"
 #include "projections/EPSG3857.h"
 #include "utils/Const.h"
 #include "utils/Log.h"
 
-#include <boost/geometry.hpp>
-#include <boost/geometry/geometries/linestring.hpp>
-#include <boost/geometry/geometries/point_xy.hpp>
-#include <boost/geometry/geometries/polygon.hpp>
-#include <boost/variant.hpp>
 #include <boost/optional.hpp>
 
+#include <cmath>
 #include <limits>
 #include <algorithm>
 #include <numeric>
 
-namespace {
+#include <picojson/picojson.h>
 
-    typedef boost::geometry::model::d2::point_xy<double> BoostPointType;
-    typedef boost::geometry::model::linestring<BoostPointType> BoostLinestringType;
-    typedef boost::geometry::model::polygon<BoostPointType> BoostPolygonType;
-    typedef boost::variant<BoostPointType, BoostLinestringType, BoostPolygonType> BoostGeometryType;
+namespace {
 
     carto::MapBounds convertToEPSG3857(const carto::MapBounds& mapBounds, const std::shared_ptr<carto::Projection>& proj) {
         if (std::dynamic_pointer_cast<carto::EPSG3857>(proj)) {
@@ -84,38 +78,101 @@ namespace {
         }
     }
 
-    BoostGeometryType convertToBoostGeometry(const std::shared_ptr<carto::Geometry>& geometry) {
+    struct PosSpan {
+        const carto::MapPos* poses;
+        std::size_t count;
+        bool closed;
+    };
+
+    bool getPosSpans(const std::shared_ptr<carto::Geometry>& geometry, std::vector<PosSpan>& spans) {
         if (auto pointGeometry = std::dynamic_pointer_cast<carto::PointGeometry>(geometry)) {
-            carto::MapPos mapPos = pointGeometry->getPos();
-            BoostPointType boostPoint(mapPos.getX(), mapPos.getY());
-            return boostPoint;
+            spans.push_back(PosSpan { &pointGeometry->getPos(), 1, false });
+            return false;
         } else if (auto lineGeometry = std::dynamic_pointer_cast<carto::LineGeometry>(geometry)) {
             const std::vector<carto::MapPos>& mapPoses = lineGeometry->getPoses();
-            BoostLinestringType boostLinestring;
-            std::for_each(mapPoses.begin(), mapPoses.end(), [&boostLinestring](const carto::MapPos& mapPos) { boostLinestring.push_back(BoostPointType(mapPos.getX(), mapPos.getY())); });
-            return boostLinestring;
+            spans.push_back(PosSpan { mapPoses.data(), mapPoses.size(), false });
+            return false;
         } else if (auto polygonGeometry = std::dynamic_pointer_cast<carto::PolygonGeometry>(geometry)) {
-            const std::vector<std::vector<carto::MapPos> >& rings = polygonGeometry->getRings();
-            BoostPolygonType boostPolygon;
-            for (std::size_t i = 0; i < rings.size(); i++) {
-                BoostPolygonType::ring_type boostRing;
-                std::for_each(rings[i].begin(), rings[i].end(), [&boostRing](const carto::MapPos& mapPos) { boostRing.push_back(BoostPointType(mapPos.getX(), mapPos.getY())); });
-                if (!boostRing.empty()) {
-                    BoostPointType pos = boostRing.front();
-                    boostRing.push_back(pos);
-                }
-                if (i == 0) {
-                    boostPolygon.outer() = std::move(boostRing);
-                } else {
-                    boostPolygon.inners().push_back(std::move(boostRing));
-                }
+            for (const std::vector<carto::MapPos>& ring : polygonGeometry->getRings()) {
+                spans.push_back(PosSpan { ring.data(), ring.size(), true });
             }
-            return boostPolygon;
+            return true;
         } else {
             throw carto::GenericException("Unsupported geometry type");
         }
     }
 
+    double calculatePointSegmentDistance2(const carto::MapPos& pos, const carto::MapPos& segPos0, const carto::MapPos& segPos1) {
+        double dx = segPos1.getX() - segPos0.getX(), dy = segPos1.getY() - segPos0.getY();
+        double len2 = dx * dx + dy * dy;
+        double t = 0;
+        if (len2 > 0) {
+            t = std::max(0.0, std::min(1.0, ((pos.getX() - segPos0.getX()) * dx + (pos.getY() - segPos0.getY()) * dy) / len2));
+        }
+        double ex = segPos0.getX() + dx * t - pos.getX(), ey = segPos0.getY() + dy * t - pos.getY();
+        return ex * ex + ey * ey;
+    }
+
+    double calculateSegmentDistance2(const carto::MapPos& pos0, const carto::MapPos& pos1, const carto::MapPos& segPos0, const carto::MapPos& segPos1) {
+        // Proper crossing, touching and collinear cases are covered by the endpoint distances below
+        auto cross = [](const carto::MapPos& origin, const carto::MapPos& p0, const carto::MapPos& p1) {
+            return (p0.getX() - origin.getX()) * (p1.getY() - origin.getY()) - (p0.getY() - origin.getY()) * (p1.getX() - origin.getX());
+        };
+        double d0 = cross(segPos0, segPos1, pos0), d1 = cross(segPos0, segPos1, pos1);
+        double d2 = cross(pos0, pos1, segPos0), d3 = cross(pos0, pos1, segPos1);
+        if (((d0 > 0 && d1 < 0) || (d0 < 0 && d1 > 0)) && ((d2 > 0 && d3 < 0) || (d2 < 0 && d3 > 0))) {
+            return 0;
+        }
+
+        double dist2 = std::min(calculatePointSegmentDistance2(pos0, segPos0, segPos1), calculatePointSegmentDistance2(pos1, segPos0, segPos1));
+        dist2 = std::min(dist2, calculatePointSegmentDistance2(segPos0, pos0, pos1));
+        return std::min(dist2, calculatePointSegmentDistance2(segPos1, pos0, pos1));
+    }
+
+    bool isInsidePolygon(const carto::MapPos& pos, const std::vector<PosSpan>& rings) {
+        // Even-odd rule over all rings, thus positions inside holes are outside of the polygon
+        bool inside = false;
+        for (const PosSpan& ring : rings) {
+            for (std::size_t i = 0, j = ring.count - 1; i < ring.count; j = i++) {
+                const carto::MapPos& pos0 = ring.poses[i];
+                const carto::MapPos& pos1 = ring.poses[j];
+                if ((pos0.getY() > pos.getY()) != (pos1.getY() > pos.getY())) {
+                    if (pos.getX() < pos0.getX() + (pos1.getX() - pos0.getX()) * (pos.getY() - pos0.getY()) / (pos1.getY() - pos0.getY())) {
+                        inside = !inside;
+                    }
+                }
+            }
+        }
+        return inside;
+    }
+
+    void calculateSpanDistance2(const PosSpan& span1, const PosSpan& span2, double& minDist2) {
+        std::size_t segCount1 = (span1.count > 1 && !span1.closed ? span1.count - 1 : span1.count);
+        std::size_t segCount2 = (span2.count > 1 && !span2.closed ? span2.count - 1 : span2.count);
+        for (std::size_t i = 0; i < segCount1 && minDist2 > 0; i++) {
+            const carto::MapPos& pos0 = span1.poses[i];
+            const carto::MapPos& pos1 = span1.poses[(i + 1) % span1.count];
+            double minX = std::min(pos0.getX(), pos1.getX()), maxX = std::max(pos0.getX(), pos1.getX());
+            double minY = std::min(pos0.getY(), pos1.getY()), maxY = std::max(pos0.getY(), pos1.getY());
+            for (std::size_t j = 0; j < segCount2; j++) {
+                const carto::MapPos& segPos0 = span2.poses[j];
+                const carto::MapPos& segPos1 = span2.poses[(j + 1) % span2.count];
+
+                // Skip the segment pairs whose bounding boxes are further than the current minimum
+                double dx = std::max(0.0, std::max(std::min(segPos0.getX(), segPos1.getX()) - maxX, minX - std::max(segPos0.getX(), segPos1.getX())));
+                double dy = std::max(0.0, std::max(std::min(segPos0.getY(), segPos1.getY()) - maxY, minY - std::max(segPos0.getY(), segPos1.getY())));
+                if (dx * dx + dy * dy >= minDist2) {
+                    continue;
+                }
+
+                minDist2 = std::min(minDist2, calculateSegmentDistance2(pos0, pos1, segPos0, segPos1));
+                if (minDist2 == 0) {
+                    return;
+                }
+            }
+        }
+    }
+
     double calculateDistance(const std::shared_ptr<carto::Geometry>& geometry1, const std::shared_ptr<carto::Geometry>& geometry2) {
         if (auto multiGeometry1 = std::dynamic_pointer_cast<carto::MultiGeometry>(geometry1)) {
             double dist = std::numeric_limits<double>::infinity();
@@ -133,37 +190,98 @@ namespace {
             return dist;
         }
 
-        return boost::geometry::distance(convertToBoostGeometry(geometry1), convertToBoostGeometry(geometry2));
+        // Distance is zero if either geometry is inside a polygon, otherwise the minimum distance between the segments
+        std::vector<PosSpan> spans1, spans2;
+        bool polygon1 = getPosSpans(geometry1, spans1);
+        bool polygon2 = getPosSpans(geometry2, spans2);
+        spans1.erase(std::remove_if(spans1.begin(), spans1.end(), [](const PosSpan& span) { return span.count == 0; }), spans1.end());
+        spans2.erase(std::remove_if(spans2.begin(), spans2.end(), [](const PosSpan& span) { return span.count == 0; }), spans2.end());
+        if (spans1.empty() || spans2.empty()) {
+            return std::numeric_limits<double>::infinity();
+        }
+        if (polygon1 && isInsidePolygon(spans2.front().poses[0], spans1)) {
+            return 0;
+        }
+        if (polygon2 && isInsidePolygon(spans1.front().poses[0], spans2)) {
+            return 0;
+        }
+
+        double minDist2 = std::numeric_limits<double>::infinity();
+        for (const PosSpan& span1 : spans1) {
+            for (const PosSpan& span2 : spans2) {
+                calculateSpanDistance2(span1, span2, minDist2);
+            }
+        }
+        return std::sqrt(minDist2);
     }
 
-    bool matchRegexFilter(const carto::Variant& variant, const std::regex& re) {
-        std::string str;
-        switch (variant.getType()) {
-        case carto::VariantType::VARIANT_TYPE_NULL:
-            return false;
-        case carto::VariantType::VARIANT_TYPE_STRING:
-        case carto::VariantType::VARIANT_TYPE_BOOL:
-        case carto::VariantType::VARIANT_TYPE_INTEGER:
-        case carto::VariantType::VARIANT_TYPE_DOUBLE:
-            return std::regex_match(variant.getString(), re);
-        case carto::VariantType::VARIANT_TYPE_ARRAY:
-            for (int i = 0; i < variant.getArraySize(); i++) {
-                if (matchRegexFilter(variant.getArrayElement(i), re)) {
+    bool matchRegexFilter(const picojson::value& value, const std::regex& re) {
+        if (value.is<std::string>()) {
+            return std::regex_match(value.get<std::string>(), re);
+        } else if (value.is<bool>() || value.is<double>()) {
+            return std::regex_match(value.to_str(), re);
+        } else if (value.is<picojson::array>()) {
+            for (const picojson::value& elementValue : value.get<picojson::array>()) {
+                if (matchRegexFilter(elementValue, re)) {
                     return true;
                 }
             }
-            return false;
-        case carto::VariantType::VARIANT_TYPE_OBJECT:
-            for (const std::string& key : variant.getObjectKeys()) {
-                if (matchRegexFilter(variant.getObjectElement(key), re)) {
+        } else if (value.is<picojson::object>()) {
+            for (const std::pair<const std::string, picojson::value>& keyValue : value.get<picojson::object>()) {
+                if (matchRegexFilter(keyValue.second, re)) {
                     return true;
                 }
             }
-            return false;
         }
         return false;
     }
 
+    const picojson::value& getGeometryType(const std::shared_ptr<carto::Geometry>& geometry) {
+        static const picojson::value pointType("point"), lineType("linestring"), polygonType("polygon");
+        static const picojson::value multiPointType("multipoint"), multiLineType("multilinestring"), multiPolygonType("multipolygon");
+        static const picojson::value multiGeometryType("multigeometry"), geometryType("geometry"), unknownType("unknown");
+        if (std::dynamic_pointer_cast<carto::PointGeometry>(geometry)) {
+            return pointType;
+        } else if (std::dynamic_pointer_cast<carto::LineGeometry>(geometry)) {
+            return lineType;
+        } else if (std::dynamic_pointer_cast<carto::PolygonGeometry>(geometry)) {
+            return polygonType;
+        } else if (std::dynamic_pointer_cast<carto::MultiPointGeometry>(geometry)) {
+            return multiPointType;
+        } else if (std::dynamic_pointer_cast<carto::MultiLineGeometry>(geometry)) {
+            return multiLineType;
+        } else if (std::dynamic_pointer_cast<carto::MultiPolygonGeometry>(geometry)) {
+            return multiPolygonType;
+        } else if (std::dynamic_pointer_cast<carto::MultiGeometry>(geometry)) {
+            return multiGeometryType;
+        } else if (geometry) {
+            return geometryType;
+        }
+        return unknownType;
+    }
+
+    std::size_t getGeometryVerticesCount(const std::shared_ptr<carto::Geometry>& geometry) {
+        if (std::dynamic_pointer_cast<carto::PointGeometry>(geometry)) {
+            return 1;
+        } else if (auto lineGeometry = std::dynamic_pointer_cast<carto::LineGeometry>(geometry)) {
+            return lineGeometry->getPoses().size();
+        } else if (auto polygonGeometry = std::dynamic_pointer_cast<carto::PolygonGeometry>(geometry)) {
+            const std::vector<std::vector<carto::MapPos> >& rings = polygonGeometry->getRings();
+            return std::accumulate(rings.begin(), rings.end(), std::size_t(0), [](std::size_t size, const std::vector<carto::MapPos>& ring) { return size + ring.size(); });
+        } else if (auto multiGeometry = std::dynamic_pointer_cast<carto::MultiGeometry>(geometry)) {
+            std::size_t count = 0;
+            for (int i = 0; i < multiGeometry->getGeometryCount(); i++) {
+                count += getGeometryVerticesCount(multiGeometry->getGeometry(i));
+            }
+            return count;
+        }
+        return 0;
+    }
+
+    std::string collateNoCase(const std::string& str) {
+        return carto::unistring::to_utf8string(carto::unistring::to_upper(carto::unistring::to_unistring(str)));
+    }
+
     class SearchQueryContext : public carto::QueryContext {
     public:
         explicit SearchQueryContext(const std::shared_ptr<carto::Geometry>& geometry, const std::shared_ptr<carto::Projection>& proj, const std::string* layerName, const carto::Variant& var) : _geometry(geometry), _projection(proj), _layerName(layerName), _variant(var) { }
@@ -176,12 +294,12 @@ namespace {
             }
 
             if (name == "geometry::type") {
-                value = carto::Variant(GetGeometryType(_geometry));
+                value = carto::Variant(getGeometryType(_geometry).get<std::string>());
                 return true;
             }
 
             if (name == "geometry::vertices") {
-                value = carto::Variant(static_cast<long long>(GetGeometryVerticesCount(_geometry)));
+                value = carto::Variant(static_cast<long long>(getGeometryVerticesCount(_geometry)));
                 return true;
             }
 
@@ -204,44 +322,6 @@ namespace {
         }
 
     private:
-        static std::string GetGeometryType(const std::shared_ptr<carto::Geometry>& geometry) {
-            if (std::dynamic_pointer_cast<carto::PointGeometry>(geometry)) {
-                return "point";
-            } else if (std::dynamic_pointer_cast<carto::LineGeometry>(geometry)) {
-                return "linestring";
-            } else if (std::dynamic_pointer_cast<carto::PolygonGeometry>(geometry)) {
-                return "polygon";
-            } else if (std::dynamic_pointer_cast<carto::MultiPointGeometry>(geometry)) {
-                return "multipoint";
-            } else if (std::dynamic_pointer_cast<carto::MultiLineGeometry>(geometry)) {
-                return "multilinestring";
-            } else if (std::dynamic_pointer_cast<carto::MultiPolygonGeometry>(geometry)) {
-                return "multipolygon";
-            } else if (std::dynamic_pointer_cast<carto::MultiGeometry>(geometry)) {
-                return "multigeometry";
-            } else if (std::dynamic_pointer_cast<carto::Geometry>(geometry)) {
-                return "geometry";
-            }
-            return "unknown";
-        }
-        
-        static std::size_t GetGeometryVerticesCount(const std::shared_ptr<carto::Geometry>& geometry) {
-            if (std::dynamic_pointer_cast<carto::PointGeometry>(geometry)) {
-                return 1;
-            } else if (auto lineGeometry = std::dynamic_pointer_cast<carto::LineGeometry>(geometry)) {
-                return lineGeometry->getPoses().size();
-            } else if (auto polygonGeometry = std::dynamic_pointer_cast<carto::PolygonGeometry>(geometry)) {
-                return std::accumulate(polygonGeometry->getHoles().begin(), polygonGeometry->getHoles().end(), polygonGeometry->getPoses().size(), [](std::size_t size, const std::vector<carto::MapPos>& ring) { return size + ring.size(); });
-            } else if (auto multiGeometry = std::dynamic_pointer_cast<carto::MultiGeometry>(geometry)) {
-                std::size_t count = 0;
-                for (int i = 0; i < multiGeometry->getGeometryCount(); i++) {
-                    count += GetGeometryVerticesCount(multiGeometry->getGeometry(i));
-                }
-                return count;
-            }
-            return 0;
-        }
-
         const std::shared_ptr<carto::Geometry>& _geometry;
         const std::shared_ptr<carto::Projection>& _projection;
         const std::string* _layerName;
@@ -252,6 +332,12 @@ namespace {
 
 namespace carto {
 
+    struct SearchProxy::ElementContext {
+        const std::shared_ptr<Geometry>& geometry;
+        const std::string* layerName;
+        const picojson::value& properties;
+    };
+
     SearchProxy::SearchProxy(const std::shared_ptr<SearchRequest>& request, const MapBounds& mapBounds, const std::shared_ptr<Projection>& proj) :
         _request(request),
         _geometry(),
@@ -259,7 +345,8 @@ namespace carto {
         _searchRadius(0),
         _projection(proj),
         _expr(),
-        _re()
+        _re(),
+        _compiledExpr()
     {
         if (!request) {
             throw NullArgumentException("Null request");
@@ -284,6 +371,9 @@ namespace carto {
             catch (const std::exception& ex) {
                 throw ParseException(std::string("Failed to parse expression: ") + ex.what(), request->getFilterExpression());
             }
+
+            // Expressions with unsupported nodes are not compiled and are evaluated using the generic query context
+            _compiledExpr = CompileExpression(_expr);
         }
 
         if (request->getGeometry()) {
@@ -309,6 +399,10 @@ namespace carto {
         return _searchBounds;
     }
 
+    const std::shared_ptr<QueryExpression>& SearchProxy::getFilterExpression() const {
+        return _expr;
+    }
+
     bool SearchProxy::testBounds(const MapBounds& bounds) const {
         if (_geometry) {
             std::vector<MapPos> points(4);
@@ -328,12 +422,17 @@ namespace carto {
 
     bool SearchProxy::testElement(const std::shared_ptr<Geometry>& geometry, const std::string* layerName, const Variant& var) const {
         if (_re) {
-            if (!matchRegexFilter(var, *_re)) {
+            if (!matchRegexFilter(var.toPicoJSON(), *_re)) {
                 return false;
             }
         }
 
-        if (_expr) {
+        if (_compiledExpr) {
+            ElementContext context { geometry, layerName, var.toPicoJSON() };
+            if (!_compiledExpr(context)) {
+                return false;
+            }
+        } else if (_expr) {
             SearchQueryContext context(geometry, _projection, layerName, var);
             if (!_expr->evaluate(context)) {
                 return false;
@@ -349,6 +448,168 @@ namespace carto {
         return true;
     }
 
+    SearchProxy::CompiledExpression SearchProxy::CompileExpression(const std::shared_ptr<QueryExpression>& expr) {
+        using namespace queryexpressionimpl;
+
+        if (auto notExpr = std::dynamic_pointer_cast<NotExpression>(expr)) {
+            CompiledExpression compiledExpr = CompileExpression(notExpr->getExpression());
+            if (!compiledExpr) {
+                return CompiledExpression();
+            }
+            return [compiledExpr](const ElementContext& context) { return !compiledExpr(context); };
+        }
+
+        if (auto andExpr = std::dynamic_pointer_cast<AndExpression>(expr)) {
+            CompiledExpression compiledExpr1 = CompileExpression(andExpr->getExpression1());
+            CompiledExpression compiledExpr2 = CompileExpression(andExpr->getExpression2());
+            if (!compiledExpr1 || !compiledExpr2) {
+                return CompiledExpression();
+            }
+            return [compiledExpr1, compiledExpr2](const ElementContext& context) { return compiledExpr1(context) && compiledExpr2(context); };
+        }
+
+        if (auto orExpr = std::dynamic_pointer_cast<OrExpression>(expr)) {
+            CompiledExpression compiledExpr1 = CompileExpression(orExpr->getExpression1());
+            CompiledExpression compiledExpr2 = CompileExpression(orExpr->getExpression2());
+            if (!compiledExpr1 || !compiledExpr2) {
+                return CompiledExpression();
+            }
+            return [compiledExpr1, compiledExpr2](const ElementContext& context) { return compiledExpr1(context) || compiledExpr2(context); };
+        }
+
+        if (auto isNullExpr = std::dynamic_pointer_cast<UnaryPredicateExpression<IsNullPredicate> >(expr)) {
+            CompiledOperand compiledOp = CompileOperand(isNullExpr->getOperand());
+            if (!compiledOp) {
+                return CompiledExpression();
+            }
+            return [compiledOp](const ElementContext& context) { picojson::value temp; return IsNullPredicate()(*compiledOp(context, temp)); };
+        }
+
+        if (auto isNotNullExpr = std::dynamic_pointer_cast<UnaryPredicateExpression<IsNotNullPredicate> >(expr)) {
+            CompiledOperand compiledOp = CompileOperand(isNotNullExpr->getOperand());
+            if (!compiledOp) {
+                return CompiledExpression();
+            }
+            return [compiledOp](const ElementContext& context) { picojson::value temp; return IsNotNullPredicate()(*compiledOp(context, temp)); };
+        }
+
+        CompiledExpression compiledExpr;
+        if (CompileBinaryPredicate<EqPredicate>(expr, compiledExpr) || CompileBinaryPredicate<NeqPredicate>(expr, compiledExpr) ||
+            CompileBinaryPredicate<LtPredicate>(expr, compiledExpr) || CompileBinaryPredicate<LtePredicate>(expr, compiledExpr) ||
+            CompileBinaryPredicate<GtPredicate>(expr, compiledExpr) || CompileBinaryPredicate<GtePredicate>(expr, compiledExpr) ||
+            CompileRegexpLikePredicate<false>(expr, compiledExpr) || CompileRegexpLikePredicate<true>(expr, compiledExpr))
+        {
+            return compiledExpr;
+        }
+        return CompiledExpression();
+    }
+
+    SearchProxy::CompiledOperand SearchProxy::CompileOperand(const std::shared_ptr<queryexpressionimpl::Operand>& op) {
+        using namespace queryexpressionimpl;
+
+        if (auto constOp = std::dynamic_pointer_cast<ConstOperand>(op)) {
+            picojson::value value = constOp->getValue().toPicoJSON();
+            return [value](const ElementContext& context, picojson::value& temp) { return &value; };
+        }
+
+        auto varOp = std::dynamic_pointer_cast<VariableOperand>(op);
+        if (!varOp) {
+            return CompiledOperand();
+        }
+
+        // Resolve the variable kind once, property values are referenced without copying
+        CompiledOperand compiledOp;
+        std::string name = varOp->getName();
+        if (name == "layer::name") {
+            compiledOp = [](const ElementContext& context, picojson::value& temp) {
+                temp = (context.layerName ? picojson::value(*context.layerName) : picojson::value());
+                return &temp;
+            };
+        } else if (name == "geometry::type") {
+            compiledOp = [](const ElementContext& context, picojson::value& temp) {
+                return &getGeometryType(context.geometry);
+            };
+        } else if (name == "geometry::vertices") {
+            compiledOp = [](const ElementContext& context, picojson::value& temp) {
+                temp = picojson::value(static_cast<std::int64_t>(getGeometryVerticesCount(context.geometry)));
+                return &temp;
+            };
+        } else {
+            compiledOp = [name](const ElementContext& context, picojson::value& temp) -> const picojson::value* {
+                if (context.properties.is<picojson::object>()) {
+                    const picojson::object& properties = context.properties.get<picojson::object>();
+                    auto it = properties.find(name);
+                    if (it != properties.end()) {
+                        return &it->second;
+                    }
+                } else if (!context.properties.is<picojson::array>() && name == "value") {
+                    return &context.properties;
+                }
+                return &temp;
+            };
+        }
+
+        if (varOp->isNoCase()) {
+            return [compiledOp](const ElementContext& context, picojson::value& temp) {
+                const picojson::value* value = compiledOp(context, temp);
+                if (value->is<std::string>()) {
+                    temp = picojson::value(collateNoCase(value->get<std::string>()));
+                    return static_cast<const picojson::value*>(&temp);
+                }
+                return value;
+            };
+        }
+        return compiledOp;
+    }
+
+    template <typename Pred>
+    bool SearchProxy::CompileBinaryPredicate(const std::shared_ptr<QueryExpression>& expr, CompiledExpression& compiledExpr) {
+        auto predExpr = std::dynamic_pointer_cast<queryexpressionimpl::BinaryPredicateExpression<Pred> >(expr);
+        if (!predExpr) {
+            return false;
+        }
+
+        CompiledOperand compiledOp1 = CompileOperand(predExpr->getOperand1());
+        CompiledOperand compiledOp2 = CompileOperand(predExpr->getOperand2());
+        if (compiledOp1 && compiledOp2) {
+            compiledExpr = [compiledOp1, compiledOp2](const ElementContext& context) {
+                picojson::value temp1, temp2;
+                return Pred()(*compiledOp1(context, temp1), *compiledOp2(context, temp2));
+            };
+        }
+        return true;
+    }
+
+    template <bool CaseInsensitive>
+    bool SearchProxy::CompileRegexpLikePredicate(const std::shared_ptr<QueryExpression>& expr, CompiledExpression& compiledExpr) {
+        using Pred = queryexpressionimpl::RegexpLikePredicate<CaseInsensitive>;
+
+        auto predExpr = std::dynamic_pointer_cast<queryexpressionimpl::BinaryPredicateExpression<Pred> >(expr);
+        if (!predExpr) {
+            return false;
+        }
+
+        // Constant patterns are compiled only once. Invalid patterns are left for the generic evaluator to report.
+        auto constOp = std::dynamic_pointer_cast<queryexpressionimpl::ConstOperand>(predExpr->getOperand2());
+        if (!constOp || !queryexpressionimpl::IsScalarValue(constOp->getValue().toPicoJSON())) {
+            return CompileBinaryPredicate<Pred>(expr, compiledExpr);
+        }
+
+        CompiledOperand compiledOp = CompileOperand(predExpr->getOperand1());
+        if (compiledOp) {
+            try {
+                auto re = std::make_shared<std::wregex>(Pred::CreateRegex(constOp->getValue().getString()));
+                compiledExpr = [compiledOp, re](const ElementContext& context) {
+                    picojson::value temp;
+                    return Pred()(*compiledOp(context, temp), *re);
+                };
+            }
+            catch (const std::regex_error&) {
+            }
+        }
+        return true;
+    }
+
 }
 
 #endif
@@ -12,24 +12,36 @@
 #include "core/MapBounds.h"
 #include "search/SearchRequest.h"
 
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 #include <regex>
 
 #include <boost/optional.hpp>
 
+namespace picojson {
+    class value;
+}
+
 namespace carto {
     class Geometry;
     class Projection;
     class QueryExpression;
     class Variant;
 
+    namespace queryexpressionimpl {
+        struct Operand;
+    }
+
     class SearchProxy {
     public:
         SearchProxy(const std::shared_ptr<SearchRequest>& request, const MapBounds& mapBounds, const std::shared_ptr<Projection>& proj);
 
         const MapBounds& getSearchBounds() const;
 
+        const std::shared_ptr<QueryExpression>& getFilterExpression() const;
+
         bool testBounds(const MapBounds& bounds) const;
 
         bool testElement(const std::shared_ptr<Geometry>& geometry, const std::string* layerName, const Variant& var) const;
@@ -42,6 +54,22 @@ namespace carto {
         std::shared_ptr<Projection> _projection;
         std::shared_ptr<QueryExpression> _expr;
         boost::optional<std::regex> _re;
+
+    private:
+        struct ElementContext;
+
+        typedef std::function<bool(const ElementContext&)> CompiledExpression;
+        typedef std::function<const picojson::value*(const ElementContext&, picojson::value&)> CompiledOperand;
+
+        static CompiledExpression CompileExpression(const std::shared_ptr<QueryExpression>& expr);
+        static CompiledOperand CompileOperand(const std::shared_ptr<queryexpressionimpl::Operand>& op);
+
+        template <typename Pred>
+        static bool CompileBinaryPredicate(const std::shared_ptr<QueryExpression>& expr, CompiledExpression& compiledExpr);
+        template <bool CaseInsensitive>
+        static bool CompileRegexpLikePredicate(const std::shared_ptr<QueryExpression>& expr, CompiledExpression& compiledExpr);
+
+        CompiledExpression _compiledExpr;
     };
     
 }
@@ -1,6 +1,8 @@
 #ifdef _CARTO_SEARCH_SUPPORT
 
 #include "VectorTileSearchService.h"
+#include "components/CancelableTask.h"
+#include "components/CancelableThreadPool.h"
 #include "components/Exceptions.h"
 #include "datasources/TileDataSource.h"
 #include "geometry/Geometry.h"
@@ -12,16 +14,76 @@
 #include "utils/TileUtils.h"
 #include "utils/Log.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+
 #include <vt/TileId.h>
 
 namespace carto {
 
+    class VectorTileSearchService::SearchTask : public CancelableTask {
+    public:
+        explicit SearchTask(const std::function<void()>& worker) :
+            CancelableTask(),
+            _worker(worker),
+            _started(false),
+            _finished(false),
+            _condition()
+        {
+        }
+
+        void wait() {
+            // If the pool has not started the task yet, cancel it instead of waiting, the calling thread has already processed all the tiles
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (!_started) {
+                _canceled = true;
+                return;
+            }
+            _condition.wait(lock, [this]() { return _finished; });
+        }
+
+    protected:
+        virtual void run() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (_canceled) {
+                    return;
+                }
+                _started = true;
+            }
+
+            _worker();
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _finished = true;
+            }
+            _condition.notify_all();
+        }
+
+    private:
+        std::function<void()> _worker;
+        bool _started;
+        bool _finished;
+        std::condition_variable _condition;
+    };
+
     VectorTileSearchService::VectorTileSearchService(const std::shared_ptr<TileDataSource>& dataSource, const std::shared_ptr<VectorTileDecoder>& tileDecoder) :
         _dataSource(dataSource),
         _tileDecoder(tileDecoder),
+        _dataSourceListener(),
         _minZoom(0),
         _maxZoom(0),
         _maxResults(1000),
+        _threadCount(1),
+        _searchThreadPool(std::make_shared<CancelableThreadPool>()),
+        _tileCache(),
+        _tileCacheMap(),
+        _tileCacheSize(DEFAULT_TILE_CACHE_SIZE),
+        _tileCacheMutex(),
         _mutex()
     {
         if (!dataSource) {
@@ -33,9 +95,17 @@ namespace carto {
 
         _minZoom = _dataSource->getMinZoom();
         _maxZoom = _dataSource->getMaxZoom();
+
+        _searchThreadPool->setPoolSize(1);
+
+        _dataSourceListener = std::make_shared<DataSourceListener>(*this);
+        _dataSource->registerOnChangeListener(_dataSourceListener);
     }
 
     VectorTileSearchService::~VectorTileSearchService() {
+        _dataSource->unregisterOnChangeListener(_dataSourceListener);
+
+        _searchThreadPool->deinit();
     }
 
     const std::shared_ptr<TileDataSource>& VectorTileSearchService::getDataSource() const {
@@ -76,6 +146,32 @@ namespace carto {
         _maxResults = maxResults;
     }
 
+    int VectorTileSearchService::getThreadCount() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _threadCount;
+    }
+
+    void VectorTileSearchService::setThreadCount(int threadCount) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _threadCount = std::max(1, threadCount);
+        // The calling thread is one of the workers
+        _searchThreadPool->setPoolSize(std::max(1, _threadCount - 1));
+    }
+
+    int VectorTileSearchService::getTileCacheSize() const {
+        std::lock_guard<std::mutex> lock(_tileCacheMutex);
+        return static_cast<int>(_tileCacheSize);
+    }
+
+    void VectorTileSearchService::setTileCacheSize(int tileCacheSize) {
+        std::lock_guard<std::mutex> lock(_tileCacheMutex);
+        _tileCacheSize = static_cast<std::size_t>(std::max(0, tileCacheSize));
+        while (_tileCache.size() > _tileCacheSize) {
+            _tileCacheMap.erase(_tileCache.back().first);
+            _tileCache.pop_back();
+        }
+    }
+
     std::shared_ptr<VectorTileFeatureCollection> VectorTileSearchService::findFeatures(const std::shared_ptr<SearchRequest>& request) const {
         if (!request) {
             throw NullArgumentException("Null request");
@@ -93,46 +189,158 @@ namespace carto {
             maxResults = _maxResults;
         }
 
+        int threadCount = 1;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            threadCount = _threadCount;
+        }
+
+        // Descend the tile quadtree level by level, subtrees not intersecting the search area are skipped.
+        // Tiles of each level are kept in row-major order, so that the results are ordered as in a full tile range scan.
         std::vector<std::shared_ptr<VectorTileFeature> > features;
+        std::vector<MapTile> mapTiles { MapTile(0, 0, 0, 0) };
+        for (int zoom = 0; zoom <= maxZoom && !mapTiles.empty(); zoom++) {
+            std::vector<std::pair<MapTile, MapBounds> > tiles;
+            for (const MapTile& mapTile : mapTiles) {
+                MapBounds tileBounds = TileUtils::CalculateMapTileBounds(mapTile, _dataSource->getProjection());
+                if (tileBounds.intersects(searchBounds) && proxy.testBounds(tileBounds)) {
+                    tiles.emplace_back(mapTile, tileBounds);
+                }
+            }
 
-        auto testTile = [&](const MapTile& mapTile, const MapBounds& tileBounds) {
-            if (std::shared_ptr<TileData> tileData = _dataSource->loadTile(mapTile.getFlipped())) {
-                if (std::shared_ptr<VectorTileFeatureCollection> featureCollection = _tileDecoder->decodeFeatures(vt::TileId(mapTile.getZoom(), mapTile.getX(), mapTile.getY()), tileData->getData(), tileBounds)) {
-                    for (int i = 0; i < featureCollection->getFeatureCount(); i++) {
-                        if (static_cast<int>(features.size()) >= maxResults) {
-                            break;
-                        }
+            if (zoom >= minZoom) {
+                searchTiles(tiles, proxy, maxResults, threadCount, features);
+                if (static_cast<int>(features.size()) >= maxResults) {
+                    break;
+                }
+            }
+
+            mapTiles.clear();
+            for (const std::pair<MapTile, MapBounds>& tile : tiles) {
+                for (int i = 0; i < 4; i++) {
+                    mapTiles.emplace_back(tile.first.getX() * 2 + (i & 1), tile.first.getY() * 2 + (i >> 1), zoom + 1, 0);
+                }
+            }
+            std::sort(mapTiles.begin(), mapTiles.end(), [](const MapTile& mapTile1, const MapTile& mapTile2) {
+                return mapTile1.getY() < mapTile2.getY() || (mapTile1.getY() == mapTile2.getY() && mapTile1.getX() < mapTile2.getX());
+            });
+        }
+        return std::make_shared<VectorTileFeatureCollection>(features);
+    }
+
+    void VectorTileSearchService::searchTiles(const std::vector<std::pair<MapTile, MapBounds> >& tiles, const SearchProxy& proxy, int maxResults, int threadCount, std::vector<std::shared_ptr<VectorTileFeature> >& features) const {
+        // Results are collected per tile and merged in the tile order once all workers have finished
+        std::vector<std::vector<std::shared_ptr<VectorTileFeature> > > tileFeatures(tiles.size());
+        std::atomic<std::size_t> nextTileIndex(0);
+        std::atomic<int> resultCount(static_cast<int>(features.size()));
+
+        std::atomic<bool> failed(false);
+        std::exception_ptr exception;
+        std::mutex exceptionMutex;
+
+        auto worker = [&]() {
+            try {
+                while (resultCount.load() < maxResults && !failed.load()) {
+                    std::size_t tileIndex = nextTileIndex.fetch_add(1);
+                    if (tileIndex >= tiles.size()) {
+                        break;
+                    }
 
-                        const std::shared_ptr<VectorTileFeature>& feature = featureCollection->getFeature(i);
+                    const MapTile& mapTile = tiles[tileIndex].first;
+                    if (std::shared_ptr<VectorTileFeatureCollection> featureCollection = loadFeatures(mapTile, tiles[tileIndex].second)) {
+                        for (int i = 0; i < featureCollection->getFeatureCount(); i++) {
+                            if (resultCount.load() >= maxResults) {
+                                break;
+                            }
 
-                        if (proxy.testElement(feature->getGeometry(), &feature->getLayerName(), feature->getProperties())) {
-                            features.push_back(feature);
+                            const std::shared_ptr<VectorTileFeature>& feature = featureCollection->getFeature(i);
+
+                            if (proxy.testElement(feature->getGeometry(), &feature->getLayerName(), feature->getProperties())) {
+                                tileFeatures[tileIndex].push_back(feature);
+                                resultCount++;
+                            }
                         }
                     }
                 }
-            }        
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!exception) {
+                    exception = std::current_exception();
+                }
+                failed = true;
+            }
         };
 
-        for (int zoom = minZoom; zoom <= maxZoom; zoom++) {
-            MapTile mapTile1 = TileUtils::CalculateMapTile(searchBounds.getMin(), zoom, _dataSource->getProjection());
-            MapTile mapTile2 = TileUtils::CalculateMapTile(searchBounds.getMax(), zoom, _dataSource->getProjection());
-            for (int y = std::min(mapTile1.getY(), mapTile2.getY()); y <= std::max(mapTile1.getY(), mapTile2.getY()); y++) {
-                for (int x = std::min(mapTile1.getX(), mapTile2.getX()); x <= std::max(mapTile1.getX(), mapTile2.getX()); x++) {
-                    if (static_cast<int>(features.size()) >= maxResults) {
-                        break;
-                    }
+        // Additional workers are run in the thread pool, the calling thread processes tiles until all are taken
+        std::size_t workerCount = std::min(static_cast<std::size_t>(threadCount), tiles.size());
+        std::vector<std::shared_ptr<SearchTask> > tasks;
+        for (std::size_t i = 1; i < workerCount; i++) {
+            auto task = std::make_shared<SearchTask>(worker);
+            tasks.push_back(task);
+            _searchThreadPool->execute(task, 0);
+        }
+        worker();
+        for (const std::shared_ptr<SearchTask>& task : tasks) {
+            task->wait();
+        }
 
-                    MapTile mapTile(x, y, zoom, 0);
-                    MapBounds tileBounds = TileUtils::CalculateMapTileBounds(mapTile, _dataSource->getProjection());
-                    if (proxy.testBounds(tileBounds)) {
-                        testTile(mapTile, tileBounds);
-                    }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+
+        for (const std::vector<std::shared_ptr<VectorTileFeature> >& results : tileFeatures) {
+            for (const std::shared_ptr<VectorTileFeature>& feature : results) {
+                if (static_cast<int>(features.size()) >= maxResults) {
+                    return;
                 }
+                features.push_back(feature);
             }
         }
-        return std::make_shared<VectorTileFeatureCollection>(features);
     }
 
+    std::shared_ptr<VectorTileFeatureCollection> VectorTileSearchService::loadFeatures(const MapTile& mapTile, const MapBounds& tileBounds) const {
+        {
+            std::lock_guard<std::mutex> lock(_tileCacheMutex);
+            auto it = _tileCacheMap.find(mapTile.getTileId());
+            if (it != _tileCacheMap.end()) {
+                _tileCache.splice(_tileCache.begin(), _tileCache, it->second);
+                return it->second->second;
+            }
+        }
+
+        std::shared_ptr<VectorTileFeatureCollection> featureCollection;
+        if (std::shared_ptr<TileData> tileData = _dataSource->loadTile(mapTile.getFlipped())) {
+            featureCollection = _tileDecoder->decodeFeatures(vt::TileId(mapTile.getZoom(), mapTile.getX(), mapTile.getY()), tileData->getData(), tileBounds);
+        }
+
+        if (featureCollection) {
+            std::lock_guard<std::mutex> lock(_tileCacheMutex);
+            if (_tileCacheSize > 0 && _tileCacheMap.find(mapTile.getTileId()) == _tileCacheMap.end()) {
+                _tileCache.emplace_front(mapTile.getTileId(), featureCollection);
+                _tileCacheMap[mapTile.getTileId()] = _tileCache.begin();
+                while (_tileCache.size() > _tileCacheSize) {
+                    _tileCacheMap.erase(_tileCache.back().first);
+                    _tileCache.pop_back();
+                }
+            }
+        }
+        return featureCollection;
+    }
+
+    VectorTileSearchService::DataSourceListener::DataSourceListener(VectorTileSearchService& searchService) :
+        _searchService(searchService)
+    {
+    }
+
+    void VectorTileSearchService::DataSourceListener::onTilesChanged(bool removeTiles) {
+        std::lock_guard<std::mutex> lock(_searchService._tileCacheMutex);
+        _searchService._tileCache.clear();
+        _searchService._tileCacheMap.clear();
+    }
+
+    const int VectorTileSearchService::DEFAULT_TILE_CACHE_SIZE = 16;
+
 }
 
 #endif
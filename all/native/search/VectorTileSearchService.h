@@ -9,16 +9,24 @@
 
 #ifdef _CARTO_SEARCH_SUPPORT
 
+#include "core/MapBounds.h"
+#include "core/MapTile.h"
+#include "datasources/TileDataSource.h"
 #include "search/SearchRequest.h"
 
+#include <list>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace carto {
+    class CancelableThreadPool;
     class Projection;
-    class TileDataSource;
+    class SearchProxy;
     class VectorTileDecoder;
+    class VectorTileFeature;
     class VectorTileFeatureCollection;
 
     /**
@@ -82,6 +90,33 @@ namespace carto {
          */
         void setMaxResults(int maxResults);
 
+        /**
+         * Returns the number of threads used for loading and searching tiles.
+         * @return The number of threads used for searching.
+         */
+        int getThreadCount() const;
+        /**
+         * Sets the number of threads used for loading and searching tiles.
+         * The default is 1, in which case tiles are searched on the calling thread.
+         * Otherwise the calling thread is assisted by the worker threads of the service.
+         * Note: if more than one thread is used and the maximum number of results is reached,
+         * the returned features may be a different subset of all the matching features than in the single threaded case.
+         * @param threadCount The new number of threads to use.
+         */
+        void setThreadCount(int threadCount);
+
+        /**
+         * Returns the maximum number of decoded tiles cached between the queries.
+         * @return The maximum number of decoded tiles cached.
+         */
+        int getTileCacheSize() const;
+        /**
+         * Sets the maximum number of decoded tiles cached between the queries.
+         * The default is 16. The cache is cleared when the tiles of the data source change.
+         * @param tileCacheSize The new maximum number of cached tiles. If zero, tiles are not cached.
+         */
+        void setTileCacheSize(int tileCacheSize);
+
         /**
          * Searches for the features specified by search request from the vector tiles bound to the service.
          * The zoom level range used for searching is specified using minZoom/maxZoom attributes of the search service.
@@ -91,12 +126,39 @@ namespace carto {
         virtual std::shared_ptr<VectorTileFeatureCollection> findFeatures(const std::shared_ptr<SearchRequest>& request) const;
 
     protected:
+        class DataSourceListener : public TileDataSource::OnChangeListener {
+        public:
+            explicit DataSourceListener(VectorTileSearchService& searchService);
+
+            virtual void onTilesChanged(bool removeTiles);
+
+        private:
+            VectorTileSearchService& _searchService;
+        };
+
+        class SearchTask;
+
+        void searchTiles(const std::vector<std::pair<MapTile, MapBounds> >& tiles, const SearchProxy& proxy, int maxResults, int threadCount, std::vector<std::shared_ptr<VectorTileFeature> >& features) const;
+
+        std::shared_ptr<VectorTileFeatureCollection> loadFeatures(const MapTile& mapTile, const MapBounds& tileBounds) const;
+
+        static const int DEFAULT_TILE_CACHE_SIZE;
+
         const std::shared_ptr<TileDataSource> _dataSource;
         const std::shared_ptr<VectorTileDecoder> _tileDecoder;
+        std::shared_ptr<DataSourceListener> _dataSourceListener;
 
         int _minZoom;
         int _maxZoom;
         int _maxResults;
+        int _threadCount;
+
+        std::shared_ptr<CancelableThreadPool> _searchThreadPool;
+
+        mutable std::list<std::pair<long long, std::shared_ptr<VectorTileFeatureCollection> > > _tileCache; // most recently used first
+        mutable std::unordered_map<long long, std::list<std::pair<long long, std::shared_ptr<VectorTileFeatureCollection> > >::iterator> _tileCacheMap;
+        std::size_t _tileCacheSize;
+        mutable std::mutex _tileCacheMutex;
 
         mutable std::mutex _mutex;
     };
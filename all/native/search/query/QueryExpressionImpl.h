@@ -26,90 +26,78 @@ namespace carto {
 
         using Context = QueryContext;
 
+        inline bool IsScalarValue(const picojson::value& val) {
+            return val.is<std::string>() || val.is<bool>() || val.is<double>();
+        }
+
         struct IsNullPredicate {
-            bool operator() (const Value& val) const { return val.getType() == VariantType::VARIANT_TYPE_NULL; }
+            bool operator() (const Value& val) const { return (*this)(val.toPicoJSON()); }
+            bool operator() (const picojson::value& val) const { return val.is<picojson::null>(); }
         };
 
         struct IsNotNullPredicate {
-            bool operator() (const Value& val) const { return val.getType() != VariantType::VARIANT_TYPE_NULL; }
+            bool operator() (const Value& val) const { return (*this)(val.toPicoJSON()); }
+            bool operator() (const picojson::value& val) const { return !val.is<picojson::null>(); }
         };
 
         template <bool CaseInsensitive>
         struct RegexpLikePredicate {
             bool operator() (const Value& val1, const Value& val2) const {
-                switch (val1.getType()) {
-                case VariantType::VARIANT_TYPE_NULL:
-                case VariantType::VARIANT_TYPE_ARRAY:
-                case VariantType::VARIANT_TYPE_OBJECT:
+                return (*this)(val1.toPicoJSON(), val2.toPicoJSON());
+            }
+
+            bool operator() (const picojson::value& val1, const picojson::value& val2) const {
+                if (!IsScalarValue(val1) || !IsScalarValue(val2)) {
                     return false;
-                default:
-                    break;
-                }
-                std::string str = val1.getString();
-                unistring::unistring unistr = unistring::to_unistring(str);
-                if (CaseInsensitive) {
-                    unistr = unistring::to_normalized(unistring::to_upper(unistr));
                 }
+                return (*this)(val1, CreateRegex(val2.to_str()));
+            }
 
-                switch (val2.getType()) {
-                case VariantType::VARIANT_TYPE_NULL:
-                case VariantType::VARIANT_TYPE_ARRAY:
-                case VariantType::VARIANT_TYPE_OBJECT:
+            bool operator() (const picojson::value& val1, const std::wregex& re) const {
+                if (!IsScalarValue(val1)) {
                     return false;
-                default:
-                    break;
                 }
-                std::string re = val2.getString();
-                unistring::unistring unire = unistring::to_unistring(re);
+                return std::regex_match(NormalizeString(val1.to_str()), re);
+            }
+
+            static std::wregex CreateRegex(const std::string& re) {
+                return std::wregex(NormalizeString(re));
+            }
+
+        private:
+            static std::wstring NormalizeString(const std::string& str) {
+                unistring::unistring unistr = unistring::to_unistring(str);
                 if (CaseInsensitive) {
-                    unire = unistring::to_normalized(unistring::to_upper(unire));
+                    unistr = unistring::to_normalized(unistring::to_upper(unistr));
                 }
-
-                return std::regex_match(unistring::to_wstring(unistr), std::wregex(unistring::to_wstring(unire)));
+                return unistring::to_wstring(unistr);
             }
         };
 
         struct EqPredicate {
-            bool operator() (const Value& val1, const Value& val2) const {
-                if (val1.getType() == VariantType::VARIANT_TYPE_NULL || val2.getType() == VariantType::VARIANT_TYPE_NULL) {
+            bool operator() (const Value& val1, const Value& val2) const { return (*this)(val1.toPicoJSON(), val2.toPicoJSON()); }
+            bool operator() (const picojson::value& val1, const picojson::value& val2) const {
+                if (val1.is<picojson::null>() || val2.is<picojson::null>()) {
                     return false;
                 }
-                return val1.toPicoJSON() == val2.toPicoJSON();
+                return val1 == val2;
             }
         };
 
         struct NeqPredicate {
-            bool operator() (const Value& val1, const Value& val2) const {
-                if (val1.getType() == VariantType::VARIANT_TYPE_NULL || val2.getType() == VariantType::VARIANT_TYPE_NULL) {
+            bool operator() (const Value& val1, const Value& val2) const { return (*this)(val1.toPicoJSON(), val2.toPicoJSON()); }
+            bool operator() (const picojson::value& val1, const picojson::value& val2) const {
+                if (val1.is<picojson::null>() || val2.is<picojson::null>()) {
                     return false;
                 }
-                return val1.toPicoJSON() != val2.toPicoJSON();
+                return val1 != val2;
             }
         };
 
         template <template <typename T> class Op>
         struct ComparisonPredicate {
-            bool operator() (const Value& val1, const Value& val2) const {
-                switch (val1.getType()) {
-                case VariantType::VARIANT_TYPE_NULL:
-                case VariantType::VARIANT_TYPE_ARRAY:
-                case VariantType::VARIANT_TYPE_OBJECT:
-                    return false;
-                default:
-                    break;
-                }
-
-                switch (val2.getType()) {
-                case VariantType::VARIANT_TYPE_NULL:
-                case VariantType::VARIANT_TYPE_ARRAY:
-                case VariantType::VARIANT_TYPE_OBJECT:
-                    return false;
-                default:
-                    break;
-                }
-
-                const picojson::value& v1 = val1.toPicoJSON();
-                const picojson::value& v2 = val2.toPicoJSON();
+            bool operator() (const Value& val1, const Value& val2) const { return (*this)(val1.toPicoJSON(), val2.toPicoJSON()); }
+            bool operator() (const picojson::value& v1, const picojson::value& v2) const {
                 if (v1.is<bool>() && v2.is<bool>()) {
                     return Op<bool>()(v1.get<bool>(), v2.get<bool>());
                 }
@@ -120,28 +108,26 @@ namespace carto {
                     return Op<double>()(v1.get<double>(), v2.get<double>());
                 }
                 if (v1.is<std::string>() && v2.is<std::string>()) {
-                    std::string str1 = v1.get<std::string>();
-                    unistring::unistring unistr1 = unistring::to_unistring(str1);
-                    std::string str2 = v2.get<std::string>();
-                    unistring::unistring unistr2 = unistring::to_unistring(str2);
-                    return Op<unistring::unistring>()(unistr1, unistr2);
+                    // NOTE: byte order of UTF-8 strings is the same as the order of their code points
+                    return Op<std::string>()(v1.get<std::string>(), v2.get<std::string>());
                 }
                 return false;
             }
         };
 
-
         using GtPredicate = ComparisonPredicate<std::greater>;
         using LtPredicate = ComparisonPredicate<std::less>;
 
         struct GtePredicate {
-            bool operator() (const Value& val1, const Value& val2) const {
+            bool operator() (const Value& val1, const Value& val2) const { return (*this)(val1.toPicoJSON(), val2.toPicoJSON()); }
+            bool operator() (const picojson::value& val1, const picojson::value& val2) const {
                 return EqPredicate()(val1, val2) || GtPredicate()(val1, val2);
             }
         };
 
         struct LtePredicate {
-            bool operator() (const Value& val1, const Value& val2) const {
+            bool operator() (const Value& val1, const Value& val2) const { return (*this)(val1.toPicoJSON(), val2.toPicoJSON()); }
+            bool operator() (const picojson::value& val1, const picojson::value& val2) const {
                 return EqPredicate()(val1, val2) || LtPredicate()(val1, val2);
             }
         };
@@ -154,6 +140,7 @@ namespace carto {
         struct ConstOperand : public Operand {
             explicit ConstOperand(const Value& value) : _value(value) { }
             virtual Value evaluate(const Context& context) const { return _value; }
+            const Value& getValue() const { return _value; }
             static std::shared_ptr<ConstOperand> create(const Value& value) { return std::make_shared<ConstOperand>(value); }
         private:
             Value _value;
@@ -173,6 +160,9 @@ namespace carto {
                 return value;
             }
 
+            const std::string& getName() const { return _name; }
+            bool isNoCase() const { return _nocase; }
+
             static std::shared_ptr<VariableOperand> create(const std::string& name) { return std::make_shared<VariableOperand>(name, false); }
             static std::shared_ptr<VariableOperand> createEx(const std::string& name, const std::string& collateSeq) { return std::make_shared<VariableOperand>(name, CollateNoCase(collateSeq) == CollateNoCase("nocase")); }
 
@@ -189,6 +179,7 @@ namespace carto {
         struct NotExpression : public Expression {
             explicit NotExpression(const std::shared_ptr<Expression>& expr) : _expr(expr) { }
             virtual bool evaluate(const Context& context) const { return !_expr->evaluate(context); }
+            const std::shared_ptr<Expression>& getExpression() const { return _expr; }
             static std::shared_ptr<NotExpression> create(const std::shared_ptr<Expression>& expr) { return std::make_shared<NotExpression>(expr); }
         private:
             std::shared_ptr<Expression> _expr;
@@ -197,6 +188,8 @@ namespace carto {
         struct OrExpression : public Expression {
             OrExpression(const std::shared_ptr<Expression>& expr1, const std::shared_ptr<Expression>& expr2) : _expr1(expr1), _expr2(expr2) { }
             virtual bool evaluate(const Context& context) const { return _expr1->evaluate(context) || _expr2->evaluate(context); }
+            const std::shared_ptr<Expression>& getExpression1() const { return _expr1; }
+            const std::shared_ptr<Expression>& getExpression2() const { return _expr2; }
             static std::shared_ptr<OrExpression> create(const std::shared_ptr<Expression>& expr1, const std::shared_ptr<Expression>& expr2) { return std::make_shared<OrExpression>(expr1, expr2); }
         private:
             std::shared_ptr<Expression> _expr1, _expr2;
@@ -205,6 +198,8 @@ namespace carto {
         struct AndExpression : public Expression {
             AndExpression(const std::shared_ptr<Expression>& expr1, const std::shared_ptr<Expression>& expr2) : _expr1(expr1), _expr2(expr2) { }
             virtual bool evaluate(const Context& context) const { return _expr1->evaluate(context) && _expr2->evaluate(context); }
+            const std::shared_ptr<Expression>& getExpression1() const { return _expr1; }
+            const std::shared_ptr<Expression>& getExpression2() const { return _expr2; }
             static std::shared_ptr<AndExpression> create(const std::shared_ptr<Expression>& expr1, const std::shared_ptr<Expression>& expr2) { return std::make_shared<AndExpression>(expr1, expr2); }
         private:
             std::shared_ptr<Expression> _expr1, _expr2;
@@ -214,6 +209,7 @@ namespace carto {
         struct UnaryPredicateExpression : public Expression {
             UnaryPredicateExpression(const std::shared_ptr<Pred>& pred, const std::shared_ptr<Operand>& op) : _pred(pred), _op(op) { }
             virtual bool evaluate(const Context& context) const { return (*_pred)(_op->evaluate(context)); }
+            const std::shared_ptr<Operand>& getOperand() const { return _op; }
             static std::shared_ptr<UnaryPredicateExpression> create(const std::shared_ptr<Operand>& op) { return std::make_shared<UnaryPredicateExpression>(std::make_shared<Pred>(), op); }
         private:
             std::shared_ptr<Pred> _pred;
@@ -224,6 +220,8 @@ namespace carto {
         struct BinaryPredicateExpression : public Expression {
             BinaryPredicateExpression(const std::shared_ptr<Pred>& pred, const std::shared_ptr<Operand>& op1, const std::shared_ptr<Operand>& op2) : _pred(pred), _op1(op1), _op2(op2) { }
             virtual bool evaluate(const Context& context) const { return (*_pred)(_op1->evaluate(context), _op2->evaluate(context)); }
+            const std::shared_ptr<Operand>& getOperand1() const { return _op1; }
+            const std::shared_ptr<Operand>& getOperand2() const { return _op2; }
             static std::shared_ptr<BinaryPredicateExpression> create(const std::shared_ptr<Operand>& op1, const std::shared_ptr<Operand>& op2) { return std::make_shared<BinaryPredicateExpression>(std::make_shared<Pred>(), op1, op2); }
         private:
             std::shared_ptr<Pred> _pred;
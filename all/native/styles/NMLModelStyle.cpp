@@ -14,8 +14,7 @@ namespace carto {
             throw NullArgumentException("Null modelAsset");
         }
 
-        std::shared_ptr<std::vector<unsigned char> > data = modelAsset->getDataPtr();
-        protobuf::message modelMsg(data->data(), data->size());
+        protobuf::message modelMsg(modelAsset->data(), modelAsset->size());
         _sourceModel = std::make_shared<nml::Model>(modelMsg);
     }
     
@@ -37,7 +37,7 @@ namespace carto {
     std::shared_ptr<BinaryData> NMLModelStyleBuilder::GetDefaultModelAsset() {
         std::lock_guard<std::mutex> lock(_DefaultNMLModelMutex);
         if (!_DefaultNMLModel) {
-            _DefaultNMLModel = std::make_shared<BinaryData>(default_nmlmodel_nml, default_nmlmodel_nml_len);
+            _DefaultNMLModel = std::make_shared<BinaryData>(default_nmlmodel_nml, default_nmlmodel_nml_len, std::shared_ptr<const void>()); // NOTE: static data, no need to copy
         }
         return _DefaultNMLModel;
     }
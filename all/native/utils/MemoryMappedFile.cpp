@@ -0,0 +1,110 @@
+#include "MemoryMappedFile.h"
+#include "components/Exceptions.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+
+#include <codecvt>
+#include <locale>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace carto {
+
+    MemoryMappedFile::MemoryMappedFile(const std::string& path) :
+        _path(path),
+        _data(nullptr),
+        _size(0),
+        _fileHandle(nullptr),
+        _mappingHandle(nullptr)
+    {
+#if defined(_WIN32)
+        std::wstring widePath = std::wstring_convert<std::codecvt_utf8<wchar_t> >().from_bytes(path);
+        HANDLE file = CreateFile2(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw FileException("Failed to open file", path);
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw FileException("Failed to read file size", path);
+        }
+        _fileHandle = file;
+        _size = static_cast<std::size_t>(fileSize.QuadPart);
+        if (_size == 0) {
+            return;
+        }
+
+        HANDLE mapping = CreateFileMappingFromApp(file, NULL, PAGE_READONLY, 0, NULL);
+        if (!mapping) {
+            CloseHandle(file);
+            throw FileException("Failed to map file", path);
+        }
+        void* view = MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+        if (!view) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw FileException("Failed to map file", path);
+        }
+        _mappingHandle = mapping;
+        _data = static_cast<const unsigned char*>(view);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw FileException("Failed to open file", path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw FileException("Failed to read file size", path);
+        }
+        _size = static_cast<std::size_t>(st.st_size);
+        if (_size > 0) {
+            void* addr = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+            if (addr == MAP_FAILED) {
+                ::close(fd);
+                throw FileException("Failed to map file", path);
+            }
+            // Access pattern is driven by the visible tiles, avoid reading ahead
+            ::madvise(addr, _size, MADV_RANDOM);
+            _data = static_cast<const unsigned char*>(addr);
+        }
+        ::close(fd); // NOTE: mapping stays valid after closing the descriptor
+#endif
+    }
+
+    MemoryMappedFile::~MemoryMappedFile() {
+#if defined(_WIN32)
+        if (_data) {
+            UnmapViewOfFile(_data);
+        }
+        if (_mappingHandle) {
+            CloseHandle(static_cast<HANDLE>(_mappingHandle));
+        }
+        if (_fileHandle) {
+            CloseHandle(static_cast<HANDLE>(_fileHandle));
+        }
+#else
+        if (_data) {
+            ::munmap(const_cast<unsigned char*>(_data), _size);
+        }
+#endif
+    }
+
+    const std::string& MemoryMappedFile::getPath() const {
+        return _path;
+    }
+
+    std::size_t MemoryMappedFile::size() const {
+        return _size;
+    }
+
+    const unsigned char* MemoryMappedFile::data() const {
+        return _data;
+    }
+
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_MEMORYMAPPEDFILE_H_
+#define _CARTO_MEMORYMAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace carto {
+
+    class MemoryMappedFile {
+    public:
+        explicit MemoryMappedFile(const std::string& path);
+        virtual ~MemoryMappedFile();
+
+        const std::string& getPath() const;
+
+        std::size_t size() const;
+        const unsigned char* data() const;
+
+    private:
+        MemoryMappedFile(const MemoryMappedFile&);
+        MemoryMappedFile& operator =(const MemoryMappedFile&);
+
+        std::string _path;
+        const unsigned char* _data;
+        std::size_t _size;
+        void* _fileHandle;
+        void* _mappingHandle;
+    };
+
+}
+
+#endif
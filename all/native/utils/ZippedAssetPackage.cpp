@@ -80,13 +80,26 @@ namespace carto {
             return std::shared_ptr<BinaryData>();
         }
     
+        // Stored assets can be used directly from the archive data
+        mz_zip_archive_file_stat stat;
+        if (mz_zip_reader_file_stat(zip, it->second, &stat) && stat.m_method == 0 && !(stat.m_bit_flag & 1) && stat.m_comp_size == stat.m_uncomp_size) {
+            std::size_t headerOffset = static_cast<std::size_t>(stat.m_local_header_ofs);
+            if (headerOffset + LOCAL_HEADER_SIZE <= _zipData->size()) {
+                const unsigned char* header = _zipData->data() + headerOffset;
+                std::size_t dataOffset = headerOffset + LOCAL_HEADER_SIZE + (header[26] | (header[27] << 8)) + (header[28] | (header[29] << 8));
+                if (header[0] == 'P' && header[1] == 'K' && dataOffset + stat.m_uncomp_size <= _zipData->size()) {
+                    return _zipData->slice(dataOffset, static_cast<std::size_t>(stat.m_uncomp_size));
+                }
+            }
+        }
+    
         std::size_t elementSize = 0;
         std::shared_ptr<unsigned char> elementData(static_cast<unsigned char*>(mz_zip_reader_extract_to_heap(zip, it->second, &elementSize, 0)), mz_free);
         if (!elementData) {
             Log::Error("ZippedAssetPackage::loadAsset: Could not load archive asset");
             return std::shared_ptr<BinaryData>();
         }
-        return std::make_shared<BinaryData>(elementData.get(), elementSize);
+        return std::make_shared<BinaryData>(elementData.get(), elementSize, elementData);
     }
 
     void ZippedAssetPackage::initialize() {
@@ -97,8 +110,7 @@ namespace carto {
         _handle = std::make_shared<mz_zip_archive>();
         mz_zip_archive* zip = static_cast<mz_zip_archive*>(_handle.get());
         memset(zip, 0, sizeof(mz_zip_archive));
-        std::shared_ptr<std::vector<unsigned char> > data = _zipData->getDataPtr();
-        if (!mz_zip_reader_init_mem(zip, data->data(), data->size(), 0)) {
+        if (!mz_zip_reader_init_mem(zip, _zipData->data(), _zipData->size(), 0)) {
             throw GenericException("Could not open ZIP archive");
         }
     
@@ -119,5 +131,7 @@ namespace carto {
         }
         _handle.reset();
     }
-    
+
+    const unsigned int ZippedAssetPackage::LOCAL_HEADER_SIZE = 30;
+
 }
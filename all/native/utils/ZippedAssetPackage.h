@@ -42,6 +42,8 @@ namespace carto {
         void initialize();
         void deinitialize();
 
+        static const unsigned int LOCAL_HEADER_SIZE;
+
         const std::shared_ptr<BinaryData> _zipData;
         const std::shared_ptr<AssetPackage> _baseAssetPackage;
         std::shared_ptr<void> _handle;
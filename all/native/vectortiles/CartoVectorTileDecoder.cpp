@@ -20,6 +20,7 @@
 #include "vectortiles/utils/GeometryConverter.h"
 #include "vectortiles/utils/ValueConverter.h"
 #include "vectortiles/utils/VTBitmapLoader.h"
+#include "vectortiles/utils/MBVTFeatureDecoderCache.h"
 #include "vectortiles/utils/CartoCSSAssetLoader.h"
 #include "utils/AssetPackage.h"
 #include "utils/FileUtils.h"
@@ -148,18 +149,7 @@ namespace carto {
         }
 
         try {
-            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder;
-            {
-                std::unique_lock<std::mutex> lock(_mutex);
-                if (_cachedFeatureDecoder.first != tileData) {
-                    lock.unlock();
-                    decoder = std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), _logger);
-                    lock.lock();
-                    _cachedFeatureDecoder = std::make_pair(tileData, decoder);
-                } else {
-                    decoder = _cachedFeatureDecoder.second;
-                }
-            }
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = MBVTFeatureDecoderCache::GetFeatureDecoder(tileData, _logger);
 
             std::string mvtLayerName;
             mvt::Feature mvtFeature;
@@ -202,18 +192,7 @@ namespace carto {
 
         std::vector<std::shared_ptr<VectorTileFeature> > tileFeatures;
         try {
-            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder;
-            {
-                std::unique_lock<std::mutex> lock(_mutex);
-                if (_cachedFeatureDecoder.first != tileData) {
-                    lock.unlock();
-                    decoder = std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), _logger);
-                    lock.lock();
-                    _cachedFeatureDecoder = std::make_pair(tileData, decoder);
-                } else {
-                    decoder = _cachedFeatureDecoder.second;
-                }
-            }
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = MBVTFeatureDecoderCache::GetFeatureDecoder(tileData, _logger);
 
             for (const std::string& mvtLayerName : decoder->getLayerNames()) {
                 for (std::shared_ptr<mvt::FeatureDecoder::FeatureIterator> mvtIt = decoder->createLayerFeatureIterator(mvtLayerName); mvtIt->valid(); mvtIt->advance()) {
@@ -265,9 +244,7 @@ namespace carto {
         }
     
         try {
-            mvt::MBVTFeatureDecoder decoder(*tileData->getDataPtr(), _logger);
-            decoder.setTransform(calculateTileTransform(tile, targetTile));
-            decoder.setGlobalIdOverride(true, MapTile(tile.x, tile.y, tile.zoom, 0).getTileId());
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = MBVTFeatureDecoderCache::GetTileDecoder(tileData, calculateTileTransform(tile, targetTile), true, MapTile(tile.x, tile.y, tile.zoom, 0).getTileId(), _logger);
 
             std::vector<std::shared_ptr<vt::Tile> > tiles(_layerIds.size());
             for (auto it = layerMaps.begin(); it != layerMaps.end(); it++) {
@@ -280,7 +257,7 @@ namespace carto {
                     continue;
                 }
 
-                mvt::MBVTTileReader reader(it->second, tileTransformer, *layerSymbolizerContexts[it->first], decoder);
+                mvt::MBVTTileReader reader(it->second, tileTransformer, *layerSymbolizerContexts[it->first], *decoder);
                 reader.setLayerNameOverride(it->first);
                 tiles[index] = reader.readTile(targetTile);
             }
@@ -21,7 +21,6 @@
 namespace carto {
     namespace mvt {
         class Map;
-        class MBVTFeatureDecoder;
         class SymbolizerContext;
         class Logger;
     }
@@ -109,8 +108,6 @@ namespace carto {
         std::map<std::string, std::shared_ptr<mvt::SymbolizerContext> > _layerSymbolizerContexts;
         std::map<std::shared_ptr<AssetPackage>, std::shared_ptr<mvt::SymbolizerContext> > _assetPackageSymbolizerContexts;
         std::shared_ptr<mvt::Map::Settings> _mapSettings;
-
-        mutable std::pair<std::shared_ptr<BinaryData>, std::shared_ptr<mvt::MBVTFeatureDecoder> > _cachedFeatureDecoder;
     
         mutable std::mutex _mutex;
     };
@@ -21,6 +21,7 @@
 #include "vectortiles/utils/ValueConverter.h"
 #include "vectortiles/utils/MapnikVTLogger.h"
 #include "vectortiles/utils/VTBitmapLoader.h"
+#include "vectortiles/utils/MBVTFeatureDecoderCache.h"
 #include "vectortiles/utils/CartoCSSAssetLoader.h"
 #include "utils/AssetPackage.h"
 #include "utils/FileUtils.h"
@@ -300,18 +301,7 @@ namespace carto {
         }
 
         try {
-            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder;
-            {
-                std::unique_lock<std::mutex> lock(_mutex);
-                if (_cachedFeatureDecoder.first != tileData) {
-                    lock.unlock();
-                    decoder = std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), _logger);
-                    lock.lock();
-                    _cachedFeatureDecoder = std::make_pair(tileData, decoder);
-                } else {
-                    decoder = _cachedFeatureDecoder.second;
-                }
-            }
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = MBVTFeatureDecoderCache::GetFeatureDecoder(tileData, _logger);
 
             std::string mvtLayerName;
             mvt::Feature mvtFeature;
@@ -354,18 +344,7 @@ namespace carto {
 
         std::vector<std::shared_ptr<VectorTileFeature> > tileFeatures;
         try {
-            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder;
-            {
-                std::unique_lock<std::mutex> lock(_mutex);
-                if (_cachedFeatureDecoder.first != tileData) {
-                    lock.unlock();
-                    decoder = std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), _logger);
-                    lock.lock();
-                    _cachedFeatureDecoder = std::make_pair(tileData, decoder);
-                } else {
-                    decoder = _cachedFeatureDecoder.second;
-                }
-            }
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = MBVTFeatureDecoderCache::GetFeatureDecoder(tileData, _logger);
 
             for (const std::string& mvtLayerName : decoder->getLayerNames()) {
                 for (std::shared_ptr<mvt::FeatureDecoder::FeatureIterator> mvtIt = decoder->createLayerFeatureIterator(mvtLayerName); mvtIt->valid(); mvtIt->advance()) {
@@ -419,11 +398,9 @@ namespace carto {
         }
     
         try {
-            mvt::MBVTFeatureDecoder decoder(*tileData->getDataPtr(), _logger);
-            decoder.setTransform(calculateTileTransform(tile, targetTile));
-            decoder.setGlobalIdOverride(featureIdOverride, MapTile(tile.x, tile.y, tile.zoom, 0).getTileId());
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = MBVTFeatureDecoderCache::GetTileDecoder(tileData, calculateTileTransform(tile, targetTile), featureIdOverride, MapTile(tile.x, tile.y, tile.zoom, 0).getTileId(), _logger);
             
-            mvt::MBVTTileReader reader(map, tileTransformer, *symbolizerContext, decoder);
+            mvt::MBVTTileReader reader(map, tileTransformer, *symbolizerContext, *decoder);
             reader.setLayerNameOverride(layerNameOverride);
 
             if (std::shared_ptr<vt::Tile> tile = reader.readTile(targetTile)) {
@@ -571,8 +548,6 @@ namespace carto {
         _map = map;
         _mapSettings = std::make_shared<mvt::Map::Settings>(_map->getSettings());
         _styleSet = styleSet;
-        _cachedFeatureDecoder.first.reset();
-        _cachedFeatureDecoder.second.reset();
     }
 
     const int MBVectorTileDecoder::DEFAULT_TILE_SIZE = 256;
@@ -22,7 +22,6 @@
 namespace carto {
     namespace mvt {
         class Map;
-        class MBVTFeatureDecoder;
         class SymbolizerContext;
         class Logger;
     }
@@ -166,8 +165,6 @@ namespace carto {
         std::shared_ptr<mvt::Map::Settings> _mapSettings;
         std::shared_ptr<mvt::SymbolizerContext> _symbolizerContext;
         std::map<std::pair<std::string, std::shared_ptr<AssetPackage> >, std::shared_ptr<mvt::SymbolizerContext> > _assetPackageSymbolizerContexts;
-
-        mutable std::pair<std::shared_ptr<BinaryData>, std::shared_ptr<mvt::MBVTFeatureDecoder> > _cachedFeatureDecoder;
     
         mutable std::mutex _mutex;
     };
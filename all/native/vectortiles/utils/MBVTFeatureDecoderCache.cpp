@@ -0,0 +1,182 @@
+#include "MBVTFeatureDecoderCache.h"
+#include "core/BinaryData.h"
+
+#include <cstdint>
+
+#include <mapnikvt/Logger.h>
+#include <mapnikvt/MBVTFeatureDecoder.h>
+
+namespace carto {
+
+    MBVTFeatureDecoderCache::~MBVTFeatureDecoderCache() {
+    }
+
+    std::size_t MBVTFeatureDecoderCache::GetCapacity() {
+        MBVTFeatureDecoderCache& cache = GetInstance();
+
+        std::lock_guard<std::mutex> lock(cache._mutex);
+        return cache._capacity;
+    }
+
+    void MBVTFeatureDecoderCache::SetCapacity(std::size_t capacityInBytes) {
+        MBVTFeatureDecoderCache& cache = GetInstance();
+
+        std::lock_guard<std::mutex> lock(cache._mutex);
+        cache._capacity = capacityInBytes;
+        cache.evictEntries();
+    }
+
+    std::shared_ptr<mvt::MBVTFeatureDecoder> MBVTFeatureDecoderCache::GetFeatureDecoder(const std::shared_ptr<BinaryData>& tileData, const std::shared_ptr<mvt::Logger>& logger) {
+        Settings settings;
+        settings.transformed = false;
+        settings.transform = cglib::mat3x3<float>::identity();
+        settings.globalIdOverride = false;
+        settings.tileId = -1;
+        return GetInstance().getDecoder(tileData, settings, logger);
+    }
+
+    std::shared_ptr<mvt::MBVTFeatureDecoder> MBVTFeatureDecoderCache::GetTileDecoder(const std::shared_ptr<BinaryData>& tileData, const cglib::mat3x3<float>& transform, bool globalIdOverride, long long tileId, const std::shared_ptr<mvt::Logger>& logger) {
+        Settings settings;
+        settings.transformed = true;
+        settings.transform = transform;
+        settings.globalIdOverride = globalIdOverride;
+        settings.tileId = tileId;
+        return GetInstance().getDecoder(tileData, settings, logger);
+    }
+
+    bool MBVTFeatureDecoderCache::Settings::operator ==(const Settings& settings) const {
+        if (transformed != settings.transformed || globalIdOverride != settings.globalIdOverride || tileId != settings.tileId) {
+            return false;
+        }
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                if (transform(i, j) != settings.transform(i, j)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    MBVTFeatureDecoderCache::MBVTFeatureDecoderCache() :
+        _entries(),
+        _entryMap(),
+        _tileDataEntryMap(),
+        _size(0),
+        _capacity(DEFAULT_CAPACITY),
+        _mutex()
+    {
+    }
+
+    std::shared_ptr<mvt::MBVTFeatureDecoder> MBVTFeatureDecoderCache::getDecoder(const std::shared_ptr<BinaryData>& tileData, const Settings& settings, const std::shared_ptr<mvt::Logger>& logger) {
+        // Try the identical data instance first, this avoids hashing the tile for repeated lookups
+        auto findTileDataEntry = [&, this]() -> std::shared_ptr<mvt::MBVTFeatureDecoder> {
+            auto range = _tileDataEntryMap.equal_range(tileData.get());
+            for (auto it = range.first; it != range.second; it++) {
+                const Entry& entry = *it->second;
+                if (entry.settings == settings) {
+                    _entries.splice(_entries.begin(), _entries, it->second);
+                    return entry.decoder;
+                }
+            }
+            return std::shared_ptr<mvt::MBVTFeatureDecoder>();
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = findTileDataEntry()) {
+                return decoder;
+            }
+        }
+
+        std::size_t hash = CalculateHash(*tileData);
+
+        auto findEntry = [&, this]() -> std::shared_ptr<mvt::MBVTFeatureDecoder> {
+            if (std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = findTileDataEntry()) {
+                return decoder;
+            }
+            auto range = _entryMap.equal_range(hash);
+            for (auto it = range.first; it != range.second; it++) {
+                const Entry& entry = *it->second;
+                if (entry.settings == settings && *entry.tileData == *tileData) {
+                    _entries.splice(_entries.begin(), _entries, it->second);
+                    return entry.decoder;
+                }
+            }
+            return std::shared_ptr<mvt::MBVTFeatureDecoder>();
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (std::shared_ptr<mvt::MBVTFeatureDecoder> decoder = findEntry()) {
+                return decoder;
+            }
+        }
+
+        // Parse the tile without holding the lock. The decoder is configured before it is published and never modified afterwards.
+        auto decoder = std::make_shared<mvt::MBVTFeatureDecoder>(*tileData->getDataPtr(), logger);
+        if (settings.transformed) {
+            decoder->setTransform(settings.transform);
+            decoder->setGlobalIdOverride(settings.globalIdOverride, settings.tileId);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (std::shared_ptr<mvt::MBVTFeatureDecoder> existingDecoder = findEntry()) {
+            return existingDecoder; // another thread decoded the same tile meanwhile
+        }
+
+        Entry entry;
+        entry.hash = hash;
+        entry.tileData = tileData;
+        entry.settings = settings;
+        entry.decoder = decoder;
+        entry.size = tileData->size() * DECODED_SIZE_FACTOR;
+        _entries.push_front(entry);
+        _entryMap.emplace(hash, _entries.begin());
+        _tileDataEntryMap.emplace(tileData.get(), _entries.begin());
+        _size += entry.size;
+        evictEntries();
+        return decoder;
+    }
+
+    void MBVTFeatureDecoderCache::evictEntries() {
+        while (_size > _capacity && !_entries.empty()) {
+            auto entryIt = std::prev(_entries.end());
+            auto range = _entryMap.equal_range(entryIt->hash);
+            for (auto it = range.first; it != range.second; it++) {
+                if (it->second == entryIt) {
+                    _entryMap.erase(it);
+                    break;
+                }
+            }
+            auto tileDataRange = _tileDataEntryMap.equal_range(entryIt->tileData.get());
+            for (auto it = tileDataRange.first; it != tileDataRange.second; it++) {
+                if (it->second == entryIt) {
+                    _tileDataEntryMap.erase(it);
+                    break;
+                }
+            }
+            _size -= entryIt->size;
+            _entries.erase(entryIt);
+        }
+    }
+
+    std::size_t MBVTFeatureDecoderCache::CalculateHash(const BinaryData& tileData) {
+        // FNV-1a over the raw bytes, computed in place without copying the tile
+        std::uint64_t hash = 14695981039346656037ULL;
+        const unsigned char* data = tileData.data();
+        for (std::size_t i = 0; i < tileData.size(); i++) {
+            hash = (hash ^ data[i]) * 1099511628211ULL;
+        }
+        return static_cast<std::size_t>(hash);
+    }
+
+    MBVTFeatureDecoderCache& MBVTFeatureDecoderCache::GetInstance() {
+        static MBVTFeatureDecoderCache cache;
+        return cache;
+    }
+
+    const std::size_t MBVTFeatureDecoderCache::DEFAULT_CAPACITY = 16 * 1024 * 1024;
+    const std::size_t MBVTFeatureDecoderCache::DECODED_SIZE_FACTOR = 4; // rough estimate of parsed tile size relative to the encoded size
+
+}
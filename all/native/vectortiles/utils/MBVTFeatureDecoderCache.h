@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2016 CartoDB. All rights reserved.
+ * Copying and using this code is allowed only according
+ * to license terms, as given in https://cartodb.com/terms/
+ */
+
+#ifndef _CARTO_MBVTFEATUREDECODERCACHE_H_
+#define _CARTO_MBVTFEATUREDECODERCACHE_H_
+
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <cglib/mat.h>
+
+namespace carto {
+    class BinaryData;
+    namespace mvt {
+        class Logger;
+        class MBVTFeatureDecoder;
+    }
+
+    /**
+     * Process-wide cache of parsed MBVT tiles. Decoders created from identical tile data and
+     * with identical settings are shared between all layers, decoders and services.
+     * The cached decoders must be treated as read-only, as they may be used concurrently.
+     */
+    class MBVTFeatureDecoderCache {
+    public:
+        virtual ~MBVTFeatureDecoderCache();
+
+        static std::size_t GetCapacity();
+        static void SetCapacity(std::size_t capacityInBytes);
+
+        static std::shared_ptr<mvt::MBVTFeatureDecoder> GetFeatureDecoder(const std::shared_ptr<BinaryData>& tileData, const std::shared_ptr<mvt::Logger>& logger);
+        static std::shared_ptr<mvt::MBVTFeatureDecoder> GetTileDecoder(const std::shared_ptr<BinaryData>& tileData, const cglib::mat3x3<float>& transform, bool globalIdOverride, long long tileId, const std::shared_ptr<mvt::Logger>& logger);
+
+    private:
+        struct Settings {
+            bool transformed;
+            cglib::mat3x3<float> transform;
+            bool globalIdOverride;
+            long long tileId;
+
+            bool operator ==(const Settings& settings) const;
+        };
+
+        struct Entry {
+            std::size_t hash;
+            std::shared_ptr<BinaryData> tileData;
+            Settings settings;
+            std::shared_ptr<mvt::MBVTFeatureDecoder> decoder;
+            std::size_t size;
+        };
+
+        MBVTFeatureDecoderCache();
+
+        std::shared_ptr<mvt::MBVTFeatureDecoder> getDecoder(const std::shared_ptr<BinaryData>& tileData, const Settings& settings, const std::shared_ptr<mvt::Logger>& logger);
+        void evictEntries();
+
+        static std::size_t CalculateHash(const BinaryData& tileData);
+
+        static MBVTFeatureDecoderCache& GetInstance();
+
+        static const std::size_t DEFAULT_CAPACITY;
+        static const std::size_t DECODED_SIZE_FACTOR;
+
+        std::list<Entry> _entries; // most recently used first
+        std::unordered_multimap<std::size_t, std::list<Entry>::iterator> _entryMap;
+        std::unordered_multimap<const BinaryData*, std::list<Entry>::iterator> _tileDataEntryMap;
+        std::size_t _size;
+        std::size_t _capacity;
+        std::mutex _mutex;
+    };
+
+}
+
+#endif
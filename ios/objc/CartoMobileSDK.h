@@ -155,6 +155,7 @@
 
 #ifdef _CARTO_OFFLINE_SUPPORT
 #import "NTMBTilesTileDataSource.h"
+#import "NTTileArchiveTileDataSource.h"
 #endif
 
 #ifdef _CARTO_PACKAGEMANAGER_SUPPORT
@@ -208,6 +209,9 @@
 #import "NTRoutingService.h"
 #import "NTRouteMatchingRequest.h"
 #import "NTRouteMatchingResult.h"
+#import "NTRouteMatchingSession.h"
+#import "NTRoutingMatrixRequest.h"
+#import "NTRoutingMatrixResult.h"
 #import "NTOSRMOfflineRoutingService.h"
 #import "NTSGREOfflineRoutingService.h"
 #import "NTCartoOnlineRoutingService.h"